@@ -10,14 +10,16 @@ int
 main(int argc, char** argv)
 {
   LogComponentEnable("HBMController", LOG_LEVEL_INFO);
+  LogComponentEnable("HBMChannel", LOG_LEVEL_INFO);
   LogComponentEnable("HBMBank", LOG_LEVEL_INFO);
 
   HBMHelper helper;
-  Ptr<HBMController> controller = helper.Create(4);
+  // 2 stacks x 4 channels x 4 banks
+  Ptr<HBMController> controller = helper.Create(2, 4, 4);
 
-  controller->SendRequest(1, 0x1000, 128, 1, true, [](void* p){}, nullptr);
-  controller->SendRequest(2, 0x1000, 256, 1, false, [](void* p){}, nullptr);
-  controller->SendRequest(3, 0x2000, 64, 2, true, [](void* p){}, nullptr);
+  controller->SendRequest(1, 0x1000, 128, true, nullptr);
+  controller->SendRequest(2, 0x1000, 256, false, nullptr);
+  controller->SendRequest(3, 0x2000, 1024, true, nullptr);
 
   Simulator::Run();
   Simulator::Destroy();
@@ -33,7 +33,7 @@ void CheckExampleProcess()
     oss << "[" << std::put_time(&tm_buf, "%H:%M:%S") << "] "
         << "Simulation time progress: " << std::setprecision(precision) << val << unit;
     std::cout << "\r" << oss.str() << std::flush;
-    if (!UbTrafficGen::Get()->IsCompleted()) {
+    if (!UbTrafficGen::Get()->IsCompleted() || !UbUtils::Get()->IsMemTraceReplayCompleted()) {
             Simulator::Schedule(MicroSeconds(100), &CheckExampleProcess);
             return;
     }
@@ -59,6 +59,7 @@ void RunCase(const string& configPath)
     string TpConfigFile = configPath + "/transport_channel.csv";
     TpConnectionManager retConnectionManager = UbUtils::Get()->CreateTp(TpConfigFile);
     UbUtils::Get()->TopoTraceConnect();
+    UbUtils::Get()->InitFcMonitor();
     string TrafficConfigFile = configPath + "/traffic.csv";
     auto trafficData = UbUtils::Get()->ReadTrafficCSV(TrafficConfigFile);
 
@@ -82,6 +83,7 @@ void RunCase(const string& configPath)
         client->GetTpnConn(retConnectionManager.GetConnectionManagerByNode(record.sourceNode));
     }
     UbTrafficGen::Get()->ScheduleNextTasks();
+    UbUtils::Get()->InitMemTraceReplay(configPath);
     CheckExampleProcess();
 }
 
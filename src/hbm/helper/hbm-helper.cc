@@ -11,6 +11,22 @@ HBMHelper::HBMHelper()
 {
 }
 
+Ptr<HBMController>
+HBMHelper::Create()
+{
+  Ptr<HBMController> ctrl = CreateObject<HBMController>();
+  ctrl->InitializeChannels();
+  return ctrl;
+}
+
+Ptr<HBMController>
+HBMHelper::Create(uint32_t numStacks, uint32_t channelsPerStack, uint32_t banksPerChannel)
+{
+  Ptr<HBMController> ctrl = CreateObject<HBMController>();
+  ctrl->InitializeChannels(numStacks, channelsPerStack, banksPerChannel);
+  return ctrl;
+}
+
 Ptr<HBMController>
 HBMHelper::Create(uint32_t numBanks)
 {
@@ -13,7 +13,11 @@ class HBMHelper
 public:
   HBMHelper();
 
+  // Hierarchy taken from the ns3::HBMController attributes
+  Ptr<HBMController> Create();
+  // Single stack, single channel with numBanks banks
   Ptr<HBMController> Create(uint32_t numBanks);
+  Ptr<HBMController> Create(uint32_t numStacks, uint32_t channelsPerStack, uint32_t banksPerChannel);
 
 private:
   uint32_t m_defaultBanks;
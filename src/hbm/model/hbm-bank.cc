@@ -1,6 +1,7 @@
 #include "hbm-bank.h"
 #include "ns3/simulator.h"
 #include "ns3/uinteger.h"
+#include "ns3/enum.h"
 
 
 namespace ns3 {
@@ -16,10 +17,30 @@ TypeId HBMBank::GetTypeId(void)
       .SetGroupName("HBM")
       .AddConstructor<HBMBank>()
       .AddAttribute("ProcessDelay",
-        "Delay (in nanoseconds) to process a request.",
+        "Delay (in nanoseconds) of a row access that activates the row, CasDelay included.",
         TimeValue(NanoSeconds(50)),
         MakeTimeAccessor(&HBMBank::m_processDelay),
-        MakeTimeChecker());
+        MakeTimeChecker())
+      .AddAttribute("CasDelay",
+        "Column access part of ProcessDelay, the whole cost of a row hit.",
+        TimeValue(NanoSeconds(14)),
+        MakeTimeAccessor(&HBMBank::m_casDelay),
+        MakeTimeChecker())
+      .AddAttribute("RowSize",
+        "Size of a row (in bytes of the bank address space).",
+        UintegerValue(1024),
+        MakeUintegerAccessor(&HBMBank::m_rowSize),
+        MakeUintegerChecker<uint32_t>(1))
+      .AddAttribute("PagePolicy",
+        "Closed activates the row for every access, Open keeps the last row open.",
+        EnumValue(PagePolicy::CLOSED),
+        MakeEnumAccessor<PagePolicy>(&HBMBank::m_pagePolicy),
+        MakeEnumChecker(PagePolicy::CLOSED, "Closed",
+                        PagePolicy::OPEN, "Open"))
+      .AddTraceSource("QueueLength",
+        "Number of requests waiting or in service at the bank.",
+        MakeTraceSourceAccessor(&HBMBank::m_queueLength),
+        "ns3::TracedValueCallback::Uint32");
   return tid;
 }
 
@@ -35,40 +56,94 @@ HBMBank::~HBMBank()
 }
 
 void
-HBMBank::ReceiveRequest(MemoryRequest request)
+HBMBank::SetAccessDoneCallback(Callback<void, MemoryRequest*> cb)
 {
-  NS_LOG_FUNCTION(this << request.requestId);
+  m_accessDone = cb;
+}
+
+void
+HBMBank::ReceiveRequest(MemoryRequest* request)
+{
+  NS_LOG_FUNCTION(this << request->requestId);
 
+  uint32_t queueLength = request_q.Size() + (m_busy ? 1 : 0);
+  if (queueLength >= m_queueLengthHist.size())
+    {
+      m_queueLengthHist.resize(queueLength + 1, 0);
+    }
+  m_queueLengthHist[queueLength]++;
+  m_queueLength = queueLength + 1;
+  request_q.Push(request);
   if (!m_busy)
     {
-      uint32_t bus_delay = request.size / HBM_BUS_BANK_BANDWIDTH;
-      m_busy = true;
-      m_processEvent = Simulator::Schedule(m_processDelay + NanoSeconds(bus_delay),
-                                           &HBMBank::FinishProcessing,
-                                           this, request);
+      ProcessNext();
     }
   else
     {
-      request_q.push(request);
-      NS_LOG_INFO("Request " << request.requestId << " queued at " << Simulator::Now().GetNanoSeconds() << " ns");
-      NS_LOG_INFO("Congestion at Bank " << request.bankId << ", Queue length " << request_q.size() );
+      NS_LOG_INFO("Request " << request->requestId << " queued at " << Simulator::Now().GetNanoSeconds() << " ns");
+      NS_LOG_INFO("Congestion at Bank " << request->bankId << ", Queue length " << request_q.Size() );
+    }
+}
+
+void
+HBMBank::ProcessNext()
+{
+  if (request_q.Empty())
+    {
+      m_busy = false;
+      return;
     }
+  MemoryRequest* request = request_q.Pop();
+  m_busy = true;
+  int64_t row = request->bankAddress / m_rowSize;
+  request->rowHit = m_pagePolicy == PagePolicy::OPEN && row == m_openRow;
+  m_openRow = m_pagePolicy == PagePolicy::OPEN ? row : -1;
+  // The bank only spends the row access time here, the data transfer is
+  // serialized on the channel bus
+  Time delay = request->rowHit ? m_casDelay : m_processDelay;
+  request->activateTime = delay - Min(m_casDelay, delay);
+  request->serviceStart = Simulator::Now();
+  m_busyTime += delay;
+  m_accesses++;
+  m_rowHits += request->rowHit ? 1 : 0;
+  m_processEvent = Simulator::Schedule(delay,
+                                       &HBMBank::FinishProcessing,
+                                       this, request);
 }
 
 void
-HBMBank::FinishProcessing(MemoryRequest request)
+HBMBank::FinishProcessing(MemoryRequest* request)
 {
-  NS_LOG_INFO("HBM Bank " << request.bankId << " processed request " << request.requestId
+  NS_LOG_INFO("HBM Bank " << request->bankId << " processed request " << request->requestId
               << " at " << Simulator::Now().GetNanoSeconds() << " ns");
-  m_busy = false;
-  request.cb(request.arg);
-  if (!request_q.empty()) {
-    MemoryRequest next_request = request_q.front();
-    request_q.pop();
-    uint32_t bus_delay = request.size / HBM_BUS_BANK_BANDWIDTH;
-    Simulator::Schedule(m_processDelay + NanoSeconds(bus_delay), &HBMBank::FinishProcessing, this, next_request);
-  }
-  	
+  m_queueLength = request_q.Size();
+  request->accessDone = Simulator::Now();
+  m_accessDone(request);
+  ProcessNext();
+}
+
+Time
+HBMBank::GetBusyTime() const
+{
+  return m_busyTime;
+}
+
+uint64_t
+HBMBank::GetAccesses() const
+{
+  return m_accesses;
+}
+
+uint64_t
+HBMBank::GetRowHits() const
+{
+  return m_rowHits;
+}
+
+const std::vector<uint64_t> &
+HBMBank::GetQueueLengthHistogram() const
+{
+  return m_queueLengthHist;
 }
 
 } // namespace ns3
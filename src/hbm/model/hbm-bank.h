@@ -15,38 +15,62 @@
 #include "ns3/log.h"
 #include "ns3/nstime.h"
 #include "ns3/callback.h"
-#include <queue>
+#include "ns3/traced-value.h"
+#include "hbm-request.h"
+#include <vector>
 
 namespace ns3 {
 
-struct MemoryRequest {
-    uint64_t address;  // Memory address for the request
-    uint32_t size;     // Size of the request (in bytes)  
-    uint32_t bankId;   // The bank that the request is intended for
-    bool isWrite;// Whether it's a write request or a read request
-    uint32_t requestId; // An unused field
-    Callback<void, void*> cb; // Callback function used to notify the receiver
-    void* arg; // argument for the Callback func
-};
-
+/**
+ * A bank serves its requests in order. A row access takes ProcessDelay, of
+ * which CasDelay is the column access. With the Open page policy the row
+ * stays open after an access and a following access to the same row only
+ * pays CasDelay; the Closed policy activates the row for every access.
+ */
 class HBMBank : public Object
 {
 public:
+  enum class PagePolicy {
+    CLOSED,
+    OPEN
+  };
+
   static TypeId GetTypeId(void);
 
   HBMBank();
   virtual ~HBMBank();
 
-  void ReceiveRequest(MemoryRequest request);
+  void ReceiveRequest(MemoryRequest* request);
   void ProcessNext();
 
+  // Called when the row access of a request is done, the owning channel then
+  // moves the data over its bus
+  void SetAccessDoneCallback(Callback<void, MemoryRequest*> cb);
+
+  Time GetBusyTime() const;
+  uint64_t GetAccesses() const;
+  uint64_t GetRowHits() const;
+  // Number of arrivals that found n requests (waiting or in service) at the bank
+  const std::vector<uint64_t> &GetQueueLengthHistogram() const;
+
 private:
-  std::queue <MemoryRequest> request_q;
+  MemoryRequestQueue request_q;
   bool m_busy;
   EventId m_processEvent;
   Time m_processDelay;
+  Time m_casDelay;
+  uint32_t m_rowSize;
+  PagePolicy m_pagePolicy;
+  int64_t m_openRow = -1;
+  Callback<void, MemoryRequest*> m_accessDone;
+
+  Time m_busyTime;
+  uint64_t m_accesses = 0;
+  uint64_t m_rowHits = 0;
+  std::vector<uint64_t> m_queueLengthHist;
+  TracedValue<uint32_t> m_queueLength;
 
-  void FinishProcessing(MemoryRequest request);
+  void FinishProcessing(MemoryRequest* request);
 };
 
 } // namespace ns3
@@ -0,0 +1,313 @@
+#include "hbm-cache.h"
+#include "hbm-controller.h"
+#include "ns3/simulator.h"
+#include "ns3/uinteger.h"
+#include "ns3/enum.h"
+#include "ns3/log.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE("HBMCache");
+NS_OBJECT_ENSURE_REGISTERED(HBMCache);
+
+TypeId HBMCache::GetTypeId(void)
+{
+  static TypeId tid =
+    TypeId("ns3::HBMCache")
+      .SetParent<Object>()
+      .SetGroupName("HBM")
+      .AddConstructor<HBMCache>()
+      .AddAttribute("Size",
+        "Capacity of the cache (in bytes).",
+        UintegerValue(1 << 20),
+        MakeUintegerAccessor(&HBMCache::m_size),
+        MakeUintegerChecker<uint32_t>(1))
+      .AddAttribute("LineSize",
+        "Size of a cache line (in bytes).",
+        UintegerValue(64),
+        MakeUintegerAccessor(&HBMCache::m_lineSize),
+        MakeUintegerChecker<uint32_t>(1))
+      .AddAttribute("Ways",
+        "Associativity of the cache.",
+        UintegerValue(8),
+        MakeUintegerAccessor(&HBMCache::m_ways),
+        MakeUintegerChecker<uint32_t>(1))
+      .AddAttribute("HitLatency",
+        "Latency of a cache hit.",
+        TimeValue(NanoSeconds(5)),
+        MakeTimeAccessor(&HBMCache::m_hitLatency),
+        MakeTimeChecker())
+      .AddAttribute("Replacement",
+        "Victim selection inside a set.",
+        EnumValue(Replacement::LRU),
+        MakeEnumAccessor<Replacement>(&HBMCache::m_replacement),
+        MakeEnumChecker(Replacement::LRU, "Lru",
+                        Replacement::RANDOM, "Random"))
+      .AddAttribute("WritePolicy",
+        "WriteBack (write-allocate) or WriteThrough (no-write-allocate).",
+        EnumValue(WritePolicy::WRITE_BACK),
+        MakeEnumAccessor<WritePolicy>(&HBMCache::m_writePolicy),
+        MakeEnumChecker(WritePolicy::WRITE_BACK, "WriteBack",
+                        WritePolicy::WRITE_THROUGH, "WriteThrough"))
+      .AddAttribute("MshrNum",
+        "Number of outstanding line fills (miss status holding registers).",
+        UintegerValue(16),
+        MakeUintegerAccessor(&HBMCache::m_mshrNum),
+        MakeUintegerChecker<uint32_t>(1))
+      .AddTraceSource("Hit",
+        "A line access hits in the cache.",
+        MakeTraceSourceAccessor(&HBMCache::m_traceHit),
+        "ns3::HBMCache::AccessTracedCallback")
+      .AddTraceSource("Miss",
+        "A line access misses in the cache.",
+        MakeTraceSourceAccessor(&HBMCache::m_traceMiss),
+        "ns3::HBMCache::AccessTracedCallback")
+      .AddTraceSource("MshrMerge",
+        "A miss is merged into the MSHR of a line already being filled.",
+        MakeTraceSourceAccessor(&HBMCache::m_traceMshrMerge),
+        "ns3::HBMCache::AccessTracedCallback");
+  return tid;
+}
+
+HBMCache::HBMCache()
+{
+  NS_LOG_FUNCTION(this);
+  m_random = CreateObject<UniformRandomVariable>();
+}
+
+HBMCache::~HBMCache()
+{
+  NS_LOG_FUNCTION(this);
+}
+
+void
+HBMCache::DoDispose()
+{
+  m_controller = nullptr;
+  m_lines.clear();
+  m_mshrs.clear();
+  m_random = nullptr;
+  Object::DoDispose();
+}
+
+void
+HBMCache::SetController(Ptr<HBMController> controller)
+{
+  m_controller = controller;
+  m_numSets = m_size / (m_lineSize * m_ways);
+  NS_ASSERT_MSG(m_numSets > 0, "HBMCache Size must hold at least one set of " << m_ways << " lines");
+  m_lines.assign(static_cast<size_t>(m_numSets) * m_ways, Line());
+}
+
+uint64_t
+HBMCache::GetHits() const
+{
+  return m_hits;
+}
+
+uint64_t
+HBMCache::GetMisses() const
+{
+  return m_misses;
+}
+
+uint64_t
+HBMCache::GetMshrMerges() const
+{
+  return m_mshrMerges;
+}
+
+uint64_t
+HBMCache::GetWritebacks() const
+{
+  return m_writebacks;
+}
+
+void
+HBMCache::SendRequest(uint64_t requestId, uint64_t address, uint32_t size, bool isWrite, HBMClient* client)
+{
+  NS_LOG_FUNCTION(this << requestId);
+  NS_ASSERT_MSG(m_controller != nullptr, "HBMCache has no backing HBMController");
+
+  uint64_t first = address / m_lineSize;
+  uint64_t last = (address + (size == 0 ? 1 : size) - 1) / m_lineSize;
+  uint32_t accessId = m_accesses.Alloc();
+  PendingAccess &access = m_accesses[accessId];
+  access.remaining = last - first + 1;
+  access.client = client;
+  access.requestId = requestId;
+  for (uint64_t lineAddr = first; lineAddr <= last; lineAddr++)
+    {
+      AccessLine(lineAddr, isWrite, accessId);
+    }
+}
+
+void
+HBMCache::HBMAccessDone(uint64_t requestId)
+{
+  if (requestId & 1)
+    {
+      CompleteLine(requestId >> 1);
+    }
+  else
+    {
+      OnFill(requestId >> 1);
+    }
+}
+
+HBMCache::Line*
+HBMCache::Lookup(uint64_t lineAddr)
+{
+  Line* set = &m_lines[(lineAddr % m_numSets) * m_ways];
+  uint64_t tag = lineAddr / m_numSets;
+  for (uint32_t way = 0; way < m_ways; way++)
+    {
+      if (set[way].valid && set[way].tag == tag)
+        {
+          return &set[way];
+        }
+    }
+  return nullptr;
+}
+
+HBMCache::Line*
+HBMCache::Allocate(uint64_t lineAddr)
+{
+  Line* set = &m_lines[(lineAddr % m_numSets) * m_ways];
+  Line* victim = nullptr;
+  for (uint32_t way = 0; way < m_ways && victim == nullptr; way++)
+    {
+      if (!set[way].valid)
+        {
+          victim = &set[way];
+        }
+    }
+  if (victim == nullptr && m_replacement == Replacement::RANDOM)
+    {
+      victim = &set[m_random->GetInteger(0, m_ways - 1)];
+    }
+  if (victim == nullptr)
+    {
+      victim = &set[0];
+      for (uint32_t way = 1; way < m_ways; way++)
+        {
+          if (set[way].lastUse < victim->lastUse)
+            {
+              victim = &set[way];
+            }
+        }
+    }
+  if (victim->valid && victim->dirty)
+    {
+      uint64_t victimAddr = (victim->tag * m_numSets + lineAddr % m_numSets) * m_lineSize;
+      m_writebacks++;
+      m_controller->SendRequest(0, victimAddr, m_lineSize, true, nullptr);
+    }
+  victim->tag = lineAddr / m_numSets;
+  victim->valid = true;
+  victim->dirty = false;
+  victim->lastUse = ++m_useClock;
+  return victim;
+}
+
+void
+HBMCache::AccessLine(uint64_t lineAddr, bool isWrite, uint32_t accessId)
+{
+  Line* line = Lookup(lineAddr);
+  if (line == nullptr)
+    {
+      m_misses++;
+      m_traceMiss(lineAddr * m_lineSize, isWrite);
+      HandleMiss(lineAddr, isWrite, accessId);
+      return;
+    }
+  m_hits++;
+  m_traceHit(lineAddr * m_lineSize, isWrite);
+  line->lastUse = ++m_useClock;
+  if (isWrite && m_writePolicy == WritePolicy::WRITE_THROUGH)
+    {
+      m_controller->SendRequest(WriteThroughRequestId(accessId), lineAddr * m_lineSize, m_lineSize, true, this);
+      return;
+    }
+  line->dirty |= isWrite;
+  Simulator::Schedule(m_hitLatency, &HBMCache::CompleteLine, this, accessId);
+}
+
+void
+HBMCache::HandleMiss(uint64_t lineAddr, bool isWrite, uint32_t accessId)
+{
+  if (isWrite && m_writePolicy == WritePolicy::WRITE_THROUGH)
+    {
+      // no-write-allocate
+      m_controller->SendRequest(WriteThroughRequestId(accessId), lineAddr * m_lineSize, m_lineSize, true, this);
+      return;
+    }
+  auto it = m_mshrs.find(lineAddr);
+  if (it != m_mshrs.end())
+    {
+      m_mshrMerges++;
+      m_traceMshrMerge(lineAddr * m_lineSize, isWrite);
+      it->second.waiters.push_back({isWrite, accessId});
+      return;
+    }
+  if (m_mshrs.size() >= m_mshrNum)
+    {
+      m_stalled.push({lineAddr, {isWrite, accessId}});
+      return;
+    }
+  Mshr &mshr = m_mshrs[lineAddr];
+  mshr.lineAddr = lineAddr;
+  mshr.waiters.push_back({isWrite, accessId});
+  m_controller->SendRequest(FillRequestId(lineAddr), lineAddr * m_lineSize, m_lineSize, false, this);
+}
+
+void
+HBMCache::OnFill(uint64_t lineAddr)
+{
+  auto it = m_mshrs.find(lineAddr);
+  NS_ASSERT_MSG(it != m_mshrs.end(), "HBMCache fill without MSHR");
+  std::vector<Waiter> waiters = std::move(it->second.waiters);
+  m_mshrs.erase(it);
+  NS_LOG_INFO("HBMCache filled line 0x" << std::hex << lineAddr * m_lineSize << std::dec
+              << " for " << waiters.size() << " accesses");
+  Line* line = Allocate(lineAddr);
+  for (auto &waiter : waiters)
+    {
+      line->dirty |= waiter.isWrite;
+      CompleteLine(waiter.accessId);
+    }
+  while (!m_stalled.empty() && m_mshrs.size() < m_mshrNum)
+    {
+      StalledMiss miss = m_stalled.front();
+      m_stalled.pop();
+      Line* filled = Lookup(miss.lineAddr);
+      if (filled != nullptr && !(miss.waiter.isWrite && m_writePolicy == WritePolicy::WRITE_THROUGH))
+        {
+          // Filled while waiting for an MSHR, already counted as a miss
+          filled->lastUse = ++m_useClock;
+          filled->dirty |= miss.waiter.isWrite;
+          Simulator::Schedule(m_hitLatency, &HBMCache::CompleteLine, this, miss.waiter.accessId);
+          continue;
+        }
+      HandleMiss(miss.lineAddr, miss.waiter.isWrite, miss.waiter.accessId);
+    }
+}
+
+void
+HBMCache::CompleteLine(uint32_t accessId)
+{
+  PendingAccess &access = m_accesses[accessId];
+  if (--access.remaining > 0)
+    {
+      return;
+    }
+  HBMClient* client = access.client;
+  uint64_t requestId = access.requestId;
+  m_accesses.Free(accessId);
+  if (client != nullptr)
+    {
+      client->HBMAccessDone(requestId);
+    }
+}
+
+} // namespace ns3
@@ -0,0 +1,132 @@
+#ifndef HBM_CACHE_H
+#define HBM_CACHE_H
+
+#include "ns3/object.h"
+#include "ns3/ptr.h"
+#include "ns3/nstime.h"
+#include "ns3/traced-callback.h"
+#include "ns3/random-variable-stream.h"
+#include "hbm-request.h"
+#include <map>
+#include <queue>
+#include <vector>
+
+namespace ns3 {
+
+class HBMController;
+
+/**
+ * Memory-side SRAM cache in front of an HBMController.
+ *
+ * Set-associative with LRU or random replacement. Write-back caches allocate
+ * on write misses and write dirty victims back to HBM; write-through caches
+ * forward every write to HBM and do not allocate on write misses. Misses to a
+ * line already being filled merge into its MSHR; when all MSHRs are busy new
+ * misses wait until one is released.
+ */
+class HBMCache : public Object, public HBMClient
+{
+public:
+  enum class Replacement {
+    LRU,
+    RANDOM
+  };
+  enum class WritePolicy {
+    WRITE_BACK,
+    WRITE_THROUGH
+  };
+
+  static TypeId GetTypeId(void);
+
+  HBMCache();
+  virtual ~HBMCache();
+
+  // Attach the backing memory, the cache geometry is fixed from here on
+  void SetController(Ptr<HBMController> controller);
+
+  // Same contract as HBMController::SendRequest
+  void SendRequest(uint64_t requestId, uint64_t address, uint32_t size, bool isWrite, HBMClient* client);
+
+  // Completion of a line fill or a write-through from the controller
+  void HBMAccessDone(uint64_t requestId) override;
+
+  uint64_t GetHits() const;
+  uint64_t GetMisses() const;
+  uint64_t GetMshrMerges() const;
+  uint64_t GetWritebacks() const;
+
+  typedef void (*AccessTracedCallback)(uint64_t address, bool isWrite);
+
+private:
+  struct Line {
+    uint64_t tag = 0;
+    bool valid = false;
+    bool dirty = false;
+    uint64_t lastUse = 0;
+  };
+  struct PendingAccess {
+    uint32_t remaining = 0;
+    HBMClient* client = nullptr;
+    uint64_t requestId = 0;
+  };
+  struct Waiter {
+    bool isWrite;
+    uint32_t accessId;
+  };
+  struct Mshr {
+    uint64_t lineAddr;
+    std::vector<Waiter> waiters;
+  };
+  struct StalledMiss {
+    uint64_t lineAddr;
+    Waiter waiter;
+  };
+
+  void DoDispose() override;
+  void AccessLine(uint64_t lineAddr, bool isWrite, uint32_t accessId);
+  void HandleMiss(uint64_t lineAddr, bool isWrite, uint32_t accessId);
+  Line* Lookup(uint64_t lineAddr);
+  Line* Allocate(uint64_t lineAddr);
+  void OnFill(uint64_t lineAddr);
+  void CompleteLine(uint32_t accessId);
+
+  // Requests to the controller: fills carry the line address, write-throughs the access slot
+  static uint64_t FillRequestId(uint64_t lineAddr)
+  {
+    return lineAddr << 1;
+  }
+  static uint64_t WriteThroughRequestId(uint32_t accessId)
+  {
+    return (static_cast<uint64_t>(accessId) << 1) | 1;
+  }
+
+  Ptr<HBMController> m_controller;
+  uint32_t m_size;
+  uint32_t m_lineSize;
+  uint32_t m_ways;
+  Time m_hitLatency;
+  Replacement m_replacement;
+  WritePolicy m_writePolicy;
+  uint32_t m_mshrNum;
+
+  uint32_t m_numSets = 0;
+  std::vector<Line> m_lines;                  // m_numSets * m_ways, set-major
+  std::map<uint64_t, Mshr> m_mshrs;           // line address -> outstanding fill
+  std::queue<StalledMiss> m_stalled;          // misses waiting for a free MSHR
+  HBMPool<PendingAccess> m_accesses;
+  uint64_t m_useClock = 0;
+  Ptr<UniformRandomVariable> m_random;
+
+  uint64_t m_hits = 0;
+  uint64_t m_misses = 0;
+  uint64_t m_mshrMerges = 0;
+  uint64_t m_writebacks = 0;
+
+  TracedCallback<uint64_t, bool> m_traceHit;
+  TracedCallback<uint64_t, bool> m_traceMiss;
+  TracedCallback<uint64_t, bool> m_traceMshrMerge;
+};
+
+} // namespace ns3
+
+#endif // HBM_CACHE_H
@@ -0,0 +1,280 @@
+#include "hbm-channel.h"
+#include "ns3/simulator.h"
+#include "ns3/uinteger.h"
+#include "ns3/log.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE("HBMChannel");
+NS_OBJECT_ENSURE_REGISTERED(HBMChannel);
+
+TypeId HBMChannel::GetTypeId(void)
+{
+  static TypeId tid =
+    TypeId("ns3::HBMChannel")
+      .SetParent<Object>()
+      .SetGroupName("HBM")
+      .AddConstructor<HBMChannel>()
+      .AddAttribute("BusBandwidth",
+        "Data bus bandwidth of the channel (in bytes per nanosecond).",
+        UintegerValue(HBM_BUS_BANDWIDTH),
+        MakeUintegerAccessor(&HBMChannel::m_busBandwidth),
+        MakeUintegerChecker<uint32_t>(1))
+      .AddAttribute("WriteHighWatermark",
+        "Number of buffered writes that starts a write drain while reads are pending.",
+        UintegerValue(32),
+        MakeUintegerAccessor(&HBMChannel::m_writeHighWatermark),
+        MakeUintegerChecker<uint32_t>(1))
+      .AddAttribute("WriteLowWatermark",
+        "A write drain stops issuing writes once this many are left in the buffer.",
+        UintegerValue(8),
+        MakeUintegerAccessor(&HBMChannel::m_writeLowWatermark),
+        MakeUintegerChecker<uint32_t>())
+      .AddAttribute("WriteMaxAge",
+        "A buffered write that has waited this long is issued even while reads are pending.",
+        TimeValue(MicroSeconds(1)),
+        MakeTimeAccessor(&HBMChannel::m_writeMaxAge),
+        MakeTimeChecker())
+      .AddAttribute("WriteToReadDelay",
+        "Bus turnaround from a write to a read (tWTR).",
+        TimeValue(NanoSeconds(8)),
+        MakeTimeAccessor(&HBMChannel::m_writeToReadDelay),
+        MakeTimeChecker())
+      .AddAttribute("ReadToWriteDelay",
+        "Bus turnaround from a read to a write (tRTW).",
+        TimeValue(NanoSeconds(4)),
+        MakeTimeAccessor(&HBMChannel::m_readToWriteDelay),
+        MakeTimeChecker());
+  return tid;
+}
+
+HBMChannel::HBMChannel()
+  : m_busFreeAt(Time(0))
+{
+  NS_LOG_FUNCTION(this);
+}
+
+HBMChannel::~HBMChannel()
+{
+  NS_LOG_FUNCTION(this);
+}
+
+void
+HBMChannel::DoDispose()
+{
+  m_writeAgeEvent.Cancel();
+  m_banks.clear();
+  Object::DoDispose();
+}
+
+void
+HBMChannel::InitializeBanks(uint32_t numBanks)
+{
+  NS_LOG_FUNCTION(this << numBanks);
+
+  m_banks.clear();
+  for (uint32_t i = 0; i < numBanks; i++)
+    {
+      Ptr<HBMBank> bank = CreateObject<HBMBank>();
+      bank->SetAccessDoneCallback(MakeCallback(&HBMChannel::TransferData, this));
+      m_banks.push_back(bank);
+    }
+}
+
+void
+HBMChannel::SetTransferDoneCallback(Callback<void, MemoryRequest*> cb)
+{
+  m_transferDone = cb;
+}
+
+Ptr<HBMBank>
+HBMChannel::GetBank(uint32_t bankId) const
+{
+  return m_banks.at(bankId);
+}
+
+uint32_t
+HBMChannel::GetNBanks() const
+{
+  return m_banks.size();
+}
+
+uint32_t
+HBMChannel::GetBusBandwidth() const
+{
+  return m_busBandwidth;
+}
+
+uint64_t
+HBMChannel::GetTurnarounds() const
+{
+  return m_turnarounds;
+}
+
+uint64_t
+HBMChannel::GetWriteDrains() const
+{
+  return m_writeDrains;
+}
+
+uint64_t
+HBMChannel::GetMergedWrites() const
+{
+  return m_mergedWrites;
+}
+
+uint64_t
+HBMChannel::GetForwardedReads() const
+{
+  return m_forwardedReads;
+}
+
+void
+HBMChannel::ReceiveRequest(MemoryRequest* request)
+{
+  NS_LOG_FUNCTION(this << request->requestId);
+  NS_ASSERT_MSG(request->bankId < m_banks.size(), "Attempt to access bank " << request->bankId
+                << " but the channel has only " << m_banks.size() << " banks");
+  // Queueing in the write buffer or behind a write drain counts as queue delay
+  request->arrival = Simulator::Now();
+  bool buffered = m_bufferedWrites.count(request->address) > 0;
+  if (request->isWrite)
+    {
+      if (buffered)
+        {
+          m_mergedWrites++;
+          ServeFromBuffer(request);
+          return;
+        }
+      m_writeQ.Push(request);
+      m_bufferedWrites.insert(request->address);
+    }
+  else
+    {
+      if (buffered)
+        {
+          m_forwardedReads++;
+          ServeFromBuffer(request);
+          return;
+        }
+      if (m_writeMode && m_writesInFlight > 0)
+        {
+          m_readQ.Push(request);
+        }
+      else
+        {
+          // A completion callback may issue the read before Schedule has
+          // left write mode, so reads parked during the drain go first
+          m_writeMode = false;
+          while (!m_readQ.Empty())
+            {
+              IssueToBank(m_readQ.Pop());
+            }
+          IssueToBank(request);
+        }
+    }
+  Schedule();
+}
+
+bool
+HBMChannel::IsOverAge(const MemoryRequest* request) const
+{
+  return Simulator::Now() - request->arrival >= m_writeMaxAge;
+}
+
+void
+HBMChannel::Schedule()
+{
+  bool readsPending = m_readsInFlight > 0 || !m_readQ.Empty();
+  if (!m_writeMode && !m_writeQ.Empty())
+    {
+      bool full = m_writeQ.Size() >= m_writeHighWatermark;
+      if (!readsPending || full || IsOverAge(m_writeQ.Front()))
+        {
+          m_writeMode = true;
+          m_writeDrains += readsPending && full ? 1 : 0;
+        }
+    }
+  if (m_writeMode)
+    {
+      while (!m_writeQ.Empty()
+             && (!readsPending || m_writeQ.Size() > m_writeLowWatermark || IsOverAge(m_writeQ.Front())))
+        {
+          MemoryRequest* request = m_writeQ.Pop();
+          m_bufferedWrites.erase(request->address);
+          IssueToBank(request);
+        }
+      if (m_writesInFlight == 0 && !m_readQ.Empty())
+        {
+          m_writeMode = false;
+          while (!m_readQ.Empty())
+            {
+              IssueToBank(m_readQ.Pop());
+            }
+        }
+    }
+  // Writes left in the buffer are bounded by WriteMaxAge even if reads keep arriving
+  if (!m_writeQ.Empty() && !m_writeAgeEvent.IsPending())
+    {
+      Time age = Simulator::Now() - m_writeQ.Front()->arrival;
+      m_writeAgeEvent = Simulator::Schedule(Max(m_writeMaxAge - age, Time(0)), &HBMChannel::Schedule, this);
+    }
+}
+
+void
+HBMChannel::IssueToBank(MemoryRequest* request)
+{
+  (request->isWrite ? m_writesInFlight : m_readsInFlight)++;
+  m_banks[request->bankId]->ReceiveRequest(request);
+}
+
+void
+HBMChannel::ServeFromBuffer(MemoryRequest* request)
+{
+  Time now = Simulator::Now();
+  request->fromBuffer = true;
+  request->serviceStart = now;
+  request->accessDone = now;
+  if (request->isWrite)
+    {
+      // Merged into the buffered write, nothing crosses the bus
+      request->busStart = now;
+      Simulator::ScheduleNow(&HBMChannel::FinishTransfer, this, request);
+      return;
+    }
+  TransferData(request);
+}
+
+void
+HBMChannel::TransferData(MemoryRequest* request)
+{
+  // Bus transfers are served in the order the banks finish their row accesses
+  uint32_t busDelay = (request->size + m_busBandwidth - 1) / m_busBandwidth;
+  Time busFreeAt = m_busFreeAt;
+  if (m_busUsed && request->isWrite != m_lastBusWrite)
+    {
+      busFreeAt += request->isWrite ? m_readToWriteDelay : m_writeToReadDelay;
+      m_turnarounds++;
+    }
+  m_busUsed = true;
+  m_lastBusWrite = request->isWrite;
+  request->busStart = Max(busFreeAt, Simulator::Now());
+  m_busFreeAt = request->busStart + NanoSeconds(busDelay);
+  Simulator::Schedule(m_busFreeAt - Simulator::Now(), &HBMChannel::FinishTransfer, this, request);
+}
+
+void
+HBMChannel::FinishTransfer(MemoryRequest* request)
+{
+  NS_LOG_INFO("HBM Stack " << request->stackId << " Channel " << request->channelId << " transferred request "
+              << request->requestId << " at " << Simulator::Now().GetNanoSeconds() << " ns");
+  if (!request->fromBuffer)
+    {
+      (request->isWrite ? m_writesInFlight : m_readsInFlight)--;
+    }
+  // The controller recycles the request here
+  m_transferDone(request);
+  Schedule();
+}
+
+} // namespace ns3
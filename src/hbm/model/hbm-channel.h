@@ -0,0 +1,91 @@
+#ifndef HBM_CHANNEL_H
+#define HBM_CHANNEL_H
+
+#include "hbm-bank.h"
+#include "ns3/object.h"
+#include "ns3/ptr.h"
+#include "ns3/nstime.h"
+#include <unordered_set>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * An HBM pseudo channel: a group of banks with their own scheduler and a
+ * data bus shared by all of them. Banks work in parallel on row accesses,
+ * the data of finished accesses is then serialized on the channel bus.
+ *
+ * The scheduler keeps a write buffer and works in read or write mode. In read
+ * mode reads go to the banks and writes are buffered; it switches to write
+ * mode once WriteHighWatermark writes are buffered, the oldest one has waited
+ * WriteMaxAge or no read is pending. In write mode buffered writes are issued
+ * while more than WriteLowWatermark remain or the oldest one is over age (all
+ * of them when no read waits) and arriving reads are held; once
+ * the issued writes are done, the held reads are released. Each switch of
+ * the bus direction costs WriteToReadDelay (tWTR) or ReadToWriteDelay (tRTW).
+ * A write to an address already buffered is merged into the buffered one, a
+ * read of a buffered address is served from the buffer.
+ */
+class HBMChannel : public Object
+{
+public:
+  static TypeId GetTypeId(void);
+
+  HBMChannel();
+  virtual ~HBMChannel();
+
+  void InitializeBanks(uint32_t numBanks);
+  void ReceiveRequest(MemoryRequest* request);
+
+  // Called when the data of a request has crossed the bus
+  void SetTransferDoneCallback(Callback<void, MemoryRequest*> cb);
+
+  uint32_t GetNBanks() const;
+  Ptr<HBMBank> GetBank(uint32_t bankId) const;
+  // Peak data bus bandwidth in bytes per nanosecond
+  uint32_t GetBusBandwidth() const;
+
+  uint64_t GetTurnarounds() const;
+  uint64_t GetWriteDrains() const;
+  uint64_t GetMergedWrites() const;
+  uint64_t GetForwardedReads() const;
+
+private:
+  void DoDispose() override;
+  void Schedule();
+  bool IsOverAge(const MemoryRequest* request) const;
+  void IssueToBank(MemoryRequest* request);
+  void ServeFromBuffer(MemoryRequest* request);
+  void TransferData(MemoryRequest* request);
+  void FinishTransfer(MemoryRequest* request);
+
+  std::vector<Ptr<HBMBank>> m_banks;
+  uint32_t m_busBandwidth;
+  Time m_busFreeAt;
+  Callback<void, MemoryRequest*> m_transferDone;
+
+  uint32_t m_writeHighWatermark;
+  uint32_t m_writeLowWatermark;
+  Time m_writeToReadDelay;
+  Time m_readToWriteDelay;
+  Time m_writeMaxAge;
+  EventId m_writeAgeEvent;                    // re-runs Schedule when the oldest buffered write gets over age
+
+  bool m_writeMode = false;
+  MemoryRequestQueue m_readQ;                 // reads held during a write drain
+  MemoryRequestQueue m_writeQ;                // buffered writes
+  std::unordered_set<uint64_t> m_bufferedWrites;  // addresses in m_writeQ
+  uint32_t m_readsInFlight = 0;               // issued to the banks, data not transferred yet
+  uint32_t m_writesInFlight = 0;
+  bool m_busUsed = false;
+  bool m_lastBusWrite = false;
+
+  uint64_t m_turnarounds = 0;
+  uint64_t m_writeDrains = 0;                 // drains started by WriteHighWatermark
+  uint64_t m_mergedWrites = 0;
+  uint64_t m_forwardedReads = 0;
+};
+
+} // namespace ns3
+
+#endif // HBM_CHANNEL_H
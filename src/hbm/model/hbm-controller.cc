@@ -1,6 +1,9 @@
 #include "hbm-controller.h"
 #include "hbm-bank.h"
+#include "hbm-channel.h"
 #include "ns3/log.h"
+#include "ns3/uinteger.h"
+#include "ns3/simulator.h"
 
 namespace ns3 {
 
@@ -13,7 +16,36 @@ TypeId HBMController::GetTypeId(void)
     TypeId("ns3::HBMController")
       .SetParent<Object>()
       .SetGroupName("HBM")
-      .AddConstructor<HBMController>();
+      .AddConstructor<HBMController>()
+      .AddAttribute("StackNum",
+        "Number of HBM stacks of the device.",
+        UintegerValue(1),
+        MakeUintegerAccessor(&HBMController::m_stackNum),
+        MakeUintegerChecker<uint32_t>(1))
+      .AddAttribute("ChannelsPerStack",
+        "Number of channels of each stack, each with its own scheduler and data bus.",
+        UintegerValue(8),
+        MakeUintegerAccessor(&HBMController::m_channelsPerStack),
+        MakeUintegerChecker<uint32_t>(1))
+      .AddAttribute("BanksPerChannel",
+        "Number of banks of each channel.",
+        UintegerValue(HBM_BANK_PER_DIE),
+        MakeUintegerAccessor(&HBMController::m_banksPerChannel),
+        MakeUintegerChecker<uint32_t>(1))
+      .AddAttribute("InterleaveGranularity",
+        "Size (in bytes) of the address blocks interleaved over channels.",
+        UintegerValue(256),
+        MakeUintegerAccessor(&HBMController::m_interleaveGranularity),
+        MakeUintegerChecker<uint32_t>(HBM_BANK_ATOMIC_SIZE))
+      .AddAttribute("StatsWindow",
+        "Interval of the bytes per window statistics, 0 disables them.",
+        TimeValue(MicroSeconds(1)),
+        MakeTimeAccessor(&HBMController::m_statsWindow),
+        MakeTimeChecker())
+      .AddTraceSource("BurstLatency",
+        "Latency breakdown of a completed burst, fired once EnableStats is called.",
+        MakeTraceSourceAccessor(&HBMController::m_traceBurstLatency),
+        "ns3::HBMController::BurstLatencyTracedCallback");
   return tid;
 }
 
@@ -27,33 +59,195 @@ HBMController::~HBMController()
   NS_LOG_FUNCTION(this);
 }
 
+void
+HBMController::DoDispose()
+{
+  m_stacks.clear();
+  Object::DoDispose();
+}
+
 void
 HBMController::InitializeBanks(uint32_t numBanks)
 {
-  NS_LOG_FUNCTION(this << numBanks);
+  InitializeChannels(1, 1, numBanks);
+}
+
+void
+HBMController::InitializeChannels()
+{
+  InitializeChannels(m_stackNum, m_channelsPerStack, m_banksPerChannel);
+}
+
+void
+HBMController::InitializeChannels(uint32_t numStacks, uint32_t channelsPerStack, uint32_t banksPerChannel)
+{
+  NS_LOG_FUNCTION(this << numStacks << channelsPerStack << banksPerChannel);
+
+  m_stackNum = numStacks;
+  m_channelsPerStack = channelsPerStack;
+  m_banksPerChannel = banksPerChannel;
+  m_stacks.assign(numStacks, {});
+  for (auto &stack : m_stacks)
+    {
+      for (uint32_t i = 0; i < channelsPerStack; i++)
+        {
+          Ptr<HBMChannel> channel = CreateObject<HBMChannel>();
+          channel->InitializeBanks(banksPerChannel);
+          channel->SetTransferDoneCallback(MakeCallback(&HBMController::OnBurstComplete, this));
+          stack.push_back(channel);
+        }
+    }
+}
+
+uint32_t
+HBMController::GetNStacks() const
+{
+  return m_stacks.size();
+}
+
+uint32_t
+HBMController::GetNChannels() const
+{
+  return m_stacks.empty() ? 0 : m_stacks.size() * m_stacks[0].size();
+}
+
+uint64_t
+HBMController::GetPeakBandwidth() const
+{
+  uint64_t bandwidth = 0;
+  for (auto &stack : m_stacks)
+    {
+      for (auto &channel : stack)
+        {
+          bandwidth += channel->GetBusBandwidth();
+        }
+    }
+  return bandwidth;
+}
+
+Ptr<HBMChannel>
+HBMController::GetChannel(uint32_t stackId, uint32_t channelId) const
+{
+  return m_stacks.at(stackId).at(channelId);
+}
+
+void
+HBMController::EnableStats()
+{
+  m_statsEnabled = true;
+}
+
+const HBMController::Stats &
+HBMController::GetStats() const
+{
+  return m_stats;
+}
+
+const std::vector<uint64_t> &
+HBMController::GetWindowBytes() const
+{
+  return m_windowBytes;
+}
+
+Time
+HBMController::GetStatsWindow() const
+{
+  return m_statsWindow;
+}
 
-  m_banks.clear();
-  for (uint32_t i = 0; i < numBanks; i++)
+void
+HBMController::RecordBurst(const MemoryRequest &request)
+{
+  Time now = Simulator::Now();
+  Time queue = (request.serviceStart - request.arrival) + (request.busStart - request.accessDone);
+  Time cas = request.accessDone - request.serviceStart - request.activateTime;
+  Time burst = now - request.busStart;
+  m_stats.bursts++;
+  (request.isWrite ? m_stats.writeBytes : m_stats.readBytes) += request.size;
+  m_stats.rowHits += request.rowHit ? 1 : 0;
+  m_stats.queueDelay += queue;
+  m_stats.activateDelay += request.activateTime;
+  m_stats.casDelay += cas;
+  m_stats.burstDelay += burst;
+  if (m_statsWindow.IsStrictlyPositive())
     {
-      m_banks.push_back(CreateObject<HBMBank>());
+      size_t window = now.GetTimeStep() / m_statsWindow.GetTimeStep();
+      if (window >= m_windowBytes.size())
+        {
+          m_windowBytes.resize(window + 1, 0);
+        }
+      m_windowBytes[window] += request.size;
     }
+  m_traceBurstLatency(queue, request.activateTime, cas, burst);
 }
 
-void HBMController::SendRequest(uint32_t requestId, uint64_t address, uint32_t size, uint32_t bankId, bool isWrite, Callback<void, void*> cb, void* arg)
+void
+HBMController::MapAddress(uint64_t address, MemoryRequest &request) const
+{
+  uint64_t block = address / m_interleaveGranularity;
+  uint32_t totalChannels = GetNChannels();
+  uint32_t globalChannel = block % totalChannels;
+  request.stackId = globalChannel % m_stacks.size();
+  request.channelId = globalChannel / m_stacks.size();
+  // Address inside the channel, its bursts rotate over the banks
+  uint64_t local = (block / totalChannels) * m_interleaveGranularity + address % m_interleaveGranularity;
+  request.bankId = (local / HBM_BANK_ATOMIC_SIZE) % m_banksPerChannel;
+  request.bankAddress = (local / HBM_BANK_ATOMIC_SIZE) / m_banksPerChannel * HBM_BANK_ATOMIC_SIZE
+                        + local % HBM_BANK_ATOMIC_SIZE;
+}
+
+void
+HBMController::SendRequest(uint64_t requestId, uint64_t address, uint32_t size, bool isWrite, HBMClient* client)
 {
   NS_LOG_FUNCTION(this << requestId);
 
-  if (m_banks.empty())
+  if (m_stacks.empty())
     {
-      NS_LOG_ERROR("HBMController has no banks initialized!");
+      NS_LOG_ERROR("HBMController has no channels initialized!");
       return;
     }
-  if (bankId >= m_banks.size()) {
-      NS_LOG_ERROR("Attempt to access bank" << bankId << "but HBM has only" << m_banks.size() << "banks" );
+  uint64_t first = address / HBM_BANK_ATOMIC_SIZE;
+  uint64_t last = (address + (size == 0 ? 1 : size) - 1) / HBM_BANK_ATOMIC_SIZE;
+  uint32_t accessId = m_accesses.Alloc();
+  PendingAccess &access = m_accesses[accessId];
+  access.remaining = last - first + 1;
+  access.client = client;
+  access.requestId = requestId;
+  for (uint64_t burst = first; burst <= last; burst++)
+    {
+      uint32_t slot = m_requests.Alloc();
+      MemoryRequest* request = &m_requests[slot];
+      request->slot = slot;
+      request->address = burst * HBM_BANK_ATOMIC_SIZE;
+      request->size = HBM_BANK_ATOMIC_SIZE;
+      request->isWrite = isWrite;
+      request->requestId = accessId;
+      MapAddress(request->address, *request);
+      m_stacks[request->stackId][request->channelId]->ReceiveRequest(request);
+    }
+}
+
+void
+HBMController::OnBurstComplete(MemoryRequest* request)
+{
+  if (m_statsEnabled)
+    {
+      RecordBurst(*request);
+    }
+  uint32_t accessId = request->requestId;
+  m_requests.Free(request->slot);
+  PendingAccess &access = m_accesses[accessId];
+  if (--access.remaining > 0)
+    {
       return;
-  }
-  MemoryRequest request = {address, size, bankId, isWrite, requestId, cb, arg};
-  m_banks[request.bankId]->ReceiveRequest(request);
+    }
+  HBMClient* client = access.client;
+  uint64_t requestId = access.requestId;
+  m_accesses.Free(accessId);
+  if (client != nullptr)
+    {
+      client->HBMAccessDone(requestId);
+    }
 }
 
 } // namespace ns3
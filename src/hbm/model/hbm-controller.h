@@ -3,12 +3,22 @@
 
 #include "ns3/object.h"
 #include "ns3/ptr.h"
+#include "ns3/nstime.h"
+#include "ns3/traced-callback.h"
+#include "hbm-request.h"
 #include <vector>
 
 namespace ns3 {
 
-class HBMBank;
+class HBMChannel;
 
+/**
+ * Memory controller of a device: StackNum stacks x ChannelsPerStack channels
+ * x BanksPerChannel banks. Consecutive InterleaveGranularity sized blocks are
+ * spread over stacks first and then over the channels of a stack, the
+ * HBM_BANK_ATOMIC_SIZE bursts inside a block are spread over the banks of
+ * the channel.
+ */
 class HBMController : public Object
 {
 public:
@@ -17,11 +27,73 @@ public:
   HBMController();
   virtual ~HBMController();
 
+  // Single stack, single channel with numBanks banks
   void InitializeBanks(uint32_t numBanks);
-  void SendRequest(uint32_t requestId, uint64_t address, uint32_t size, uint32_t bankId, bool isWrite, Callback<void, void*> cb, void* arg);
+  void InitializeChannels(uint32_t numStacks, uint32_t channelsPerStack, uint32_t banksPerChannel);
+  // Build the hierarchy from the StackNum/ChannelsPerStack/BanksPerChannel attributes
+  void InitializeChannels();
+
+  /**
+   * Access [address, address + size). The access is split into bursts which
+   * are served by the channels they map to; client->HBMAccessDone(requestId)
+   * is called once all of them are done. client may be null.
+   */
+  void SendRequest(uint64_t requestId, uint64_t address, uint32_t size, bool isWrite, HBMClient* client);
+
+  // Map an address to its stack, channel and bank
+  void MapAddress(uint64_t address, MemoryRequest &request) const;
+
+  uint32_t GetNStacks() const;
+  uint32_t GetNChannels() const;
+  // Peak bandwidth of all channel buses (in bytes per nanosecond)
+  uint64_t GetPeakBandwidth() const;
+  Ptr<HBMChannel> GetChannel(uint32_t stackId, uint32_t channelId) const;
+
+  // Sums over all bursts completed since EnableStats
+  struct Stats {
+    uint64_t bursts = 0;
+    uint64_t readBytes = 0;
+    uint64_t writeBytes = 0;
+    uint64_t rowHits = 0;
+    Time queueDelay;     // Waiting for the bank and for the channel bus
+    Time activateDelay;
+    Time casDelay;
+    Time burstDelay;     // Data transfer on the channel bus
+  };
+
+  // Collect per-burst statistics and fire BurstLatency, off by default
+  void EnableStats();
+  const Stats &GetStats() const;
+  // Bytes completed in each StatsWindow long interval since time 0
+  const std::vector<uint64_t> &GetWindowBytes() const;
+  Time GetStatsWindow() const;
+
+  typedef void (*BurstLatencyTracedCallback)(Time queue, Time activate, Time cas, Time burst);
 
 private:
-  std::vector<Ptr<HBMBank>> m_banks;
+  struct PendingAccess {
+    uint32_t remaining = 0;
+    HBMClient* client = nullptr;
+    uint64_t requestId = 0;
+  };
+
+  void DoDispose() override;
+  void OnBurstComplete(MemoryRequest* request);
+  void RecordBurst(const MemoryRequest &request);
+
+  std::vector<std::vector<Ptr<HBMChannel>>> m_stacks;
+  uint32_t m_stackNum;
+  uint32_t m_channelsPerStack;
+  uint32_t m_banksPerChannel;
+  uint32_t m_interleaveGranularity;
+  HBMPool<PendingAccess> m_accesses;
+  HBMPool<MemoryRequest> m_requests;
+
+  bool m_statsEnabled = false;
+  Time m_statsWindow;
+  Stats m_stats;
+  std::vector<uint64_t> m_windowBytes;
+  TracedCallback<Time, Time, Time, Time> m_traceBurstLatency;
 };
 
 } // namespace ns3
@@ -0,0 +1,150 @@
+#ifndef HBM_REQUEST_H
+#define HBM_REQUEST_H
+
+#include "ns3/nstime.h"
+#include "ns3/assert.h"
+#include <deque>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * Receiver of completed memory accesses. The requestId given to SendRequest
+ * is handed back once all bursts of the access are done, so clients keep the
+ * context of an access in an HBMPool slot and use the slot index as requestId.
+ */
+class HBMClient
+{
+public:
+  virtual ~HBMClient() = default;
+  virtual void HBMAccessDone(uint64_t requestId) = 0;
+};
+
+/**
+ * Slab of T with stable addresses. Slots are recycled through a free list,
+ * so steady state accesses do not allocate.
+ */
+template <typename T>
+class HBMPool
+{
+public:
+  uint32_t Alloc()
+  {
+    if (m_free.empty())
+      {
+        m_slots.emplace_back();
+        return m_slots.size() - 1;
+      }
+    uint32_t id = m_free.back();
+    m_free.pop_back();
+    m_slots[id] = T();
+    return id;
+  }
+
+  void Free(uint32_t id)
+  {
+    NS_ASSERT(id < m_slots.size());
+    m_free.push_back(id);
+  }
+
+  T &operator[](uint32_t id)
+  {
+    return m_slots[id];
+  }
+
+  uint32_t GetCapacity() const
+  {
+    return m_slots.size();
+  }
+
+  uint32_t GetInUse() const
+  {
+    return m_slots.size() - m_free.size();
+  }
+
+private:
+  std::deque<T> m_slots;
+  std::vector<uint32_t> m_free;
+};
+
+/**
+ * Descriptor of one burst. It is taken from the controller's pool and
+ * passed by pointer through the bank queue, the bank and the channel bus.
+ */
+struct MemoryRequest {
+    uint64_t address = 0;     // Memory address for the request
+    uint32_t size = 0;        // Size of the request (in bytes)
+    uint32_t bankId = 0;      // The bank that the request is intended for
+    bool isWrite = false;     // Whether it's a write request or a read request
+    uint32_t requestId = 0;   // Slot of the access this burst belongs to
+    uint32_t stackId = 0;     // The stack that the request is mapped to
+    uint32_t channelId = 0;   // The channel (within the stack) that the request is mapped to
+    uint64_t bankAddress = 0; // Address inside the bank, selects the row
+    // Timestamps of the request, used for the latency breakdown
+    Time arrival;       // Received by the channel, before any write buffering or drain hold
+    Time serviceStart;  // The bank starts the row access
+    Time activateTime;  // Part of the row access spent activating the row, 0 on a row hit
+    Time accessDone;    // Row access done, the data waits for the bus
+    Time busStart;      // Data transfer on the channel bus starts
+    bool rowHit = false;
+    bool fromBuffer = false;       // Served by the write buffer of the channel, no bank access
+    uint32_t slot = 0;             // Own slot in the controller's pool
+    MemoryRequest* next = nullptr; // Link of the bank queue
+};
+
+// Intrusive FIFO of requests linked through MemoryRequest::next
+class MemoryRequestQueue
+{
+public:
+  bool Empty() const
+  {
+    return m_head == nullptr;
+  }
+
+  uint32_t Size() const
+  {
+    return m_size;
+  }
+
+  void Push(MemoryRequest* request)
+  {
+    request->next = nullptr;
+    if (m_tail == nullptr)
+      {
+        m_head = request;
+      }
+    else
+      {
+        m_tail->next = request;
+      }
+    m_tail = request;
+    m_size++;
+  }
+
+  MemoryRequest* Front() const
+  {
+    return m_head;
+  }
+
+  MemoryRequest* Pop()
+  {
+    MemoryRequest* request = m_head;
+    m_head = request->next;
+    if (m_head == nullptr)
+      {
+        m_tail = nullptr;
+      }
+    request->next = nullptr;
+    m_size--;
+    return request;
+  }
+
+private:
+  MemoryRequest* m_head = nullptr;
+  MemoryRequest* m_tail = nullptr;
+  uint32_t m_size = 0;
+};
+
+} // namespace ns3
+
+#endif // HBM_REQUEST_H
@@ -0,0 +1,277 @@
+#include "hbm-traffic-generator.h"
+#include "hbm-cache.h"
+#include "hbm-controller.h"
+#include "ns3/simulator.h"
+#include "ns3/uinteger.h"
+#include "ns3/double.h"
+#include "ns3/log.h"
+#include <algorithm>
+#include <cmath>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE("HBMTrafficGenerator");
+NS_OBJECT_ENSURE_REGISTERED(HBMTrafficGenerator);
+
+TypeId HBMTrafficGenerator::GetTypeId(void)
+{
+  static TypeId tid =
+    TypeId("ns3::HBMTrafficGenerator")
+      .SetParent<Object>()
+      .SetGroupName("HBM")
+      .AddConstructor<HBMTrafficGenerator>()
+      .AddAttribute("Load",
+        "Offered load as a fraction of the peak bandwidth of the controller, read at the start of each on period.",
+        DoubleValue(0.1),
+        MakeDoubleAccessor(&HBMTrafficGenerator::m_load),
+        MakeDoubleChecker<double>(0.0))
+      .AddAttribute("RequestSize",
+        "Size of each request (in bytes).",
+        UintegerValue(64),
+        MakeUintegerAccessor(&HBMTrafficGenerator::m_requestSize),
+        MakeUintegerChecker<uint32_t>(1))
+      .AddAttribute("StreamWeight",
+        "Relative weight of sequential stream accesses.",
+        DoubleValue(1.0),
+        MakeDoubleAccessor(&HBMTrafficGenerator::m_streamWeight),
+        MakeDoubleChecker<double>(0.0))
+      .AddAttribute("RandomWeight",
+        "Relative weight of uniform random accesses.",
+        DoubleValue(0.0),
+        MakeDoubleAccessor(&HBMTrafficGenerator::m_randomWeight),
+        MakeDoubleChecker<double>(0.0))
+      .AddAttribute("StrideWeight",
+        "Relative weight of fixed stride accesses.",
+        DoubleValue(0.0),
+        MakeDoubleAccessor(&HBMTrafficGenerator::m_strideWeight),
+        MakeDoubleChecker<double>(0.0))
+      .AddAttribute("Stride",
+        "Distance (in bytes) between two strided accesses.",
+        UintegerValue(4096),
+        MakeUintegerAccessor(&HBMTrafficGenerator::m_stride),
+        MakeUintegerChecker<uint32_t>(1))
+      .AddAttribute("WriteRatio",
+        "Probability that a request is a write.",
+        DoubleValue(0.3),
+        MakeDoubleAccessor(&HBMTrafficGenerator::m_writeRatio),
+        MakeDoubleChecker<double>(0.0, 1.0))
+      .AddAttribute("AddressBase",
+        "Start of the address window accessed by the generator.",
+        UintegerValue(0),
+        MakeUintegerAccessor(&HBMTrafficGenerator::m_addressBase),
+        MakeUintegerChecker<uint64_t>())
+      .AddAttribute("AddressRange",
+        "Size (in bytes) of the address window accessed by the generator.",
+        UintegerValue(1ULL << 30),
+        MakeUintegerAccessor(&HBMTrafficGenerator::m_addressRange),
+        MakeUintegerChecker<uint64_t>(1))
+      .AddAttribute("OnTime",
+        "Length of an issuing period.",
+        TimeValue(MicroSeconds(10)),
+        MakeTimeAccessor(&HBMTrafficGenerator::m_onTime),
+        MakeTimeChecker())
+      .AddAttribute("OffTime",
+        "Length of a silent period between two issuing periods, 0 keeps the generator always on.",
+        TimeValue(Seconds(0)),
+        MakeTimeAccessor(&HBMTrafficGenerator::m_offTime),
+        MakeTimeChecker())
+      .AddAttribute("MaxOutstanding",
+        "Maximum number of requests in flight.",
+        UintegerValue(64),
+        MakeUintegerAccessor(&HBMTrafficGenerator::m_maxOutstanding),
+        MakeUintegerChecker<uint32_t>(1))
+      .AddTraceSource("Latency",
+        "A background request completes.",
+        MakeTraceSourceAccessor(&HBMTrafficGenerator::m_traceLatency),
+        "ns3::HBMTrafficGenerator::LatencyTracedCallback");
+  return tid;
+}
+
+HBMTrafficGenerator::HBMTrafficGenerator()
+{
+  NS_LOG_FUNCTION(this);
+  m_random = CreateObject<UniformRandomVariable>();
+}
+
+HBMTrafficGenerator::~HBMTrafficGenerator()
+{
+  NS_LOG_FUNCTION(this);
+}
+
+void
+HBMTrafficGenerator::DoDispose()
+{
+  Stop();
+  m_controller = nullptr;
+  m_cache = nullptr;
+  m_random = nullptr;
+  Object::DoDispose();
+}
+
+void
+HBMTrafficGenerator::SetController(Ptr<HBMController> controller)
+{
+  m_controller = controller;
+}
+
+void
+HBMTrafficGenerator::SetCache(Ptr<HBMCache> cache)
+{
+  m_cache = cache;
+}
+
+void
+HBMTrafficGenerator::Start()
+{
+  NS_ASSERT_MSG(m_controller != nullptr, "HBMTrafficGenerator has no controller");
+  NS_ASSERT_MSG(m_streamWeight + m_randomWeight + m_strideWeight > 0, "HBMTrafficGenerator pattern weights are all 0");
+  // Load is read when the first on period starts, so it can still be set
+  // per node after the generator is created and before the simulation runs
+  m_phaseEvent = Simulator::ScheduleNow(&HBMTrafficGenerator::StartOnPeriod, this);
+}
+
+void
+HBMTrafficGenerator::Stop()
+{
+  m_running = false;
+  m_issueEvent.Cancel();
+  m_phaseEvent.Cancel();
+}
+
+void
+HBMTrafficGenerator::StartOnPeriod()
+{
+  uint64_t peak = m_controller->GetPeakBandwidth();
+  if (m_load > 0 && peak > 0)
+    {
+      m_intervalNs = m_requestSize / (m_load * peak);
+      NS_LOG_INFO("Background load " << m_load << " of " << peak << " B/ns, one request every "
+                  << m_intervalNs << " ns");
+      m_running = true;
+      m_nextIssueNs = Simulator::Now().GetNanoSeconds();
+      Issue();
+    }
+  if (m_offTime.IsStrictlyPositive())
+    {
+      m_phaseEvent = Simulator::Schedule(m_onTime, &HBMTrafficGenerator::StartOffPeriod, this);
+    }
+}
+
+void
+HBMTrafficGenerator::StartOffPeriod()
+{
+  m_running = false;
+  m_issueEvent.Cancel();
+  m_phaseEvent = Simulator::Schedule(m_offTime, &HBMTrafficGenerator::StartOnPeriod, this);
+}
+
+uint64_t
+HBMTrafficGenerator::NextAddress()
+{
+  uint64_t offset;
+  double pick = m_random->GetValue(0, m_streamWeight + m_randomWeight + m_strideWeight);
+  if (pick < m_streamWeight)
+    {
+      offset = m_streamCursor;
+      m_streamCursor = (m_streamCursor + m_requestSize) % m_addressRange;
+    }
+  else if (pick < m_streamWeight + m_randomWeight)
+    {
+      uint64_t slots = std::max<uint64_t>(m_addressRange / m_requestSize, 1);
+      offset = static_cast<uint64_t>(m_random->GetValue(0, slots)) * m_requestSize;
+    }
+  else
+    {
+      offset = m_strideCursor;
+      m_strideCursor = (m_strideCursor + m_stride) % m_addressRange;
+    }
+  return m_addressBase + offset;
+}
+
+void
+HBMTrafficGenerator::IssueOne()
+{
+  if (m_outstanding >= m_maxOutstanding)
+    {
+      m_skipped++;
+      return;
+    }
+  uint32_t accessId = m_accesses.Alloc();
+  PendingAccess &access = m_accesses[accessId];
+  access.address = NextAddress();
+  access.isWrite = m_random->GetValue() < m_writeRatio;
+  access.start = Simulator::Now();
+  m_outstanding++;
+  m_issued++;
+  if (m_cache != nullptr)
+    {
+      m_cache->SendRequest(accessId, access.address, m_requestSize, access.isWrite, this);
+    }
+  else
+    {
+      m_controller->SendRequest(accessId, access.address, m_requestSize, access.isWrite, this);
+    }
+}
+
+void
+HBMTrafficGenerator::Issue()
+{
+  if (!m_running)
+    {
+      return;
+    }
+  // The issue interval may be shorter than the time resolution, every
+  // request due by now is issued in this event.
+  double now = Simulator::Now().GetNanoSeconds();
+  while (m_nextIssueNs <= now)
+    {
+      IssueOne();
+      m_nextIssueNs += m_intervalNs;
+    }
+  m_issueEvent = Simulator::Schedule(NanoSeconds(std::ceil(m_nextIssueNs - now)), &HBMTrafficGenerator::Issue, this);
+}
+
+void
+HBMTrafficGenerator::HBMAccessDone(uint64_t requestId)
+{
+  PendingAccess &access = m_accesses[requestId];
+  Time latency = Simulator::Now() - access.start;
+  m_outstanding--;
+  m_completed++;
+  m_completedBytes += m_requestSize;
+  m_totalLatency += latency;
+  m_traceLatency(access.address, access.isWrite, latency);
+  m_accesses.Free(requestId);
+}
+
+uint64_t
+HBMTrafficGenerator::GetIssued() const
+{
+  return m_issued;
+}
+
+uint64_t
+HBMTrafficGenerator::GetCompleted() const
+{
+  return m_completed;
+}
+
+uint64_t
+HBMTrafficGenerator::GetSkipped() const
+{
+  return m_skipped;
+}
+
+uint64_t
+HBMTrafficGenerator::GetCompletedBytes() const
+{
+  return m_completedBytes;
+}
+
+Time
+HBMTrafficGenerator::GetAverageLatency() const
+{
+  return m_completed == 0 ? Time(0) : m_totalLatency / static_cast<int64_t>(m_completed);
+}
+
+} // namespace ns3
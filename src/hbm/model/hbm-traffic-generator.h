@@ -0,0 +1,112 @@
+#ifndef HBM_TRAFFIC_GENERATOR_H
+#define HBM_TRAFFIC_GENERATOR_H
+
+#include "ns3/object.h"
+#include "ns3/ptr.h"
+#include "ns3/nstime.h"
+#include "ns3/event-id.h"
+#include "ns3/traced-callback.h"
+#include "ns3/random-variable-stream.h"
+#include "hbm-request.h"
+
+namespace ns3 {
+
+class HBMController;
+class HBMCache;
+
+/**
+ * Background load of a device's own compute on its local memory.
+ *
+ * Requests of RequestSize bytes are issued at a constant rate so that the
+ * offered load is Load x the peak bandwidth of the controller; Load is read
+ * at the start of every on period, a Load of 0 keeps the period silent. Each request
+ * picks its address pattern (sequential stream, uniform random or fixed
+ * stride) by the Stream/Random/StrideWeight mix and is a write with
+ * probability WriteRatio. The generator alternates between OnTime periods of
+ * issuing and OffTime periods of silence; OffTime 0 keeps it always on. At
+ * most MaxOutstanding requests are in flight, issue slots beyond that are
+ * skipped so a saturated memory is not flooded by an unbounded backlog.
+ */
+class HBMTrafficGenerator : public Object, public HBMClient
+{
+public:
+  static TypeId GetTypeId(void);
+
+  HBMTrafficGenerator();
+  virtual ~HBMTrafficGenerator();
+
+  // Requests go to the cache when one is set, otherwise to the controller
+  void SetController(Ptr<HBMController> controller);
+  void SetCache(Ptr<HBMCache> cache);
+
+  void Start();
+  void Stop();
+
+  void HBMAccessDone(uint64_t requestId) override;
+
+  uint64_t GetIssued() const;
+  uint64_t GetCompleted() const;
+  uint64_t GetSkipped() const;
+  uint64_t GetCompletedBytes() const;
+  Time GetAverageLatency() const;
+
+  typedef void (*LatencyTracedCallback)(uint64_t address, bool isWrite, Time latency);
+
+private:
+  enum Pattern {
+    STREAM,
+    RANDOM,
+    STRIDE
+  };
+  struct PendingAccess {
+    uint64_t address = 0;
+    bool isWrite = false;
+    Time start;
+  };
+
+  void DoDispose() override;
+  void StartOnPeriod();
+  void StartOffPeriod();
+  void Issue();
+  void IssueOne();
+  uint64_t NextAddress();
+
+  Ptr<HBMController> m_controller;
+  Ptr<HBMCache> m_cache;
+
+  double m_load;
+  uint32_t m_requestSize;
+  double m_streamWeight;
+  double m_randomWeight;
+  double m_strideWeight;
+  uint32_t m_stride;
+  double m_writeRatio;
+  uint64_t m_addressBase;
+  uint64_t m_addressRange;
+  Time m_onTime;
+  Time m_offTime;
+  uint32_t m_maxOutstanding;
+
+  double m_intervalNs = 0;
+  double m_nextIssueNs = 0;
+  bool m_running = false;
+  EventId m_issueEvent;
+  EventId m_phaseEvent;
+  uint64_t m_streamCursor = 0;
+  uint64_t m_strideCursor = 0;
+  Ptr<UniformRandomVariable> m_random;
+  HBMPool<PendingAccess> m_accesses;
+
+  uint32_t m_outstanding = 0;
+  uint64_t m_issued = 0;
+  uint64_t m_completed = 0;
+  uint64_t m_skipped = 0;
+  uint64_t m_completedBytes = 0;
+  Time m_totalLatency;
+
+  TracedCallback<uint64_t, bool, Time> m_traceLatency;
+};
+
+} // namespace ns3
+
+#endif // HBM_TRAFFIC_GENERATOR_H
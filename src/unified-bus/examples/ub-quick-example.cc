@@ -9,7 +9,7 @@ using namespace utils;
 
 void CheckExampleProcess()
 {
-    if (!UbTrafficGen::Get()->IsCompleted()) {
+    if (!UbTrafficGen::Get()->IsCompleted() || !UbUtils::Get()->IsMemTraceReplayCompleted()) {
             Simulator::Schedule(MicroSeconds(100), &CheckExampleProcess);
             return;
     }
@@ -33,6 +33,7 @@ void RunCase(const string& configPath)
     string TpConfigFile = configPath + "/transport_channel.csv";
     TpConnectionManager retConnectionManager = UbUtils::Get()->CreateTp(TpConfigFile);
     UbUtils::Get()->TopoTraceConnect();
+    UbUtils::Get()->InitFcMonitor();
     string TrafficConfigFile = configPath + "/traffic.csv";
     auto trafficData = UbUtils::Get()->ReadTrafficCSV(TrafficConfigFile);
 
@@ -56,6 +57,7 @@ void RunCase(const string& configPath)
         client->GetTpnConn(retConnectionManager.GetConnectionManagerByNode(record.sourceNode));
     }
     UbTrafficGen::Get()->ScheduleNextTasks();
+    UbUtils::Get()->InitMemTraceReplay(configPath);
     CheckExampleProcess();
 }
 
@@ -140,6 +140,15 @@ uint32_t UbHostCaqm::GetRestCwnd()
     }
 }
 
+// 按cwnd/RTT估算pacing速率，还未测得RTT时返回0
+DataRate UbHostCaqm::GetPacingRate()
+{
+    if (!m_congestionCtrlEnabled || m_rtt.IsZero()) {
+        return DataRate(0);
+    }
+    return DataRate(static_cast<uint64_t>(m_cwnd * 8.0 / m_rtt.GetSeconds()));
+}
+
 // 发送端生成拥塞控制算法需要的header
 UbNetworkHeader UbHostCaqm::SenderGenNetworkHeader()
 {
@@ -431,44 +440,76 @@ void UbSwitchCaqm::SwitchInit(Ptr<UbSwitch> sw)
     m_nodeId = node->GetId();
     if (m_congestionCtrlEnabled) {
         uint32_t ndevice = node->GetNDevices();
+        m_txSize.assign(ndevice, 0);
+        m_cc.assign(ndevice, 0);
+        m_DC.assign(ndevice, 0);
+        m_creditAllocated.assign(ndevice, 0);
+        m_periodBytes.assign(ndevice, 0);
+        m_ccEpoch.assign(ndevice, 0);
         for (uint32_t i = 0; i < ndevice; i++) {
-            m_txSize.push_back(0);
-            m_cc.push_back(0);
-            m_DC.push_back(0);
-            m_creditAllocated.push_back(0);
-            m_bps.push_back(DynamicCast<UbPort>(node->GetDevice(i))->GetDataRate());
+            SetDataRate(i, DynamicCast<UbPort>(node->GetDevice(i))->GetDataRate());
         }
+        m_queueManager = sw->GetQueueManager();
     }
     sw->SetCongestionCtrl(this);
 }
 
+/**
+ * @brief 初始化所有端口的cc。之后不再周期性调度，
+ * 各端口在下一次转发报文时按经过的周期数惰性更新(UpdateLocalCc)。
+ */
 void UbSwitchCaqm::ResetLocalCc()
 {
     if (m_congestionCtrlEnabled) {
-        auto node = NodeList::GetNode(m_nodeId);
-        auto sw = node->GetObject<UbSwitch>();
-        uint32_t ndevice = node->GetNDevices();
-        for (uint32_t portId = 0; portId < ndevice; portId++) {
-            uint64_t cc = uint64_t(m_lambda *
-                                (m_ccUpdatePeriod.GetSeconds()
-                                * m_bps[portId].GetBitRate() / 8
-                                - m_txSize[portId]
-                                + m_idealQueueSize
-                                - sw->GetQueueManager()->GetAllEgressUsed(portId)
-                                - m_creditAllocated[portId]));
-            m_cc[portId] = cc;
-            m_txSize[portId] = 0;
-            m_DC[portId] = 0;
-            m_creditAllocated[portId] = 0;
+        m_queueManager = NodeList::GetNode(m_nodeId)->GetObject<UbSwitch>()->GetQueueManager();
+        int64_t epoch = GetCurrentEpoch();
+        for (uint32_t portId = 0; portId < m_cc.size(); portId++) {
+            RecomputeCc(portId);
+            m_ccEpoch[portId] = epoch;
         }
-        Simulator::Schedule(m_ccUpdatePeriod, &UbSwitchCaqm::ResetLocalCc, this);
     }
 }
 
+int64_t UbSwitchCaqm::GetCurrentEpoch() const
+{
+    return Simulator::Now().GetTimeStep() / m_ccUpdatePeriod.GetTimeStep();
+}
+
+void UbSwitchCaqm::RecomputeCc(uint32_t portId)
+{
+    m_cc[portId] = int64_t(m_lambda *
+                           (m_periodBytes[portId]
+                           - m_txSize[portId]
+                           + m_idealQueueSize
+                           - m_queueManager->GetAllEgressUsed(portId)
+                           - m_creditAllocated[portId]));
+    m_txSize[portId] = 0;
+    m_DC[portId] = 0;
+    m_creditAllocated[portId] = 0;
+}
+
+/**
+ * @brief 惰性更新：跨过周期边界时补做一次重置。跨过多个周期说明中间端口空闲，
+ * 上一周期的发送量与已分配信用均为0。队列占用取更新时刻的值。
+ */
+void UbSwitchCaqm::UpdateLocalCc(uint32_t portId)
+{
+    int64_t epoch = GetCurrentEpoch();
+    if (epoch <= m_ccEpoch[portId]) {
+        return;
+    }
+    if (epoch > m_ccEpoch[portId] + 1) {
+        m_txSize[portId] = 0;
+        m_creditAllocated[portId] = 0;
+    }
+    RecomputeCc(portId);
+    m_ccEpoch[portId] = epoch;
+}
+
 void UbSwitchCaqm::SetDataRate(uint32_t portId, DataRate bps)
 {
     if (m_congestionCtrlEnabled) {
-        m_bps[portId] = bps;
+        m_periodBytes[portId] = m_ccUpdatePeriod.GetSeconds() * bps.GetBitRate() / 8;
     }
 }
 
@@ -485,15 +526,15 @@ void UbSwitchCaqm::SwitchForwardPacket(uint32_t inPort, uint32_t outPort, Ptr<Pa
                       << " This is not ipv4 packet.");
             return;
         }
+        UpdateLocalCc(outPort);
         m_txSize[outPort] += p->GetSize();
-        auto sw = NodeList::GetNode(m_nodeId)->GetObject<UbSwitch>();
         NS_LOG_DEBUG("[" << GetTypeId().GetName() << "]"
                   << "[Debug]"
                   << "[" << __FUNCTION__ << "]"
                   << " Node:" << m_nodeId
                   << " Inport:" << inPort
                   << " OutPort:" << outPort
-                  << " Egress queue size:" << sw->GetQueueManager()->GetAllEgressUsed(outPort)
+                  << " Egress queue size:" << m_queueManager->GetAllEgressUsed(outPort)
                   << " Txsize:" << m_txSize[outPort]);
         UbDatalinkPacketHeader dlPktHeader;
         UbNetworkHeader netHeader;
@@ -573,7 +614,9 @@ void UbSwitchCaqm::DoDispose()
     m_txSize.clear();
     m_DC.clear();
     m_creditAllocated.clear();
-    m_bps.clear();
+    m_periodBytes.clear();
+    m_ccEpoch.clear();
+    m_queueManager = nullptr;
     m_random = nullptr;
     Object::DoDispose();
 }
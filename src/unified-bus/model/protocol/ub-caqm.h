@@ -58,6 +58,9 @@ public:
     // 获取剩余窗口，CAQM LDCP需要
     uint32_t GetRestCwnd() override;
 
+    // 按cwnd/RTT估算pacing速率，TP pacer使用
+    DataRate GetPacingRate() override;
+
     // 发送端生成拥塞控制算法需要的header
     UbNetworkHeader SenderGenNetworkHeader() override;
 
@@ -128,19 +131,27 @@ public:
     // 交换机收到包进行转发，对其进行处理
     void SwitchForwardPacket(uint32_t inPort, uint32_t outPort, Ptr<Packet> p) override;
 
-    // switch自动更新cc
+    // 初始化各端口cc，之后按周期惰性更新
     void ResetLocalCc();
 
 private:
 
     void DoDispose() override;
 
+    int64_t GetCurrentEpoch() const;
+    void RecomputeCc(uint32_t portId);
+    void UpdateLocalCc(uint32_t portId);
+
     Time m_ccUpdatePeriod;                      // 交换机自动更新CC的周期
+    // 按端口索引的SoA数组
     std::vector<int64_t> m_cc;                  // Credit Counter，端口可用信用证的数量，代表端口空闲转发能力
     std::vector<uint64_t> m_txSize ;            // 实际吞吐量
     std::vector<int64_t> m_DC;                  // Deficit Counter，赤字计数器
     std::vector<int64_t> m_creditAllocated;     // 上一次循环中分配除去的信用证
-    std::vector<DataRate> m_bps;                // port带宽
+    std::vector<double> m_periodBytes;          // 一个更新周期内端口可发送的字节数
+    std::vector<int64_t> m_ccEpoch;             // 端口cc最近一次更新所在的周期号
+
+    Ptr<UbQueueManager> m_queueManager;
 
     uint32_t m_nodeId;                          // 绑定的switch节点号
 
@@ -1,6 +1,7 @@
 // SPDX-License-Identifier: GPL-2.0-only
 #include "ns3/ub-congestion-control.h"
 #include "ns3/ub-caqm.h"
+#include "ns3/ub-dcqcn.h"
 #include "ns3/boolean.h"
 #include "ns3/enum.h"
 #include "ns3/ub-switch.h"
@@ -57,6 +58,10 @@ Ptr<UbCongestionControl> UbCongestionControl::Create(UbNodeType_t nodeType)
         return CreateObject<UbHostCaqm>();
     } else if (algo == CAQM && nodeType == UB_SWITCH) {
         return CreateObject<UbSwitchCaqm>();
+    } else if (algo == DCQCN && nodeType == UB_DEVICE) {
+        return CreateObject<UbHostDcqcn>();
+    } else if (algo == DCQCN && nodeType == UB_SWITCH) {
+        return CreateObject<UbSwitchDcqcn>();
     } else {
         // Other congestion control algorithms to be extended
         return nullptr;
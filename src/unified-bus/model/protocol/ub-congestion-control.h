@@ -4,6 +4,8 @@
 
 #include <stdexcept>
 #include "ns3/object.h"
+#include "ns3/nstime.h"
+#include "ns3/data-rate.h"
 #include "ns3/ub-switch.h"
 #include "ns3/ub-header.h"
 #include "ns3/ub-datatype.h"
@@ -11,7 +13,7 @@ namespace ns3 {
 
 class UbTransportChannel;
 
-// Currently only CAQM is implemented, other algorithms to be added
+// Currently CAQM and DCQCN are implemented, other algorithms to be added
 enum CongestionCtrlAlgo {
     CAQM,
     LDCP,
@@ -20,7 +22,7 @@ enum CongestionCtrlAlgo {
 
 /**
  * @brief UB Congestion control parent class.
- * Only Caqm can be used now.
+ * Caqm (window based) and Dcqcn (rate based) can be used now.
  */
 class UbCongestionControl : public Object {
 public:
@@ -33,6 +35,12 @@ public:
     // 获取剩余窗口，CAQM LDCP需要
     virtual uint32_t GetRestCwnd() {return UB_MTU_BYTE;}
 
+    // 获取发送size字节前还需等待的时间，DCQCN等速率类算法需要
+    virtual Time GetSendDelay(uint32_t size) {return Time(0);}
+
+    // 获取建议的pacing速率，窗口类算法按cwnd/RTT估算，0表示无估计
+    virtual DataRate GetPacingRate() {return DataRate(0);}
+
     // 发送端生成networkHeader包头
     virtual UbNetworkHeader SenderGenNetworkHeader()
     {
@@ -57,6 +65,12 @@ public:
     // 发送端收到ack，调整窗口、速率等数据
     virtual void SenderRecvAck(uint32_t psn, UbCongestionExtTph header) {}
 
+    // 接收端收到数据包后判断是否需要回复CNP
+    virtual bool RecverCheckCnp(UbNetworkHeader header) {return false;}
+
+    // 发送端收到CNP，调整速率
+    virtual void SenderRecvCnp() {}
+
     // 绑定switch，初始化参数
     virtual void SwitchInit(Ptr<UbSwitch> sw) {}
 
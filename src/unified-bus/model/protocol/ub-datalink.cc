@@ -39,13 +39,14 @@ UbDatalinkPacketHeader UbDataLink::ParsePacketHeader(Ptr<Packet> p)
     return header;
 }
 
-Ptr<Packet> UbDataLink::GenControlCreditPacket(const uint8_t credits[16])
+Ptr<Packet> UbDataLink::GenControlCreditPacket(const uint8_t credits[16], bool cellGrain)
 {
     Ptr<Packet> p = Create<Packet>(0);
     UbDatalinkControlCreditHeader controlCreditHeader;
     controlCreditHeader.SetAllCreditsVL(credits);
     controlCreditHeader.SetSD(1);
     controlCreditHeader.SetType(1);
+    controlCreditHeader.SetCellGrain(cellGrain);
     p->AddHeader(controlCreditHeader);
     return p;
 }
@@ -0,0 +1,347 @@
+// SPDX-License-Identifier: GPL-2.0-only
+#include <cmath>
+#include "ns3/log.h"
+#include "ns3/double.h"
+#include "ns3/uinteger.h"
+#include "ns3/data-rate.h"
+#include "ns3/ub-switch.h"
+#include "ns3/ub-transport.h"
+#include "ns3/ub-port.h"
+#include "ns3/ub-dcqcn.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE("UbDcqcn");
+NS_OBJECT_ENSURE_REGISTERED(UbDcqcn);
+
+// Dcqcn父类
+TypeId UbDcqcn::GetTypeId(void)
+{
+    static TypeId tid =
+        TypeId("ns3::UbDcqcn")
+            .SetParent<ns3::UbCongestionControl>()
+            .AddConstructor<UbDcqcn>()
+            .AddAttribute("UbDcqcnG",
+                          "g, alpha update gain",
+                          DoubleValue(1.0 / 256),
+                          MakeDoubleAccessor(&UbDcqcn::m_g),
+                          MakeDoubleChecker<double>(0.0, 1.0))
+            .AddAttribute("UbDcqcnInitAlpha",
+                          "Initial alpha",
+                          DoubleValue(1.0),
+                          MakeDoubleAccessor(&UbDcqcn::m_initAlpha),
+                          MakeDoubleChecker<double>(0.0, 1.0))
+            .AddAttribute("UbDcqcnAlphaUpdatePeriod",
+                          "Alpha decay period when no cnp received",
+                          TimeValue(MicroSeconds(55)),
+                          MakeTimeAccessor(&UbDcqcn::m_alphaUpdatePeriod),
+                          MakeTimeChecker())
+            .AddAttribute("UbDcqcnRateDecreaseInterval",
+                          "Minimum interval between two rate decreases",
+                          TimeValue(MicroSeconds(4)),
+                          MakeTimeAccessor(&UbDcqcn::m_rateDecreaseInterval),
+                          MakeTimeChecker())
+            .AddAttribute("UbDcqcnRateIncreaseTimer",
+                          "Rate increase timer period",
+                          TimeValue(MicroSeconds(55)),
+                          MakeTimeAccessor(&UbDcqcn::m_rateIncreaseTimer),
+                          MakeTimeChecker())
+            .AddAttribute("UbDcqcnByteCounter",
+                          "Rate increase byte counter threshold",
+                          UintegerValue(10 * 1024 * 1024),
+                          MakeUintegerAccessor(&UbDcqcn::m_byteCounter),
+                          MakeUintegerChecker<uint64_t>())
+            .AddAttribute("UbDcqcnFastRecoveryTimes",
+                          "F, number of fast recovery stages",
+                          UintegerValue(5),
+                          MakeUintegerAccessor(&UbDcqcn::m_fastRecoveryTimes),
+                          MakeUintegerChecker<uint32_t>())
+            .AddAttribute("UbDcqcnRateAI",
+                          "Additive increase rate step",
+                          DataRateValue(DataRate("100Mbps")),
+                          MakeDataRateAccessor(&UbDcqcn::m_rateAI),
+                          MakeDataRateChecker())
+            .AddAttribute("UbDcqcnRateHAI",
+                          "Hyper increase rate step",
+                          DataRateValue(DataRate("1Gbps")),
+                          MakeDataRateAccessor(&UbDcqcn::m_rateHAI),
+                          MakeDataRateChecker())
+            .AddAttribute("UbDcqcnMinRate",
+                          "Rate low limit",
+                          DataRateValue(DataRate("100Mbps")),
+                          MakeDataRateAccessor(&UbDcqcn::m_minRate),
+                          MakeDataRateChecker())
+            .AddAttribute("UbDcqcnCnpInterval",
+                          "Minimum interval between two cnps of one tp at receiver",
+                          TimeValue(MicroSeconds(50)),
+                          MakeTimeAccessor(&UbDcqcn::m_cnpInterval),
+                          MakeTimeChecker());
+    return tid;
+}
+
+UbDcqcn::UbDcqcn()
+{
+}
+
+UbDcqcn::~UbDcqcn()
+{
+}
+
+// host
+
+NS_OBJECT_ENSURE_REGISTERED(UbHostDcqcn);
+
+TypeId UbHostDcqcn::GetTypeId(void)
+{
+    static TypeId tid =
+        TypeId("ns3::UbHostDcqcn")
+            .SetParent<ns3::UbDcqcn>()
+            .AddConstructor<UbHostDcqcn>()
+            .AddAttribute("UbDcqcnBucketSize",
+                          "Token bucket depth in byte when rate limited",
+                          UintegerValue(UB_MTU_BYTE),
+                          MakeUintegerAccessor(&UbHostDcqcn::m_bucketSize),
+                          MakeUintegerChecker<uint32_t>());
+    return tid;
+}
+
+UbHostDcqcn::UbHostDcqcn()
+{
+    m_nodeType = UB_DEVICE;
+}
+
+UbHostDcqcn::~UbHostDcqcn()
+{
+    NS_LOG_FUNCTION(this);
+}
+
+void UbHostDcqcn::TpInit(Ptr<UbTransportChannel> tp)
+{
+    m_src = tp->GetSrc();
+    m_dst = tp->GetDest();
+    m_tpn = tp->GetTpn();
+    auto port = DynamicCast<UbPort>(NodeList::GetNode(m_src)->GetDevice(tp->GetSport()));
+    m_maxRate = port->GetDataRate();
+    m_curRate = m_maxRate;
+    m_targetRate = m_maxRate;
+    m_alpha = m_initAlpha;
+}
+
+void UbHostDcqcn::RefillTokens()
+{
+    Time now = Simulator::Now();
+    m_tokens += (now - m_lastRefill).GetSeconds() * m_curRate.GetBitRate() / 8;
+    if (m_tokens > m_bucketSize) {
+        m_tokens = m_bucketSize;
+    }
+    m_lastRefill = now;
+}
+
+// 未限速时直接返回0，不维护令牌桶
+Time UbHostDcqcn::GetSendDelay(uint32_t size)
+{
+    if (!m_congestionCtrlEnabled || !IsRateLimited()) {
+        return Time(0);
+    }
+    RefillTokens();
+    if (m_tokens >= size) {
+        return Time(0);
+    }
+    return m_curRate.CalculateBytesTxTime(uint32_t(std::ceil(size - m_tokens)));
+}
+
+UbNetworkHeader UbHostDcqcn::SenderGenNetworkHeader()
+{
+    UbNetworkHeader networkHeader;
+    if (m_congestionCtrlEnabled) {
+        networkHeader.SetMode(UB_NETWORK_HEADER_MODE_FECN);
+        networkHeader.SetFecn(UB_FECN_ECT);
+    }
+    return networkHeader;
+}
+
+void UbHostDcqcn::SenderUpdateCongestionCtrlData(uint32_t psn, uint32_t size)
+{
+    if (!m_congestionCtrlEnabled || !IsRateLimited()) {
+        return;
+    }
+    RefillTokens();
+    m_tokens -= size;
+    m_bytesSinceIncrease += size;
+    if (m_bytesSinceIncrease >= m_byteCounter) {
+        m_bytesSinceIncrease = 0;
+        m_byteStage++;
+        RateIncrease();
+    }
+}
+
+bool UbHostDcqcn::RecverCheckCnp(UbNetworkHeader header)
+{
+    if (!m_congestionCtrlEnabled || header.GetMode() != UB_NETWORK_HEADER_MODE_FECN
+        || header.GetFecn() != UB_FECN_CE) {
+        return false;
+    }
+    if (m_cnpSent && Simulator::Now() - m_lastCnpSent < m_cnpInterval) {
+        return false;
+    }
+    m_cnpSent = true;
+    m_lastCnpSent = Simulator::Now();
+    NS_LOG_DEBUG("[" << GetTypeId().GetName() << "]"
+              << "[Debug]"
+              << "[" << __FUNCTION__ << "]"
+              << " Gen cnp. Local:" << m_src
+              << " send back to:" << m_dst
+              << " tpn:" << m_tpn);
+    return true;
+}
+
+UbCongestionExtTph UbHostDcqcn::RecverGenAckCeTphHeader(uint32_t psnStart, uint32_t psnEnd)
+{
+    UbCongestionExtTph cetph;
+    cetph.SetAckSequence(0);
+    cetph.SetC(0);
+    cetph.SetI(0);
+    cetph.SetHint(0);
+    return cetph;
+}
+
+void UbHostDcqcn::SenderRecvCnp()
+{
+    if (!m_congestionCtrlEnabled) {
+        return;
+    }
+    Time now = Simulator::Now();
+    // alpha = (1 - g) * alpha + g
+    m_alpha = (1 - m_g) * m_alpha + m_g;
+    if (m_decreased && now - m_lastDecrease < m_rateDecreaseInterval) {
+        return;
+    }
+    if (!IsRateLimited()) {
+        // 首次进入限速状态，令牌桶从满桶开始
+        m_tokens = m_bucketSize;
+        m_lastRefill = now;
+    } else {
+        RefillTokens();
+    }
+    DataRate oldRate = m_curRate;
+    m_targetRate = m_curRate;
+    uint64_t newRate = uint64_t(m_curRate.GetBitRate() * (1 - m_alpha / 2));
+    m_curRate = DataRate(std::max(newRate, m_minRate.GetBitRate()));
+    m_decreased = true;
+    m_lastDecrease = now;
+    m_timerStage = 0;
+    m_byteStage = 0;
+    m_bytesSinceIncrease = 0;
+    NS_LOG_DEBUG("[" << GetTypeId().GetName() << "]"
+              << "[Debug]"
+              << "[" << __FUNCTION__ << "]"
+              << " Recv cnp. Local:" << m_src
+              << " Tpn:" << m_tpn
+              << " Alpha:" << m_alpha
+              << " Rate decrease:" << oldRate
+              << "->" << m_curRate);
+    m_alphaEvent.Cancel();
+    m_alphaEvent = Simulator::Schedule(m_alphaUpdatePeriod, &UbHostDcqcn::UpdateAlpha, this);
+    m_increaseEvent.Cancel();
+    m_increaseEvent = Simulator::Schedule(m_rateIncreaseTimer, &UbHostDcqcn::RateIncreaseTimeout, this);
+}
+
+// 一个周期内没有收到CNP，alpha衰减
+void UbHostDcqcn::UpdateAlpha()
+{
+    m_alpha = (1 - m_g) * m_alpha;
+    if (IsRateLimited()) {
+        m_alphaEvent = Simulator::Schedule(m_alphaUpdatePeriod, &UbHostDcqcn::UpdateAlpha, this);
+    }
+}
+
+void UbHostDcqcn::RateIncreaseTimeout()
+{
+    m_timerStage++;
+    RateIncrease();
+    if (IsRateLimited()) {
+        m_increaseEvent = Simulator::Schedule(m_rateIncreaseTimer, &UbHostDcqcn::RateIncreaseTimeout, this);
+    }
+}
+
+void UbHostDcqcn::RateIncrease()
+{
+    RefillTokens();
+    DataRate oldRate = m_curRate;
+    uint32_t maxStage = std::max(m_timerStage, m_byteStage);
+    uint32_t minStage = std::min(m_timerStage, m_byteStage);
+    if (maxStage < m_fastRecoveryTimes) {
+        // 快速恢复：Rc = (Rt + Rc) / 2
+    } else if (minStage > m_fastRecoveryTimes) {
+        // 超级增速
+        m_targetRate = DataRate(m_targetRate.GetBitRate() + m_rateHAI.GetBitRate());
+    } else {
+        // 加性增速
+        m_targetRate = DataRate(m_targetRate.GetBitRate() + m_rateAI.GetBitRate());
+    }
+    if (m_targetRate > m_maxRate) {
+        m_targetRate = m_maxRate;
+    }
+    m_curRate = DataRate((m_targetRate.GetBitRate() + m_curRate.GetBitRate()) / 2);
+    // 速率接近线速时恢复到不限速状态，停止所有定时器
+    if (m_maxRate.GetBitRate() - m_curRate.GetBitRate() <= m_rateAI.GetBitRate()) {
+        m_curRate = m_maxRate;
+        m_targetRate = m_maxRate;
+        StopTimers();
+    }
+    NS_LOG_DEBUG("[" << GetTypeId().GetName() << "]"
+              << "[Debug]"
+              << "[" << __FUNCTION__ << "]"
+              << " Local:" << m_src
+              << " Tpn:" << m_tpn
+              << " TimerStage:" << m_timerStage
+              << " ByteStage:" << m_byteStage
+              << " Rate increase:" << oldRate
+              << "->" << m_curRate);
+}
+
+void UbHostDcqcn::StopTimers()
+{
+    m_alphaEvent.Cancel();
+    m_increaseEvent.Cancel();
+    m_timerStage = 0;
+    m_byteStage = 0;
+    m_bytesSinceIncrease = 0;
+}
+
+void UbHostDcqcn::DoDispose()
+{
+    NS_LOG_FUNCTION(this);
+    StopTimers();
+    Object::DoDispose();
+}
+
+// switch
+
+NS_OBJECT_ENSURE_REGISTERED(UbSwitchDcqcn);
+
+UbSwitchDcqcn::UbSwitchDcqcn()
+{
+    m_nodeType = UB_SWITCH;
+}
+
+UbSwitchDcqcn::~UbSwitchDcqcn()
+{
+    NS_LOG_FUNCTION(this);
+}
+
+TypeId UbSwitchDcqcn::GetTypeId(void)
+{
+    static TypeId tid =
+        TypeId("ns3::UbSwitchDcqcn")
+            .SetParent<ns3::UbDcqcn>()
+            .AddConstructor<UbSwitchDcqcn>();
+    return tid;
+}
+
+void UbSwitchDcqcn::SwitchInit(Ptr<UbSwitch> sw)
+{
+    sw->SetCongestionCtrl(this);
+}
+
+}
@@ -0,0 +1,125 @@
+// SPDX-License-Identifier: GPL-2.0-only
+#ifndef UB_DCQCN_H
+#define UB_DCQCN_H
+#include "ns3/ub-congestion-control.h"
+#include "ns3/ptr.h"
+#include "ns3/packet.h"
+#include "ns3/ub-switch.h"
+#include "ns3/ub-header.h"
+#include "ns3/simulator.h"
+#include "ns3/data-rate.h"
+#include "ns3/event-id.h"
+namespace ns3 {
+class UbNetworkHeader;
+class UbSwitch;
+class UbTransportChannel;
+
+/**
+ * @brief DCQCN algo, inherit from UbCongestionControl,
+ * define some params that dcqcn algo used.
+ * Switch marks FECN by egress occupancy (see UbQueueManager::CheckEcnMark),
+ * receiver (NP) returns CNP, sender (RP) adjusts rate and paces by token bucket.
+ */
+class UbDcqcn : public UbCongestionControl {
+public:
+    UbDcqcn();
+    ~UbDcqcn() override;
+    static TypeId GetTypeId(void);
+
+protected:
+    UbNodeType_t m_nodeType;        // 所属节点的类型
+
+    double m_g;                     // alpha更新系数 g
+    double m_initAlpha;             // alpha初始值
+    Time m_alphaUpdatePeriod;       // alpha衰减周期
+    Time m_rateDecreaseInterval;    // 两次降速的最小间隔
+    Time m_rateIncreaseTimer;       // 升速定时器周期
+    uint64_t m_byteCounter;         // 升速字节计数器阈值
+    uint32_t m_fastRecoveryTimes;   // 快速恢复阶段次数 F
+    DataRate m_rateAI;              // 加性增速步长
+    DataRate m_rateHAI;             // 超级增速步长
+    DataRate m_minRate;             // 速率下限
+    Time m_cnpInterval;             // 接收端同一条流两个CNP的最小间隔
+};
+
+/**
+ * @brief DCQCN algo host part, act as both RP (sender) and NP (receiver) of a TP.
+ */
+class UbHostDcqcn : public UbDcqcn {
+public:
+    UbHostDcqcn();
+    ~UbHostDcqcn() override;
+    static TypeId GetTypeId(void);
+
+    // 初始化，速率上限取TP出端口带宽
+    void TpInit(Ptr<UbTransportChannel> tp) override;
+
+    // 令牌桶不足时返回需要等待的时间
+    Time GetSendDelay(uint32_t size) override;
+
+    // 发送端生成拥塞控制算法需要的header，数据包标记为ECT
+    UbNetworkHeader SenderGenNetworkHeader() override;
+
+    // 发送端发包，消耗令牌并累计字节计数器
+    void SenderUpdateCongestionCtrlData(uint32_t psn, uint32_t size) override;
+
+    // 接收端收到数据包，判断是否需要回复CNP
+    bool RecverCheckCnp(UbNetworkHeader header) override;
+
+    // DCQCN不依赖ack携带的拥塞信息
+    UbCongestionExtTph RecverGenAckCeTphHeader(uint32_t psnStart, uint32_t psnEnd) override;
+
+    // 发送端收到CNP，降速
+    void SenderRecvCnp() override;
+
+    DataRate GetCurrentRate() const { return m_curRate; }
+
+private:
+    void DoDispose() override;
+
+    bool IsRateLimited() const { return m_curRate < m_maxRate; }
+    void RefillTokens();
+    void UpdateAlpha();
+    void RateIncreaseTimeout();
+    void RateIncrease();
+    void StopTimers();
+
+    uint32_t m_src;
+    uint32_t m_dst;
+    uint32_t m_tpn;
+
+    DataRate m_maxRate;                 // 线速
+    DataRate m_curRate;                 // 当前速率 Rc
+    DataRate m_targetRate;              // 目标速率 Rt
+    double m_alpha;
+    uint32_t m_bucketSize;              // 令牌桶深度(字节)
+    double m_tokens = 0;                // 当前令牌(字节)
+    Time m_lastRefill;
+
+    uint32_t m_timerStage = 0;          // 定时器触发升速次数
+    uint32_t m_byteStage = 0;           // 字节计数器触发升速次数
+    uint64_t m_bytesSinceIncrease = 0;
+    Time m_lastDecrease;
+    bool m_decreased = false;
+
+    EventId m_alphaEvent{};
+    EventId m_increaseEvent{};
+
+    Time m_lastCnpSent;
+    bool m_cnpSent = false;
+};
+
+/**
+ * @brief DCQCN algo switch part. ECN marking itself is done by UbSwitch egress,
+ * this class only binds the algo to the switch.
+ */
+class UbSwitchDcqcn : public UbDcqcn {
+public:
+    static TypeId GetTypeId(void);
+    UbSwitchDcqcn();
+    ~UbSwitchDcqcn() override;
+    // 初始化
+    void SwitchInit(Ptr<UbSwitch> sw) override;
+};
+}
+#endif
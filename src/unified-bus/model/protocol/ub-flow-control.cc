@@ -43,9 +43,17 @@ void UbCbfc::Init(uint8_t flitLen, uint8_t nFlitPerCell, uint8_t retCellGrainDat
     NS_LOG_DEBUG("m_crdTxfree[*]: " << m_crdTxfree[0]);
 }
 
+void UbCbfc::SetCreditBatching(bool enable, Time interval, uint32_t flushGrains)
+{
+    m_crdBatchEnable = enable;
+    m_crdReturnInterval = interval;
+    m_crdFlushGrains = flushGrains;
+}
+
 void UbCbfc::DoDispose()
 {
     NS_LOG_FUNCTION(this);
+    m_crdReturnEvent.Cancel();
     delete m_cbfcCfg;
 
     Object::DoDispose();
@@ -83,6 +91,12 @@ bool UbCbfc::IsFcLimited(Ptr<UbIngressQueue> ingressQ)
 void UbCbfc::HandleReleaseOccupiedFlowControl(Ptr<Packet> p, uint32_t inPortId, uint32_t outPortId)
 {
     if (inPortId != outPortId) { // 转发的报文
+        if (m_crdBatchEnable) {
+            // 信用证记在入端口上, 由入端口捎带或批量返回
+            Ptr<UbPort> inPort = DynamicCast<UbPort>(NodeList::GetNode(m_nodeId)->GetDevice(inPortId));
+            DynamicCast<UbCbfc>(inPort->GetFlowControl())->AccumulateCrdToReturn(p);
+            return;
+        }
         Ptr<Packet> cbfcPkt = ReleaseOccupiedCrd(p, inPortId);
         if (cbfcPkt != nullptr) {
             SendCrdAck(cbfcPkt, inPortId);
@@ -111,9 +125,10 @@ void UbCbfc::HandleReceivedControlPacket(Ptr<Packet> p)
 
 void UbCbfc::HandleReceivedPacket(Ptr<Packet> p)
 {
-    Ptr<Node> node = NodeList::GetNode(m_nodeId);
-    Ptr<UbPort> port = DynamicCast<UbPort>(node->GetDevice(m_portId));
-
+    if (m_crdBatchEnable) {
+        AccumulateCrdToReturn(p);
+        return;
+    }
     Ptr<Packet> cbfcPkt = ReleaseOccupiedCrd(p, m_portId);
     if (cbfcPkt != nullptr) {
         SendCrdAck(cbfcPkt, m_portId);
@@ -190,11 +205,13 @@ bool UbCbfc::CbfcRestoreCrd(Ptr<Packet> p)
         NS_LOG_DEBUG("port m_credits[ " << (uint32_t)index << " ]: " << (uint32_t)port->m_credits[index]);
     }
 
+    // 批量返回的余量帧以cell为单位
+    uint32_t grain = crdHeader.GetCellGrain() ? 1 : m_cbfcCfg->m_retCellGrainControlPacket;
     for (int index = 0; index < ubVlNum; index++) {
         if (port->m_credits[index] > 0) {
             ResumeCellGrainNum = port->m_credits[index];
             NS_LOG_DEBUG("before resume m_crdTxfree[ " << (uint32_t)index << " ]: " << m_crdTxfree[index]);
-            m_crdTxfree[index] += ResumeCellGrainNum * m_cbfcCfg->m_retCellGrainControlPacket;  // 粒度数量 * 粒度大小
+            m_crdTxfree[index] += ResumeCellGrainNum * grain;  // 粒度数量 * 粒度大小
             NS_LOG_DEBUG("left m_crdTxfree[ " << (uint32_t)index << " ]: " << m_crdTxfree[index]);
             ret = true;
         }
@@ -265,6 +282,141 @@ Ptr<Packet> UbCbfc::ReleaseOccupiedCrd(Ptr<Packet> p, uint32_t targetPortId)
     return cbfcPkt;
 }
 
+int32_t UbCbfc::GetConsumeCell(Ptr<Packet> p)
+{
+    return ceil((float)(p->GetSize()) / (m_cbfcCfg->m_flitLen * m_cbfcCfg->m_nFlitPerCell));
+}
+
+/**
+ * @brief 批量模式下累计待返回信用证，积累到m_crdFlushGrains个控制粒度立即发送，否则等待捎带或超时
+ */
+void UbCbfc::AccumulateCrdToReturn(Ptr<Packet> p)
+{
+    UbDatalinkPacketHeader pktHeader;
+    p->PeekHeader(pktHeader);
+    uint8_t vlId = pktHeader.GetPacketVL();
+    m_crdToReturn[vlId] += GetConsumeCell(p);
+    NS_LOG_DEBUG("NodeId: " << m_nodeId << " PortId: " << m_portId
+                 << " m_crdToReturn[ " << (uint32_t)vlId << " ]: " << m_crdToReturn[vlId]);
+    if (m_crdToReturn[vlId] >= (int32_t)(m_crdFlushGrains * m_cbfcCfg->m_retCellGrainControlPacket)) {
+        FlushCrdToReturn(false);
+        return;
+    }
+    if (!m_crdReturnEvent.IsPending()) {
+        m_crdReturnEvent = Simulator::Schedule(m_crdReturnInterval, &UbCbfc::FlushCrdToReturn, this, true);
+    }
+}
+
+/**
+ * @brief 按控制粒度生成信用证控制帧, 只返回整粒度的信用证. cellGrain时改为以cell为单位
+ * 返回不足一个控制粒度的余量, 用于链路空闲后精确返回全部信用证
+ */
+Ptr<Packet> UbCbfc::GenCreditReturnPacket(bool cellGrain)
+{
+    // 控制帧每个VL的Credit Number为6位
+    const int32_t maxCreditNum = 0x3F;
+    uint8_t credits[16] = {0};
+    bool shouldReturnCredit = false;
+    int32_t grain = m_cbfcCfg->m_retCellGrainControlPacket;
+    for (uint32_t index = 0; index < m_crdToReturn.size() && index < 16; index++) {
+        int32_t num = 0;
+        if (!cellGrain) {
+            num = std::min(m_crdToReturn[index] / grain, maxCreditNum);
+        } else if (m_crdToReturn[index] < grain) {
+            num = std::min(m_crdToReturn[index], maxCreditNum);
+        }
+        if (num > 0) {
+            credits[index] = num;
+            m_crdToReturn[index] -= num * (cellGrain ? 1 : grain);
+            shouldReturnCredit = true;
+        }
+    }
+    return shouldReturnCredit ? UbDataLink::GenControlCreditPacket(credits, cellGrain) : nullptr;
+}
+
+void UbCbfc::FlushCrdToReturn(bool flushRemainder)
+{
+    m_crdReturnEvent.Cancel();
+    Ptr<Packet> cbfcPkt = GenCreditReturnPacket(false);
+    if (cbfcPkt != nullptr) {
+        NS_LOG_DEBUG("NodeId: " << m_nodeId << " PortId: " << m_portId << " flush crd pkt");
+        SendCrdAck(cbfcPkt, m_portId);
+    }
+    // 超时时余量不再等待凑满粒度
+    if (flushRemainder) {
+        cbfcPkt = GenCreditReturnPacket(true);
+        if (cbfcPkt != nullptr) {
+            NS_LOG_DEBUG("NodeId: " << m_nodeId << " PortId: " << m_portId << " flush remainder crd pkt");
+            SendCrdAck(cbfcPkt, m_portId);
+        }
+    }
+    for (auto crd : m_crdToReturn) {
+        if (crd > 0) {
+            m_crdReturnEvent = Simulator::Schedule(m_crdReturnInterval, &UbCbfc::FlushCrdToReturn, this, true);
+            break;
+        }
+    }
+}
+
+/**
+ * @brief 数据包链路层头的Credit位捎带一个数据包粒度的信用证，选择积压最多的VL
+ */
+void UbCbfc::PiggybackCredit(Ptr<Packet> p)
+{
+    if (!m_crdBatchEnable) {
+        return;
+    }
+    UbDatalinkHeader dlHeader;
+    p->PeekHeader(dlHeader);
+    if (dlHeader.IsControlCreditHeader()) {
+        return;
+    }
+    UbDatalinkPacketHeader pktHeader;
+    p->RemoveHeader(pktHeader);
+    int32_t grain = m_cbfcCfg->m_retCellGrainDataPacket;
+    int32_t maxCrd = 0;
+    uint32_t targetVl = 0;
+    for (uint32_t index = 0; index < m_crdToReturn.size(); index++) {
+        if (m_crdToReturn[index] > maxCrd) {
+            maxCrd = m_crdToReturn[index];
+            targetVl = index;
+        }
+    }
+    if (maxCrd >= grain) {
+        pktHeader.SetCredit(true);
+        pktHeader.SetCreditTargetVL(targetVl);
+        m_crdToReturn[targetVl] -= grain;
+        NS_LOG_DEBUG("NodeId: " << m_nodeId << " PortId: " << m_portId
+                     << " piggyback crd VL: " << targetVl << " left: " << m_crdToReturn[targetVl]);
+    } else {
+        pktHeader.SetCredit(false);
+    }
+    p->AddHeader(pktHeader);
+}
+
+void UbCbfc::HandlePiggybackCredit(Ptr<Packet> p)
+{
+    if (!m_crdBatchEnable) {
+        return;
+    }
+    UbDatalinkHeader dlHeader;
+    p->PeekHeader(dlHeader);
+    if (dlHeader.IsControlCreditHeader()) {
+        return;
+    }
+    UbDatalinkPacketHeader pktHeader;
+    p->PeekHeader(pktHeader);
+    if (!pktHeader.GetCredit()) {
+        return;
+    }
+    uint8_t vlId = pktHeader.GetCreditTargetVL();
+    m_crdTxfree[vlId] += m_cbfcCfg->m_retCellGrainDataPacket;
+    NS_LOG_DEBUG("NodeId: " << m_nodeId << " PortId: " << m_portId
+                 << " recv piggyback crd, m_crdTxfree[ " << (uint32_t)vlId << " ]: " << m_crdTxfree[vlId]);
+    Ptr<UbPort> port = DynamicCast<UbPort>(NodeList::GetNode(m_nodeId)->GetDevice(m_portId));
+    Simulator::ScheduleNow(&UbPort::TriggerTransmit, port);
+}
+
 FcType UbCbfc::GetFcType()
 {
     return m_fcType;
@@ -422,8 +574,14 @@ Ptr<Packet> UbPfc::CheckPfcThreshold(Ptr<Packet> p, uint32_t portId)
     IntegerValue val;
     g_ub_vl_num.GetValue(val);
     int ubVlNum = val.Get();
+    auto queueManager = node->GetObject<UbSwitch>()->GetQueueManager();
+    if (queueManager->IsSharedBufferEnable()) {
+        // 共享缓存模式下按动态门限暂停, 超出部分由headroom吸收, 恢复门限保持配置的比例
+        uint64_t dynThresh = std::min<uint64_t>(queueManager->GetDynamicThreshold(), UINT32_MAX);
+        lo_thresh = hi_thresh > 0 ? static_cast<uint32_t>(dynThresh * lo_thresh / hi_thresh) : 0;
+        hi_thresh = static_cast<uint32_t>(dynThresh);
+    }
     for (int pri = 0; pri < ubVlNum; pri++) {
-        auto queueManager = node->GetObject<UbSwitch>()->GetQueueManager();
         if (queueManager->GetIngressUsed(portId, pri) < lo_thresh) {
             NS_LOG_DEBUG("ingressBuf[ " << pri << " ]: " << queueManager->GetIngressUsed(portId, pri)
                          << " < lo_thresh: " << lo_thresh << " m_pfcSndCredits: "
@@ -55,6 +55,9 @@ public:
     virtual void HandleSentPacket(Ptr<Packet> p, Ptr<UbIngressQueue> ingressQ) {}
     virtual void HandleReceivedControlPacket(Ptr<Packet> p) {}
     virtual void HandleReceivedPacket(Ptr<Packet> p) {}
+    // 发送数据包时在链路层头中捎带信用证; 接收数据包时取出捎带的信用证
+    virtual void PiggybackCredit(Ptr<Packet> p) {}
+    virtual void HandlePiggybackCredit(Ptr<Packet> p) {}
     virtual FcType GetFcType()
     {
         return FcType::UBFC;
@@ -82,6 +85,7 @@ public:
     virtual void HandleReceivedControlPacket(Ptr<Packet> p) override;
     virtual void HandleReceivedPacket(Ptr<Packet> p) override;
     int32_t GetCrdToReturn(uint8_t vlId);
+    int32_t GetCrdTxfree(uint8_t vlId) { return m_crdTxfree[vlId]; }
     void SetCrdToReturn(uint8_t vlId, int32_t consumeCell, Ptr<UbPort> targetPort);
     void UpdateCrdToReturn(uint8_t vlId, int32_t consumeCell, Ptr<UbPort> targetPort);
     bool CbfcConsumeCrd(Ptr<Packet> p);
@@ -89,7 +93,17 @@ public:
     void SendCrdAck(Ptr<Packet> cbfcPkt, uint32_t targetPortId);
     Ptr<Packet> ReleaseOccupiedCrd(Ptr<Packet> p, uint32_t targetPortId);
 
+    // 信用证批量返回: 优先捎带在反向数据包上, 超时或积累到flushGrains个控制粒度时才发送信用证控制帧
+    void SetCreditBatching(bool enable, Time interval, uint32_t flushGrains);
+    virtual void PiggybackCredit(Ptr<Packet> p) override;
+    virtual void HandlePiggybackCredit(Ptr<Packet> p) override;
+
 private:
+    int32_t GetConsumeCell(Ptr<Packet> p);
+    Ptr<Packet> GenCreditReturnPacket(bool cellGrain);
+    void AccumulateCrdToReturn(Ptr<Packet> p);
+    void FlushCrdToReturn(bool flushRemainder);
+
     FcType m_fcType { FcType::CBFC };
     void DoDispose() override;
     uint32_t m_portId;
@@ -108,6 +122,11 @@ private:
     cbfcCfg_t *m_cbfcCfg;                   // cbfc相关配置
     std::vector<int32_t>  m_crdTxfree;      // 发送端口每个vl信用证
     std::vector<int32_t>  m_crdToReturn;    // 用于记录每个vl需要返回的信用证
+
+    bool m_crdBatchEnable = false;
+    Time m_crdReturnInterval;
+    uint32_t m_crdFlushGrains = 0;
+    EventId m_crdReturnEvent;
 };
 
 /**
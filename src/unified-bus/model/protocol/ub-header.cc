@@ -61,6 +61,11 @@ bool UbDatalinkHeader::IsPacketUbMemHeader() const
     return m_config == static_cast<uint8_t>(UbDatalinkHeaderConfig::PACKET_UB_MEM);
 }
 
+bool UbDatalinkHeader::IsPacketUbMemCna24Header() const
+{
+    return m_config == static_cast<uint8_t>(UbDatalinkHeaderConfig::PACKET_CNA24);
+}
+
 TypeId UbDatalinkHeader::GetTypeId(void)
 {
     static TypeId tid = TypeId("ns3::UbDatalinkHeader")
@@ -202,6 +207,16 @@ bool UbDatalinkControlCreditHeader::GetType() const
     return m_type;
 }
 
+void UbDatalinkControlCreditHeader::SetCellGrain(bool cellGrain)
+{
+    m_cellGrain = cellGrain;
+}
+
+bool UbDatalinkControlCreditHeader::GetCellGrain() const
+{
+    return m_cellGrain;
+}
+
 uint16_t UbDatalinkControlCreditHeader::GetAckNumber() const
 {
     return m_ackNumber;
@@ -227,7 +242,8 @@ void UbDatalinkControlCreditHeader::Print(std::ostream& os) const
           std::dec << " config=" << static_cast<uint32_t>(m_config) <<
           " control=" << static_cast<uint32_t>(m_controlType) <<
           " subControl=" << static_cast<uint32_t>(m_subControlType) <<
-          " sd=" << m_sd << " type=" << m_type << " ackNum=" << m_ackNumber << " credits=[";
+          " sd=" << m_sd << " cellGrain=" << m_cellGrain << " type=" << m_type <<
+          " ackNum=" << m_ackNumber << " credits=[";
     for (int i = 0; i < 16; ++i) {
         if (i > 0) {
             os << ",";
@@ -258,8 +274,8 @@ void UbDatalinkControlCreditHeader::Serialize(Buffer::Iterator start) const
     uint8_t byte2 = ((m_controlType & 0xF) << 4) | (m_subControlType & 0xF);
     start.WriteU8(byte2);
 
-    // 字节3: [SD:1][Reserve:6][Type:1]
-    uint8_t byte3 = (m_sd ? 0x80 : 0) | ((reservE1Value & 0x3F) << 1) | (m_type ? 0x1 : 0);
+    // 字节3: [SD:1][Reserve:5][CellGrain:1][Type:1]
+    uint8_t byte3 = (m_sd ? 0x80 : 0) | ((reservE1Value & 0x1F) << 2) | (m_cellGrain ? 0x2 : 0) | (m_type ? 0x1 : 0);
     start.WriteU8(byte3);
 
     // 字节4-5: Ack Number (16 bits)
@@ -311,11 +327,12 @@ uint32_t UbDatalinkControlCreditHeader::Deserialize(Buffer::Iterator start)
     m_controlType = (byte2 >> 4) & 0xF;
     m_subControlType = byte2 & 0xF;
 
-    // 字节3: [SD:1][Reserve:6][Type:1]
+    // 字节3: [SD:1][Reserve:5][CellGrain:1][Type:1]
     uint8_t byte3 = start.ReadU8();
     m_sd = (byte3 & 0x80) != 0;
-    uint8_t reserve1 = (byte3 >> 1) & 0x3F; // 读取但不存储，因为是固定值
+    uint8_t reserve1 = (byte3 >> 2) & 0x1F; // 读取但不存储，因为是固定值
     (void)reserve1;
+    m_cellGrain = (byte3 & 0x2) != 0;
     m_type = (byte3 & 0x1) != 0;
 
     // 字节4-5: Ack Number
@@ -507,7 +524,8 @@ uint32_t UbDatalinkPacketHeader::Deserialize(Buffer::Iterator start)
 
     // 验证配置项
     if (config != uint8_t(UbDatalinkHeaderConfig::PACKET_IPV4) &&
-        config != uint8_t(UbDatalinkHeaderConfig::PACKET_UB_MEM)) {
+        config != uint8_t(UbDatalinkHeaderConfig::PACKET_UB_MEM) &&
+        config != uint8_t(UbDatalinkHeaderConfig::PACKET_CNA24)) {
         NS_LOG_WARN("Invalid config value in UbDatalinkPacketHeader: got "
                     << static_cast<uint32_t>(config));
     }
@@ -701,6 +719,11 @@ void UbNetworkHeader::SetFecn(uint8_t fecn)
 
 
 // Getters - 直接从raw13读取
+uint8_t UbNetworkHeader::GetMode() const
+{
+    return m_mode;
+}
+
 bool UbNetworkHeader::GetLocation() const
 {
     if (m_mode == 0 || m_mode == 2 || m_mode == 4) {
@@ -1326,23 +1349,26 @@ uint32_t UbCna16NetworkHeader::GetSerializedSize() const
 
 void UbCna16NetworkHeader::Print(std::ostream& os) const
 {
-    os << "SCNA=" << m_scna << " DCNA=" << m_dcna << " Mode=" << unsigned(m_mode);
+    os << "SCNA=" << m_scna << " DCNA=" << m_dcna;
+    PrintCcFields(os);
+}
+
+void UbCna16NetworkHeader::PrintCcFields(std::ostream& os) const
+{
+    os << " Mode=" << unsigned(m_mode);
     switch (m_mode) {
         case 0b000:
-            os << " Loc=" << m_ccFields.mode0.location << " En=" <<
-            m_ccFields.mode0.enable << " C=" << m_ccFields.mode0.c <<
-            " I=" << m_ccFields.mode0.i << " Hint=" << unsigned(m_ccFields.mode0.hint);
+            os << " Loc=" << GetLocation() << " En=" << GetEnable() << " C=" << GetC() <<
+            " I=" << GetI() << " Hint=" << unsigned(GetHint());
             break;
         case 0b010:
-            os << " Loc=" << m_ccFields.mode2.location << " TS=" <<
-            m_ccFields.mode2.timestamp << " FECN=" << unsigned(m_ccFields.mode2.fecn);
+            os << " Loc=" << GetLocation() << " TS=" << GetTimestamp() << " FECN=" << unsigned(GetFecn());
             break;
         case 0b100:
-            os << " Loc=" << m_ccFields.mode4.location <<
-            " FECN=" << unsigned(m_ccFields.mode4.fecn);
+            os << " Loc=" << GetLocation() << " FECN=" << unsigned(GetFecn());
             break;
         default:
-            os << " raw13=0x" << std::hex << m_ccFields.raw13 << std::dec;
+            os << " raw13=0x" << std::hex << m_ccRaw13 << std::dec;
             break;
     }
     os << " LB=" << unsigned(m_lb) << " SL=" <<
@@ -1353,26 +1379,36 @@ void UbCna16NetworkHeader::Serialize(Buffer::Iterator i) const
 {
     i.WriteU16(m_scna);
     i.WriteU16(m_dcna);
-    uint16_t ccField = ((m_mode & 0x7) << 13) | (m_ccFields.raw13 & 0x1FFF);
+    SerializeCcFields(i);
+}
+
+uint32_t UbCna16NetworkHeader::Deserialize(Buffer::Iterator i)
+{
+    m_scna = i.ReadU16();
+    m_dcna = i.ReadU16();
+    DeserializeCcFields(i);
+    return GetSerializedSize();
+}
+
+void UbCna16NetworkHeader::SerializeCcFields(Buffer::Iterator &i) const
+{
+    uint16_t ccField = ((m_mode & 0x7) << 13) | (m_ccRaw13 & 0x1FFF);
     i.WriteU16(ccField);
     i.WriteU8(m_lb);
     uint8_t b7 = ((m_serviceLevel & 0x0F) << 4) | ((m_management & 0x01) << 3) | (m_nlp & 0x07);
     i.WriteU8(b7);
 }
 
-uint32_t UbCna16NetworkHeader::Deserialize(Buffer::Iterator i)
+void UbCna16NetworkHeader::DeserializeCcFields(Buffer::Iterator &i)
 {
-    m_scna = i.ReadU16();
-    m_dcna = i.ReadU16();
     uint16_t ccField = i.ReadU16();
     m_mode = (ccField >> 13) & 0x7;
-    m_ccFields.raw13 = ccField & 0x1FFF;
+    m_ccRaw13 = ccField & 0x1FFF;
     m_lb = i.ReadU8();
     uint8_t b7 = i.ReadU8();
     m_serviceLevel = (b7 >> 4) & 0x0F;
     m_management = (b7 >> 3) & 0x01;
     m_nlp = b7 & 0x07;
-    return GetSerializedSize();
 }
 
 // Setters
@@ -1389,67 +1425,68 @@ void UbCna16NetworkHeader::SetDcna(uint16_t v)
 void UbCna16NetworkHeader::SetMode(uint8_t m)
 {
     m_mode = m & 0x7;
+    // CC字段按mode解释, 切换mode时清空
+    m_ccRaw13 = 0;
+}
+
+void UbCna16NetworkHeader::SetRaw13Bit(uint8_t bit, bool value)
+{
+    if (value) {
+        m_ccRaw13 |= (1 << bit);
+    } else {
+        m_ccRaw13 &= ~(1 << bit);
+    }
 }
 
 void UbCna16NetworkHeader::SetLocation(bool loc)
 {
-    switch (m_mode) {
-        case 0b000:
-            m_ccFields.mode0.location = loc;
-            break;
-        case 0b010:
-            m_ccFields.mode2.location = loc;
-            break;
-        case 0b100:
-            m_ccFields.mode4.location = loc;
-            break;
-        default:
-            break;
+    if (m_mode == 0b000 || m_mode == 0b010 || m_mode == 0b100) {
+        SetRaw13Bit(12, loc);
     }
 }
 
 void UbCna16NetworkHeader::SetEnable(bool en)
 {
     if (m_mode == 0b000) {
-        m_ccFields.mode0.enable = en;
+        SetRaw13Bit(10, en);
     }
 }
 
 void UbCna16NetworkHeader::SetC(bool c)
 {
     if (m_mode == 0b000) {
-        m_ccFields.mode0.c = c;
+        SetRaw13Bit(9, c);
     }
 }
 
 void UbCna16NetworkHeader::SetI(bool v)
 {
     if (m_mode == 0b000) {
-        m_ccFields.mode0.i = v;
+        SetRaw13Bit(8, v);
     }
 }
 
 void UbCna16NetworkHeader::SetHint(uint8_t h)
 {
     if (m_mode == 0b000) {
-        m_ccFields.mode0.hint = h & 0x7F;
+        m_ccRaw13 &= ~0x7F;
+        m_ccRaw13 |= (h & 0x7F);
     }
 }
 
 void UbCna16NetworkHeader::SetTimestamp(uint16_t ts)
 {
     if (m_mode == 0b010) {
-        m_ccFields.mode2.timestamp = ts & 0x03FF;
+        m_ccRaw13 &= ~(0x3FF << 2);
+        m_ccRaw13 |= ((ts & 0x3FF) << 2);
     }
 }
 
 void UbCna16NetworkHeader::SetFecn(uint8_t f)
 {
-    f &= 0x3;
-    if (m_mode == 0b010) {
-        m_ccFields.mode2.fecn = f;
-    } else if (m_mode == 0b100) {
-        m_ccFields.mode4.fecn = f;
+    if (m_mode == 0b010 || m_mode == 0b100) {
+        m_ccRaw13 &= ~0x03;
+        m_ccRaw13 |= (f & 0x03);
     }
 }
 
@@ -1486,50 +1523,41 @@ uint8_t UbCna16NetworkHeader::GetMode() const
 
 bool UbCna16NetworkHeader::GetLocation() const
 {
-    switch (m_mode) {
-        case 0b000:
-            return m_ccFields.mode0.location;
-        case 0b010:
-            return m_ccFields.mode2.location;
-        case 0b100:
-            return m_ccFields.mode4.location;
-        default:
-            return false;
+    if (m_mode == 0b000 || m_mode == 0b010 || m_mode == 0b100) {
+        return (m_ccRaw13 & (1 << 12)) != 0;
     }
+    return false;
 }
 
 bool UbCna16NetworkHeader::GetEnable() const
 {
-    return (m_mode == 0b000) ? m_ccFields.mode0.enable : false;
+    return (m_mode == 0b000) ? (m_ccRaw13 & (1 << 10)) != 0 : false;
 }
 
 bool UbCna16NetworkHeader::GetC() const
 {
-    return (m_mode == 0b000) ? m_ccFields.mode0.c : false;
+    return (m_mode == 0b000) ? (m_ccRaw13 & (1 << 9)) != 0 : false;
 }
 
 bool UbCna16NetworkHeader::GetI() const
 {
-    return (m_mode == 0b000) ? m_ccFields.mode0.i : false;
+    return (m_mode == 0b000) ? (m_ccRaw13 & (1 << 8)) != 0 : false;
 }
 
 uint8_t UbCna16NetworkHeader::GetHint() const
 {
-    return (m_mode == 0b000) ? m_ccFields.mode0.hint : 0;
+    return (m_mode == 0b000) ? m_ccRaw13 & 0x7F : 0;
 }
 
 uint16_t UbCna16NetworkHeader::GetTimestamp() const
 {
-    return (m_mode == 0b010) ? m_ccFields.mode2.timestamp : 0;
+    return (m_mode == 0b010) ? (m_ccRaw13 >> 2) & 0x3FF : 0;
 }
 
 uint8_t UbCna16NetworkHeader::GetFecn() const
 {
-    if (m_mode == 0b010) {
-        return m_ccFields.mode2.fecn;
-    }
-    if (m_mode == 0b100) {
-        return m_ccFields.mode4.fecn;
+    if (m_mode == 0b010 || m_mode == 0b100) {
+        return m_ccRaw13 & 0x03;
     }
     return 0;
 }
@@ -1561,6 +1589,71 @@ bool UbCna16NetworkHeader::IsValidMode() const
     }
 }
 
+UbCna24NetworkHeader::UbCna24NetworkHeader() = default;
+UbCna24NetworkHeader::~UbCna24NetworkHeader() = default;
+
+TypeId UbCna24NetworkHeader::GetTypeId()
+{
+    static TypeId tid =
+        TypeId("ns3::UbCna24NetworkHeader").SetParent<UbCna16NetworkHeader>().AddConstructor<UbCna24NetworkHeader>();
+    return tid;
+}
+
+TypeId UbCna24NetworkHeader::GetInstanceTypeId() const
+{
+    return GetTypeId();
+}
+
+uint32_t UbCna24NetworkHeader::GetSerializedSize() const
+{
+    return totalHeaderSize;
+}
+
+void UbCna24NetworkHeader::Print(std::ostream& os) const
+{
+    os << "SCNA=" << m_scna24 << " DCNA=" << m_dcna24;
+    PrintCcFields(os);
+}
+
+void UbCna24NetworkHeader::Serialize(Buffer::Iterator i) const
+{
+    i.WriteU8((m_scna24 >> 16) & 0xFF);
+    i.WriteU16(m_scna24 & 0xFFFF);
+    i.WriteU8((m_dcna24 >> 16) & 0xFF);
+    i.WriteU16(m_dcna24 & 0xFFFF);
+    SerializeCcFields(i);
+}
+
+uint32_t UbCna24NetworkHeader::Deserialize(Buffer::Iterator i)
+{
+    m_scna24 = static_cast<uint32_t>(i.ReadU8()) << 16;
+    m_scna24 |= i.ReadU16();
+    m_dcna24 = static_cast<uint32_t>(i.ReadU8()) << 16;
+    m_dcna24 |= i.ReadU16();
+    DeserializeCcFields(i);
+    return GetSerializedSize();
+}
+
+void UbCna24NetworkHeader::SetScna(uint32_t v)
+{
+    m_scna24 = v & 0xFFFFFF;
+}
+
+void UbCna24NetworkHeader::SetDcna(uint32_t v)
+{
+    m_dcna24 = v & 0xFFFFFF;
+}
+
+uint32_t UbCna24NetworkHeader::GetScna() const
+{
+    return m_scna24;
+}
+
+uint32_t UbCna24NetworkHeader::GetDcna() const
+{
+    return m_dcna24;
+}
+
 
 /*
  ***************************************************
@@ -2159,6 +2252,11 @@ void UbCompactAckTransactionHeader::SetPoison(bool poison)
     m_poison = poison;
 }
 
+void UbCompactAckTransactionHeader::SetStatus(uint8_t status)
+{
+    m_status = status & 0x03;  // 确保只有2位
+}
+
 void UbCompactAckTransactionHeader::SetIniTaSsn(uint16_t tassn)
 {
     m_iniTaSsn = tassn;
@@ -2180,6 +2278,11 @@ bool UbCompactAckTransactionHeader::GetPoison() const
     return m_poison;
 }
 
+uint8_t UbCompactAckTransactionHeader::GetStatus() const
+{
+    return m_status;
+}
+
 uint16_t UbCompactAckTransactionHeader::GetIniTaSsn() const
 {
     return m_iniTaSsn;
@@ -35,6 +35,7 @@ public:
     bool IsPacketIpv4Header() const;
     bool IsPacketIpv6Header() const;
     bool IsPacketUbMemHeader() const;
+    bool IsPacketUbMemCna24Header() const;
 
     static TypeId GetTypeId(void);
     TypeId GetInstanceTypeId(void) const override;
@@ -66,9 +67,10 @@ private:
  * 报文头格式：total 2 flits = 40 bytes
  *              [(fixed 0):1][Length(fixed 00001):5][Fixed 100000:6][Config(fixed 0000):4]
  *              [Control(fixed 0010):4][Sub Control(fixed 0100):4]
- *              [SD:1][Reserved:6][Type:1]
+ *              [SD:1][Reserved:5][CellGrain:1][Type:1]
  *              [Ack Number:16][Credit Number:96][Reserved:(Length + 1) * 8 * 20 - used]
  *              Credit Number:96 = 6bit * vl_num:16
+ *              CellGrain: 仿真器本地扩展, 置位时Credit Number以cell为单位而非控制帧返回粒度
  */
 class UbDatalinkControlCreditHeader : public Header {
 public:
@@ -80,6 +82,7 @@ public:
     void SetSD(bool sd);
     void SetType(bool type);
     void SetAckNumber(uint16_t ackNum);
+    void SetCellGrain(bool cellGrain);
 
     // Getters
     void GetAllCreditsVL(uint8_t credits[16]) const;
@@ -90,6 +93,7 @@ public:
     bool GetSD() const;
     bool GetType() const;
     uint16_t GetAckNumber() const;
+    bool GetCellGrain() const;
 
     static TypeId GetTypeId(void);
     TypeId GetInstanceTypeId(void) const override;
@@ -113,9 +117,10 @@ private:
     uint8_t m_controlType = 0x02;     // 4 bits (fixed 0010)
     uint8_t m_subControlType = 0x04;  // 4 bits (fixed 0100)
 
-    // 第4字节: [SD:1][Reserved:6][Type:1]
+    // 第4字节: [SD:1][Reserved:5][CellGrain:1][Type:1]
     bool m_sd = true;            // 1 bit: 1 for credit initiation
-    uint8_t reservE1Value = 0;   // 6 bit:reserve字段的固定值
+    uint8_t reservE1Value = 0;   // 5 bit:reserve字段的固定值
+    bool m_cellGrain = false;    // 1 bit: Credit Number以cell为单位
     bool m_type = true;          // 1 bit: when m_sd == 1, 1 means initiation completed
 
     // 字节5-6: [Ack Number:16]
@@ -210,6 +215,13 @@ private:
     uint8_t ignoredFieldValue = 0;  // 未完成字段的填充值
 };
 
+// Network Header 拥塞控制字段mode取值及FECN取值(与RoCE ECN语义一致)
+const uint8_t UB_NETWORK_HEADER_MODE_CAQM = 0x00;
+const uint8_t UB_NETWORK_HEADER_MODE_FECN = 0x04;
+const uint8_t UB_FECN_NOT_ECT = 0x00;  // 不支持ECN
+const uint8_t UB_FECN_ECT = 0x01;      // 支持ECN，未拥塞
+const uint8_t UB_FECN_CE = 0x03;       // 途经交换机标记拥塞
+
 /**
  * \ingroup ub-header
  * \brief UB Network Header (kind of an extension of IP header)
@@ -360,35 +372,26 @@ public:
     // 验证
     bool IsValidMode() const;
 
+protected:
+    // CC/LB/SL/NLP字段与地址宽度无关, CNA24头复用
+    void SerializeCcFields(Buffer::Iterator &i) const;
+    void DeserializeCcFields(Buffer::Iterator &i);
+    void PrintCcFields(std::ostream &os) const;
+
 private:
+    void SetRaw13Bit(uint8_t bit, bool value);
+
     // Byte0-1
     uint16_t m_scna = 0;
     // Byte2-3
     uint16_t m_dcna = 0;
 
-    // Byte4-5: Congestion Control (与 UbNetworkHeader 复用结构思想)
+    // Byte4-5: Congestion Control, 位布局同 UbNetworkHeader
     uint8_t m_mode = 0; // 3 bits
-    union {
-        struct {  // mode 000
-            bool location;
-            bool reserve1;
-            bool enable;
-            bool c;
-            bool i;
-            uint8_t hint;  // 7
-        } mode0;
-        struct {  // mode 010
-            bool location;
-            uint16_t timestamp;  // 10
-            uint8_t fecn;        // 2
-        } mode2;
-        struct {                // mode 100
-            bool location;
-            uint16_t reserve3;  // 10
-            uint8_t fecn;       // 2
-        } mode4;
-        uint16_t raw13;
-    } m_ccFields;
+    // mode 000: [Location:1][Reserved:1][Enable:1][C:1][I:1][Hint:8]
+    // mode 010: [Location:1][Timestamp:10][FECN:2]
+    // mode 100: [Location:1][Reserved:10][FECN:2]
+    uint16_t m_ccRaw13 = 0;
 
     // Byte6
     uint8_t m_lb = 0; // hash时可以使用(SCNA, DCNA, LB)实现负载均衡
@@ -401,6 +404,44 @@ private:
     static const uint32_t totalHeaderSize = 8;
 };
 
+/**
+ * \ingroup ub-header
+ * \brief UB 24-Bit Network Header, CNA16头的扩展地址版本, 用于超过4096节点或15端口的内存语义网络
+ *
+ * 报文位置：[Datalink Packet Header: 4bytes][Network Header: 10bytes][TAH][Payload]
+ * 报文头格式：总计10字节
+ *      字节0-2：[SCNA:24]
+ *      字节3-5：[DCNA:24]
+ *      字节6-7：[CC:16], 格式同CNA16
+ *      字节8：[LB:8]
+ *      字节9：[Service Level:4][Management:1][NLP:3]
+ *
+ *      CNA[高16位: nodeId][低8位: portId]
+ */
+class UbCna24NetworkHeader : public UbCna16NetworkHeader {
+public:
+    UbCna24NetworkHeader();
+    ~UbCna24NetworkHeader() override;
+
+    static TypeId GetTypeId(void);
+    TypeId GetInstanceTypeId(void) const override;
+    void Print(std::ostream &os) const override;
+    void Serialize(Buffer::Iterator start) const override;
+    uint32_t Deserialize(Buffer::Iterator start) override;
+    uint32_t GetSerializedSize(void) const override;
+
+    void SetScna(uint32_t scna);          // 24 bits
+    void SetDcna(uint32_t dcna);          // 24 bits
+    uint32_t GetScna() const;
+    uint32_t GetDcna() const;
+
+private:
+    uint32_t m_scna24 = 0;
+    uint32_t m_dcna24 = 0;
+
+    static const uint32_t totalHeaderSize = 10;
+};
+
 /**
  * \ingroup ub-header
  * \brief UB Transport Header (RTPH)
@@ -869,12 +910,14 @@ public:
     void SetTaOpcode(uint8_t opcode);        // 设置TA操作码 (8位)
     void SetTaVersion(uint8_t version);      // 设置TA版本 (2位)
     void SetPoison(bool poison);             // 设置Poison位 (1位)
+    void SetStatus(uint8_t status);          // 设置Status (2位), LD/ST响应中为授予的一致性行状态
     void SetIniTaSsn(uint16_t tassn);  // 设置发起者TASSN (16位)
 
     // Getters
     uint8_t GetTaOpcode() const;         // 获取TA操作码
     uint8_t GetTaVersion() const;        // 获取TA版本
     bool GetPoison() const;              // 获取Poison位
+    uint8_t GetStatus() const;           // 获取Status
     uint16_t GetIniTaSsn() const;  // 获取发起者TASSN
 
     // 验证方法
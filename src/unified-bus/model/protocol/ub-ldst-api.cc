@@ -6,6 +6,9 @@
 #include "ns3/ub-controller.h"
 #include "ns3/ub-ldst-api.h"
 #include "ns3/hbm-bank.h"
+#include "ns3/hbm-controller.h"
+#include "ns3/hbm-cache.h"
+#include "ns3/ub-coherence.h"
 
 namespace ns3 {
 NS_LOG_COMPONENT_DEFINE("UbLdstApi");
@@ -27,6 +30,12 @@ TypeId UbLdstApi::GetTypeId(void)
                                           BooleanValue(true),
                                           MakeBooleanAccessor(&UbLdstApi::m_useShortestPaths),
                                           MakeBooleanChecker())
+                            .AddAttribute("UseCna24",
+                                          "Use 24-bit CNA network header for LD/ST packets, required when "
+                                          "node ids exceed the 12-bit CNA16 range.",
+                                          BooleanValue(false),
+                                          MakeBooleanAccessor(&UbLdstApi::m_useCna24),
+                                          MakeBooleanChecker())
                             .AddTraceSource("LdstRecvNotify",
                                             "Fires on Ldst data or ACK reception (provides info and trace tags).",
                                             MakeTraceSourceAccessor(&UbLdstApi::m_ldstRecvNotify),
@@ -84,8 +93,8 @@ void UbLdstApi::SendPacket(Ptr<UbLdstTaskSegment> taskSegment, Ptr<Packet> packe
     // It also maintains multiple ports
     // In the figures of the official UB document, an XPU connects to the fabric using a UB Switch
     // In this sense, A UB Switch is akin to an I/O Die.
-    // Instantiating multiple UB Switch objects for a single node is therefore good for modeling multiple I/O Dies
-    // Of course, the scheduling algorithm must be carefully implemented
+    // Multiple I/O Dies are modeled inside the UbSwitch (dieNum/portDie in node.csv): every die runs its own
+    // allocator, and a packet leaving through a port on another die pays the die-to-die link cost on dequeue
 
 
     int outPort = sw->GetRoutingProcess()->GetOutPort(rtKey);
@@ -125,24 +134,38 @@ Ptr<Packet> UbLdstApi::GenDataPacket(Ptr<UbLdstTaskSegment> taskSegment)
         }
     }
     Ptr<Packet> packet = Create<Packet>(payloadSize);
+    cMAETah.SetVirtualAddress(taskSegment->GetNextAddress());
     taskSegment->UpdateSentBytes(dataSize);
     // Gen Headers
     cMAETah.SetLength((uint8_t)length);
     cTaHeader.SetIniTaSsn(taskSegment->GetTaskSegmentId()); // taskid
-    uint16_t scna = static_cast<uint16_t>(utils::NodeIdToCna16(taskSegment->GetSrc()));
-    memHeader.SetScna(scna);
-    uint16_t dcna = static_cast<uint16_t>(utils::NodeIdToCna16(taskSegment->GetDest()));
-    memHeader.SetDcna(dcna);
-    memHeader.SetLb(m_lbHashSalt);
-    memHeader.SetServiceLevel(taskSegment->GetPriority());
-
     packet->AddHeader(cMAETah);
     packet->AddHeader(cTaHeader);
-    packet->AddHeader(memHeader);
+    UbDatalinkHeaderConfig config = UbDatalinkHeaderConfig::PACKET_UB_MEM;
+    if (m_useCna24) {
+        UbCna24NetworkHeader mem24Header;
+        mem24Header.SetScna(utils::NodeIdToCna24(taskSegment->GetSrc()));
+        mem24Header.SetDcna(utils::NodeIdToCna24(taskSegment->GetDest()));
+        mem24Header.SetLb(m_lbHashSalt);
+        mem24Header.SetServiceLevel(taskSegment->GetPriority());
+        packet->AddHeader(mem24Header);
+        config = UbDatalinkHeaderConfig::PACKET_CNA24;
+    } else {
+        // CNA16仅12位nodeId, 超出范围会别名到其他节点
+        NS_ASSERT_MSG(taskSegment->GetSrc() <= 0xFFF && taskSegment->GetDest() <= 0xFFF,
+                      "NodeId exceeds CNA16 range, set ns3::UbLdstApi::UseCna24 to true");
+        uint16_t scna = static_cast<uint16_t>(utils::NodeIdToCna16(taskSegment->GetSrc()));
+        memHeader.SetScna(scna);
+        uint16_t dcna = static_cast<uint16_t>(utils::NodeIdToCna16(taskSegment->GetDest()));
+        memHeader.SetDcna(dcna);
+        memHeader.SetLb(m_lbHashSalt);
+        memHeader.SetServiceLevel(taskSegment->GetPriority());
+        packet->AddHeader(memHeader);
+    }
 
     // add dl header
     UbDataLink::GenPacketHeader(packet, false, false, taskSegment->GetPriority(), taskSegment->GetPriority(),
-                                m_usePacketSpray, m_useShortestPaths, UbDatalinkHeaderConfig::PACKET_UB_MEM);
+                                m_usePacketSpray, m_useShortestPaths, config);
     UbFlowTag flowTag(taskSegment->GetTaskId(), taskSegment->GetSize());
     packet->AddPacketTag(flowTag);
     NS_LOG_DEBUG("[UbLdstApi GenDataPacket] packetUid: " << packet->GetUid() << " payload size:" << payloadSize);
@@ -153,21 +176,12 @@ Ptr<Packet> UbLdstApi::GenDataPacket(Ptr<UbLdstTaskSegment> taskSegment)
  * 接收到一个数据包，调用此函数处理，产生ack
  */
 
-void UbLdstApi::OnHBMComplete(void* arg) {
-    
-    if (arg == nullptr) {
-        NS_LOG_ERROR("Error: got nullptr");
-    }
-
-    UbLdstApi::PacketContext* arg_new = static_cast<UbLdstApi::PacketContext*>(arg);
-
-    UbDatalinkPacketHeader linkPacketHeader = arg_new->linkPacketHeader;
-    UbCompactAckTransactionHeader caTaHeader = arg_new->caTaHeader;
-    UbCna16NetworkHeader memHeader = arg_new->memHeader;
-    UbCompactTransactionHeader cTaHeader = arg_new->cTaHeader;
-    UbCompactMAExtTah cMAETah = arg_new->cMAETah;
-
-    delete arg_new;
+void UbLdstApi::HBMAccessDone(uint64_t requestId)
+{
+    PacketContext &context = m_contexts[requestId];
+    UbCompactAckTransactionHeader &caTaHeader = context.caTaHeader;
+    UbCompactTransactionHeader &cTaHeader = context.cTaHeader;
+    UbCompactMAExtTah &cMAETah = context.cMAETah;
 
     Ptr<Packet> ackp;
     uint32_t payloadSize = 0;
@@ -183,23 +197,55 @@ void UbLdstApi::OnHBMComplete(void* arg) {
         NS_LOG_DEBUG("[UbLdstApi RecvDataPacket] Load payloadSize: " << payloadSize);
         ackp = Create<Packet>(payloadSize);
     }
+    if (context.coherent) {
+        // 授予的行状态放在Status字段, 其后附带请求的cMAETAH供请求方定位行
+        auto directory = NodeList::GetNode(m_nodeId)->GetObject<UbCoherenceDirectory>();
+        caTaHeader.SetStatus(static_cast<uint8_t>(directory->Complete(context.txnId)));
+        ackp->AddHeader(cMAETah);
+    }
+    SendResponse(context, ackp);
+    m_contexts.Free(requestId);
+}
+
+void UbLdstApi::SendResponse(PacketContext &context, Ptr<Packet> ackp)
+{
+    UbDatalinkPacketHeader &linkPacketHeader = context.linkPacketHeader;
+    UbCompactAckTransactionHeader &caTaHeader = context.caTaHeader;
+    UbCna16NetworkHeader &memHeader = context.memHeader;
+    UbCna24NetworkHeader &mem24Header = context.mem24Header;
+    bool isCna24 = context.isCna24;
+    UbCompactTransactionHeader &cTaHeader = context.cTaHeader;
 
     uint16_t tassn = cTaHeader.GetIniTaSsn();
     caTaHeader.SetIniTaSsn(tassn);
-    uint16_t tmp = memHeader.GetScna();
-    memHeader.SetScna(memHeader.GetDcna());
-    memHeader.SetDcna(tmp);
     ackp->AddHeader(caTaHeader);
-    ackp->AddHeader(memHeader);
+    uint32_t scna = 0;
+    uint32_t dcna = 0;
+    uint8_t lb = 0;
+    if (isCna24) {
+        scna = mem24Header.GetDcna();
+        dcna = mem24Header.GetScna();
+        mem24Header.SetScna(scna);
+        mem24Header.SetDcna(dcna);
+        lb = mem24Header.GetLb();
+        ackp->AddHeader(mem24Header);
+    } else {
+        scna = memHeader.GetDcna();
+        dcna = memHeader.GetScna();
+        memHeader.SetScna(scna);
+        memHeader.SetDcna(dcna);
+        lb = memHeader.GetLb();
+        ackp->AddHeader(memHeader);
+    }
 
     UbDataLink::GenPacketHeader(ackp, false, true, linkPacketHeader.GetCreditTargetVL(), linkPacketHeader.GetPacketVL(),
                                 linkPacketHeader.GetLoadBalanceMode(), linkPacketHeader.GetRoutingPolicy(),
-                                UbDatalinkHeaderConfig::PACKET_UB_MEM);
+                                isCna24 ? UbDatalinkHeaderConfig::PACKET_CNA24 : UbDatalinkHeaderConfig::PACKET_UB_MEM);
 
     RoutingKey rtKey;
-    rtKey.sip = utils::Cna16ToIp(memHeader.GetScna()).Get();
-    rtKey.dip = utils::Cna16ToIp(memHeader.GetDcna()).Get();
-    rtKey.sport = memHeader.GetLb();
+    rtKey.sip = utils::CnaToIp(scna, isCna24).Get();
+    rtKey.dip = utils::CnaToIp(dcna, isCna24).Get();
+    rtKey.sport = lb;
     rtKey.dport = 0;
     rtKey.priority = linkPacketHeader.GetPacketVL();
     rtKey.useShortestPath = linkPacketHeader.GetRoutingPolicy();
@@ -222,6 +268,94 @@ void UbLdstApi::OnHBMComplete(void* arg) {
     triggerPort->TriggerTransmit(); // 触发发送
 }
 
+void UbLdstApi::IssueMemoryAccess(uint32_t contextId)
+{
+    PacketContext &context = m_contexts[contextId];
+    // 访问按交织粒度分散到各stack/channel, 全部burst完成后回调; 配置了内存侧cache时先经过cache
+    auto cache = NodeList::GetNode(m_nodeId)->GetObject<HBMCache>();
+    if (cache != nullptr) {
+        cache->SendRequest(contextId, context.address, context.payloadSize, context.isWrite, this);
+        return;
+    }
+    auto hbm_controller = NodeList::GetNode(m_nodeId)->GetObject<HBMController>();
+    hbm_controller->SendRequest(contextId, context.address, context.payloadSize, context.isWrite, this);
+}
+
+void UbLdstApi::SendSnoop(uint32_t dest, uint32_t txnId, uint64_t address, uint32_t size, bool downgrade,
+                          uint8_t vl)
+{
+    TaOpcode opcode = downgrade ? TaOpcode::TA_OPCODE_SNOOP_DOWNGRADE : TaOpcode::TA_OPCODE_SNOOP_INVALIDATE;
+    SendCoherencePacket(dest, opcode, txnId, address, size, 0, vl);
+}
+
+void UbLdstApi::SendWriteback(uint32_t home, uint64_t address, uint32_t size, uint8_t vl)
+{
+    SendCoherencePacket(home, TaOpcode::TA_OPCODE_WRITEBACK_FULL, 0, address, size, size, vl);
+}
+
+/**
+ * @brief 侦听/写回请求与LD/ST请求格式相同: DLH cNTH cTAH [cMAETAH] Payload
+ */
+void UbLdstApi::SendCoherencePacket(uint32_t dest, TaOpcode opcode, uint16_t tassn, uint64_t address,
+                                    uint32_t size, uint32_t payloadSize, uint8_t vl)
+{
+    uint8_t length = 0;
+    while ((64u << length) < size) {
+        length++;
+    }
+    if (m_usePacketSpray) {
+        m_lbHashSalt = m_lbHashSalt == MAX_LB ? MIN_LB : m_lbHashSalt + 1;
+    }
+    Ptr<Packet> packet = Create<Packet>(payloadSize);
+    UbCompactMAExtTah cMAETah;
+    cMAETah.SetVirtualAddress(address);
+    cMAETah.SetLength(length);
+    UbCompactTransactionHeader cTaHeader;
+    cTaHeader.SetTaOpcode(opcode);
+    cTaHeader.SetIniTaSsn(tassn);
+    packet->AddHeader(cMAETah);
+    packet->AddHeader(cTaHeader);
+    UbDatalinkHeaderConfig config = UbDatalinkHeaderConfig::PACKET_UB_MEM;
+    if (m_useCna24) {
+        UbCna24NetworkHeader mem24Header;
+        mem24Header.SetScna(utils::NodeIdToCna24(m_nodeId));
+        mem24Header.SetDcna(utils::NodeIdToCna24(dest));
+        mem24Header.SetLb(m_lbHashSalt);
+        mem24Header.SetServiceLevel(vl);
+        packet->AddHeader(mem24Header);
+        config = UbDatalinkHeaderConfig::PACKET_CNA24;
+    } else {
+        NS_ASSERT_MSG(m_nodeId <= 0xFFF && dest <= 0xFFF,
+                      "NodeId exceeds CNA16 range, set ns3::UbLdstApi::UseCna24 to true");
+        UbCna16NetworkHeader memHeader;
+        memHeader.SetScna(static_cast<uint16_t>(utils::NodeIdToCna16(m_nodeId)));
+        memHeader.SetDcna(static_cast<uint16_t>(utils::NodeIdToCna16(dest)));
+        memHeader.SetLb(m_lbHashSalt);
+        memHeader.SetServiceLevel(vl);
+        packet->AddHeader(memHeader);
+    }
+    UbDataLink::GenPacketHeader(packet, false, false, vl, vl, m_usePacketSpray, m_useShortestPaths, config);
+
+    RoutingKey rtKey;
+    rtKey.sip = utils::NodeIdToIp(m_nodeId).Get();
+    rtKey.dip = utils::NodeIdToIp(dest).Get();
+    rtKey.sport = m_lbHashSalt;
+    rtKey.dport = 0;
+    rtKey.priority = vl;
+    rtKey.useShortestPath = m_useShortestPaths;
+    rtKey.usePacketSpray = m_usePacketSpray;
+    auto node = NodeList::GetNode(m_nodeId);
+    auto sw = node->GetObject<UbSwitch>();
+    int outPort = sw->GetRoutingProcess()->GetOutPort(rtKey);
+    if (outPort < 0) {
+        // Route failed
+        NS_ASSERT_MSG(0, "The route cannot be found");
+    }
+    sw->AddPktToVoq(packet, outPort, vl, outPort);
+    Ptr<UbPort> port = DynamicCast<UbPort>(node->GetDevice(outPort));
+    Simulator::ScheduleNow(&UbPort::TriggerTransmit, port);
+}
+
 void UbLdstApi::RecvDataPacket(Ptr<Packet> packet)
 {
     // Store/load request: DLH cNTH cTAH(0x03/0x06) [cMAETAH] Payload
@@ -232,14 +366,30 @@ void UbLdstApi::RecvDataPacket(Ptr<Packet> packet)
     }
 
     NS_LOG_DEBUG("[UbLdstApi RecvDataPacket] nodeId: " << m_nodeId << " packetUid: " << packet->GetUid());
-    UbDatalinkPacketHeader linkPacketHeader;
-    UbCompactAckTransactionHeader caTaHeader;
-    UbCna16NetworkHeader memHeader;
-    UbCompactTransactionHeader cTaHeader;
-    UbCompactMAExtTah cMAETah;
+    // 报文头直接解析到上下文槽位中, HBM完成后据此生成响应
+    uint32_t contextId = m_contexts.Alloc();
+    PacketContext &context = m_contexts[contextId];
+    UbDatalinkPacketHeader &linkPacketHeader = context.linkPacketHeader;
+    UbCompactAckTransactionHeader &caTaHeader = context.caTaHeader;
+    UbCna16NetworkHeader &memHeader = context.memHeader;
+    UbCna24NetworkHeader &mem24Header = context.mem24Header;
+    UbCompactTransactionHeader &cTaHeader = context.cTaHeader;
+    UbCompactMAExtTah &cMAETah = context.cMAETah;
     
     packet->RemoveHeader(linkPacketHeader);
-    packet->RemoveHeader(memHeader);
+    bool isCna24 = linkPacketHeader.GetConfig() == static_cast<uint8_t>(UbDatalinkHeaderConfig::PACKET_CNA24);
+    context.isCna24 = isCna24;
+    uint32_t scna = 0;
+    uint32_t dcna = 0;
+    if (isCna24) {
+        packet->RemoveHeader(mem24Header);
+        scna = mem24Header.GetScna();
+        dcna = mem24Header.GetDcna();
+    } else {
+        packet->RemoveHeader(memHeader);
+        scna = memHeader.GetScna();
+        dcna = memHeader.GetDcna();
+    }
     packet->RemoveHeader(cTaHeader);
     packet->PeekHeader(cMAETah);
 
@@ -248,16 +398,38 @@ void UbLdstApi::RecvDataPacket(Ptr<Packet> packet)
         packet->PeekPacketTag(flowTag);
         UbPacketTraceTag traceTag;
         packet->PeekPacketTag(traceTag);
-        LdstRecvNotify(packet->GetUid(), utils::Cna16ToNodeId(memHeader.GetDcna()),
-                       utils::Cna16ToNodeId(memHeader.GetScna()),
+        LdstRecvNotify(packet->GetUid(), utils::CnaToNodeId(dcna, isCna24),
+                       utils::CnaToNodeId(scna, isCna24),
                        PacketType::PACKET, packet->GetSize(), flowTag.GetFlowId(), traceTag);
     }
-    // Ptr<Packet> ackp;
+    uint32_t srcNode = utils::CnaToNodeId(scna, isCna24);
+    uint8_t opcode = cTaHeader.GetTaOpcode();
+    if (opcode == static_cast<uint8_t>(TaOpcode::TA_OPCODE_SNOOP_INVALIDATE) ||
+        opcode == static_cast<uint8_t>(TaOpcode::TA_OPCODE_SNOOP_DOWNGRADE)) {
+        // home的侦听, 应答携带本节点M态行的脏数据
+        auto agent = NodeList::GetNode(m_nodeId)->GetObject<UbCoherenceAgent>();
+        NS_ASSERT_MSG(agent != nullptr, "Snoop received by a node without UbCoherenceAgent");
+        bool downgrade = opcode == static_cast<uint8_t>(TaOpcode::TA_OPCODE_SNOOP_DOWNGRADE);
+        uint32_t dirtyBytes = agent->OnSnoop(srcNode, cMAETah.GetVirtualAddress(),
+                                             64 * (1 << (uint32_t)cMAETah.GetLength()), downgrade);
+        caTaHeader.SetTaOpcode(TaOpcode::TA_OPCODE_SNOOP_ACK);
+        SendResponse(context, Create<Packet>(dirtyBytes));
+        m_contexts.Free(contextId);
+        return;
+    }
+    if (opcode == static_cast<uint8_t>(TaOpcode::TA_OPCODE_WRITEBACK_FULL)) {
+        packet->RemoveHeader(cMAETah);
+        auto directory = NodeList::GetNode(m_nodeId)->GetObject<UbCoherenceDirectory>();
+        NS_ASSERT_MSG(directory != nullptr, "Writeback received by a node without UbCoherenceDirectory");
+        directory->OnWriteback(srcNode, cMAETah.GetVirtualAddress(), packet->GetSize());
+        m_contexts.Free(contextId);
+        return;
+    }
     // 收到store数据包
     // Implement HBM related stuff here:
     uint32_t payloadSize = 0;
     bool isWrite = false;
-    if (cTaHeader.GetTaOpcode() == static_cast<uint8_t>(TaOpcode::TA_OPCODE_WRITE)) {
+    if (opcode == static_cast<uint8_t>(TaOpcode::TA_OPCODE_WRITE)) {
         // Logic for handling store simulation here:
         packet->RemoveHeader(cMAETah);
         payloadSize = packet->GetSize(); // Total bytes to store as data
@@ -265,81 +437,26 @@ void UbLdstApi::RecvDataPacket(Ptr<Packet> packet)
         NS_LOG_DEBUG("Received " << payloadSize << " bytes to store");
 
         isWrite = true;
-        // ackp = Create<Packet>(0);
         caTaHeader.SetTaOpcode(TaOpcode::TA_OPCODE_TRANSACTION_ACK);
-    } else if (cTaHeader.GetTaOpcode() == static_cast<uint8_t>(TaOpcode::TA_OPCODE_READ)) {
+    } else if (opcode == static_cast<uint8_t>(TaOpcode::TA_OPCODE_READ)) {
         caTaHeader.SetTaOpcode(TaOpcode::TA_OPCODE_READ_RESPONSE);
         payloadSize = 64 * (1 << (uint32_t)cMAETah.GetLength());
         NS_LOG_DEBUG("[UbLdstApi RecvDataPacket] Load payloadSize: " << payloadSize);
-        // ackp = Create<Packet>(payloadSize);
     }
-
-    uint32_t num_of_atomics = payloadSize / HBM_BANK_ATOMIC_SIZE;
-    if (num_of_atomics == 0) num_of_atomics  = 1;
-    if (num_of_atomics > 32) num_of_atomics = 32; // This just ensures it doesn't hog it too long.
-    
-    UbLdstApi::PacketContext* temp_ptr = new UbLdstApi::PacketContext();
-    temp_ptr->linkPacketHeader = linkPacketHeader;
-    temp_ptr->caTaHeader = caTaHeader;
-    temp_ptr->memHeader = memHeader;
-    temp_ptr->cTaHeader = cTaHeader;
-    temp_ptr->cMAETah = cMAETah;
-    void* context_ptr = static_cast<void*>(temp_ptr);
-
-    auto ldstInst = NodeList::GetNode(m_nodeId)->GetObject<UbLdstInstance>();
-    auto hbm_controller = NodeList::GetNode(m_nodeId)->GetObject<HBMController>();
-    auto rng = NodeList::GetNode(m_nodeId)->GetObject<UniformRandomVariable>();
-    auto random_bank = rng->GetInteger(0, HBM_BANK_PER_DIE-1);
-
-    for(uint32_t iter = 0; iter < num_of_atomics-1; iter++)
-    {
-        hbm_controller->SendRequest(iter, 0x1000, HBM_BANK_ATOMIC_SIZE, random_bank, isWrite, [](void* p){}, nullptr);
-    } // For all the previous tasks, do nothing.
-
-    hbm_controller->SendRequest(num_of_atomics, 0x1000, HBM_BANK_ATOMIC_SIZE, random_bank, isWrite, MakeCallback(&UbLdstApi::OnHBMComplete, this), context_ptr);
-    // Only when processing the final segments, pass in real callback func as well as arg ptr;
-    /*
-    uint16_t tassn = cTaHeader.GetIniTaSsn();
-    caTaHeader.SetIniTaSsn(tassn);
-
-    uint16_t tmp = memHeader.GetScna();
-    memHeader.SetScna(memHeader.GetDcna());
-    memHeader.SetDcna(tmp);
-
-    ackp->AddHeader(caTaHeader);
-    ackp->AddHeader(memHeader);
-    UbDataLink::GenPacketHeader(ackp, false, true, linkPacketHeader.GetCreditTargetVL(), linkPacketHeader.GetPacketVL(),
-                                linkPacketHeader.GetLoadBalanceMode(), linkPacketHeader.GetRoutingPolicy(),
-                                UbDatalinkHeaderConfig::PACKET_UB_MEM);
-
-    RoutingKey rtKey;
-    rtKey.sip = utils::Cna16ToIp(memHeader.GetScna()).Get();
-    rtKey.dip = utils::Cna16ToIp(memHeader.GetDcna()).Get();
-    rtKey.sport = memHeader.GetLb();
-    rtKey.dport = 0;
-    rtKey.priority = linkPacketHeader.GetPacketVL();
-    rtKey.useShortestPath = linkPacketHeader.GetRoutingPolicy();
-    rtKey.usePacketSpray = linkPacketHeader.GetLoadBalanceMode();
-    
-    auto node = NodeList::GetNode(m_nodeId);
-    auto sw = node->GetObject<UbSwitch>();
-
-    int destPort = sw->GetRoutingProcess()->GetOutPort(rtKey);
-    if (destPort < 0) {
-        // Route failed
-        NS_ASSERT_MSG(0, "The route cannot be found");
+    context.address = cMAETah.GetVirtualAddress();
+    context.payloadSize = payloadSize;
+    context.isWrite = isWrite;
+
+    // 开启一致性时先经home目录, 侦听完成后再访问内存
+    auto directory = NodeList::GetNode(m_nodeId)->GetObject<UbCoherenceDirectory>();
+    if (directory != nullptr) {
+        context.coherent = true;
+        context.txnId = directory->HandleRequest(contextId, srcNode, context.address,
+                                                 64 * (1 << (uint32_t)cMAETah.GetLength()), isWrite,
+                                                 linkPacketHeader.GetPacketVL());
+        return;
     }
-
-    sw->AddPktToVoq(ackp, destPort, linkPacketHeader.GetPacketVL(), destPort);
-
-    NS_LOG_DEBUG("[UbLdstApi RecvDataPacket] Send Ack. NodeId: " << m_nodeId << " PacketUid: "
-                  << ackp->GetUid() << " packetSize: " << ackp->GetSize() << " destPort: " << destPort);
-    
-    Ptr<UbPort> triggerPort = DynamicCast<UbPort>(node->GetDevice(destPort));
-    triggerPort->TriggerTransmit(); // 触发发送
-    */
-
-    
+    IssueMemoryAccess(contextId);
 }
 
 void UbLdstApi::RecvResponse(Ptr<Packet> packet)
@@ -352,9 +469,21 @@ void UbLdstApi::RecvResponse(Ptr<Packet> packet)
     // Store/load response: DLH cNTH cATAH(0x11/0x12) Payload
     UbDatalinkPacketHeader linkPacketHeader;
     UbCna16NetworkHeader memHeader;
+    UbCna24NetworkHeader mem24Header;
     UbCompactAckTransactionHeader caTaHeader;
     packet->RemoveHeader(linkPacketHeader);
-    packet->RemoveHeader(memHeader);
+    bool isCna24 = linkPacketHeader.GetConfig() == static_cast<uint8_t>(UbDatalinkHeaderConfig::PACKET_CNA24);
+    uint32_t scna = 0;
+    uint32_t dcna = 0;
+    if (isCna24) {
+        packet->RemoveHeader(mem24Header);
+        scna = mem24Header.GetScna();
+        dcna = mem24Header.GetDcna();
+    } else {
+        packet->RemoveHeader(memHeader);
+        scna = memHeader.GetScna();
+        dcna = memHeader.GetDcna();
+    }
     packet->RemoveHeader(caTaHeader);
 
     if (m_pktTraceEnabled) {
@@ -362,11 +491,25 @@ void UbLdstApi::RecvResponse(Ptr<Packet> packet)
         packet->PeekPacketTag(flowTag);
         UbPacketTraceTag traceTag;
         packet->PeekPacketTag(traceTag);
-        LdstRecvNotify(packet->GetUid(), utils::Cna16ToNodeId(memHeader.GetDcna()),
-                       utils::Cna16ToNodeId(memHeader.GetScna()),
+        LdstRecvNotify(packet->GetUid(), utils::CnaToNodeId(dcna, isCna24),
+                       utils::CnaToNodeId(scna, isCna24),
                        PacketType::ACK, packet->GetSize(), flowTag.GetFlowId(), traceTag);
     }
     uint32_t taskSegmentId = caTaHeader.GetIniTaSsn();
+    if (caTaHeader.GetTaOpcode() == static_cast<uint8_t>(TaOpcode::TA_OPCODE_SNOOP_ACK)) {
+        auto directory = NodeList::GetNode(m_nodeId)->GetObject<UbCoherenceDirectory>();
+        directory->OnSnoopAck(taskSegmentId, packet->GetSize());
+        return;
+    }
+    if (caTaHeader.GetStatus() != 0) {
+        // home授予的行状态
+        UbCompactMAExtTah cMAETah;
+        packet->RemoveHeader(cMAETah);
+        auto agent = NodeList::GetNode(m_nodeId)->GetObject<UbCoherenceAgent>();
+        agent->OnGrant(utils::CnaToNodeId(scna, isCna24), cMAETah.GetVirtualAddress(),
+                       64 * (1 << (uint32_t)cMAETah.GetLength()),
+                       static_cast<UbCoherenceState>(caTaHeader.GetStatus()), linkPacketHeader.GetPacketVL());
+    }
     auto ldstInst = NodeList::GetNode(m_nodeId)->GetObject<UbLdstInstance>();
     Simulator::ScheduleNow(&UbLdstInstance::OnRecvAck, ldstInst, taskSegmentId);
 }
@@ -9,6 +9,7 @@
 #include "ns3/node-list.h"
 #include "ns3/ub-tag.h"
 #include "ns3/ub-header.h"
+#include "ns3/hbm-request.h"
 
 namespace ns3 {
 constexpr int MAX_LB = 255;
@@ -20,7 +21,7 @@ class UbCompactAckTransactionHeader;
 class UbCompactTransactionHeader;
 class UbCompactMAExtTah;
 
-class UbLdstApi : public Object {
+class UbLdstApi : public Object, public HBMClient {
 
 public:
     static TypeId GetTypeId(void);
@@ -32,8 +33,15 @@ private:
         UbDatalinkPacketHeader linkPacketHeader;
         UbCompactAckTransactionHeader caTaHeader;
         UbCna16NetworkHeader memHeader;
+        UbCna24NetworkHeader mem24Header;
+        bool isCna24 = false;
         UbCompactTransactionHeader cTaHeader;
         UbCompactMAExtTah cMAETah;
+        uint64_t address = 0;
+        uint32_t payloadSize = 0;
+        bool isWrite = false;
+        bool coherent = false;      // 经home目录处理, 响应中授予行状态
+        uint32_t txnId = 0;         // 目录中的事务号
     };
 
 public:
@@ -43,16 +51,29 @@ public:
     void SetUseShortestPaths(bool useShortestPaths);
     void RecvDataPacket(Ptr<Packet> packet);
     void LdstProcess(Ptr<UbLdstTaskSegment> taskSegment);
-    void OnHBMComplete(void* arg);
+    // 访存完成, requestId为接收上下文在m_contexts中的槽位
+    void HBMAccessDone(uint64_t requestId) override;
+    // 按接收上下文中的请求访问本节点内存, 开启一致性时由目录在侦听完成后调用
+    void IssueMemoryAccess(uint32_t contextId);
+    // home向持有行的节点发侦听, IniTaSsn携带目录事务号
+    void SendSnoop(uint32_t dest, uint32_t txnId, uint64_t address, uint32_t size, bool downgrade, uint8_t vl);
+    // 淘汰M态行时写回home
+    void SendWriteback(uint32_t home, uint64_t address, uint32_t size, uint8_t vl);
 
 private:
     void SendPacket(Ptr<UbLdstTaskSegment> taskSegment, Ptr<Packet> packet);
     Ptr<Packet> GenDataPacket(Ptr<UbLdstTaskSegment> taskSegment);
+    // 以接收上下文中的报文头生成发回请求方的cATAH响应并发送
+    void SendResponse(PacketContext &context, Ptr<Packet> ackp);
+    void SendCoherencePacket(uint32_t dest, TaOpcode opcode, uint16_t tassn, uint64_t address, uint32_t size,
+                             uint32_t payloadSize, uint8_t vl);
     uint32_t m_nodeId = 0;
     uint32_t m_lbHashSalt = 0;
     bool m_usePacketSpray = false;
     bool m_useShortestPaths = false;
+    bool m_useCna24 = false;
     bool m_pktTraceEnabled = false;
+    HBMPool<PacketContext> m_contexts;  // 等待HBM完成的接收上下文
     void LdstRecvNotify(uint32_t packetUid, uint32_t src, uint32_t dst,
                         PacketType type, uint32_t size, uint32_t taskId, UbPacketTraceTag traceTag);
     TracedCallback<uint32_t, uint32_t, uint32_t,
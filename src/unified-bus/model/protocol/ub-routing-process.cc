@@ -1,6 +1,12 @@
 // SPDX-License-Identifier: GPL-2.0-only
+#include "ns3/boolean.h"
+#include "ns3/double.h"
+#include "ns3/uinteger.h"
+#include "ns3/simulator.h"
 #include "ns3/ub-controller.h"
 #include "ns3/ub-queue-manager.h"
+#include "ns3/ub-port.h"
+#include "ns3/ub-flow-control.h"
 #include "ns3/ub-routing-process.h"
 using namespace utils;
 
@@ -14,12 +20,50 @@ TypeId UbRoutingProcess::GetTypeId(void)
     static TypeId tid = TypeId("ns3::UbRoutingProcess")
         .SetParent<Object>()
         .SetGroupName("UnifiedBus")
-        .AddConstructor<UbRoutingProcess>();
+        .AddConstructor<UbRoutingProcess>()
+        .AddAttribute("EnableFlowlet",
+                      "Per-flow packets are load balanced by flowlet instead of static ECMP hash.",
+                      BooleanValue(false),
+                      MakeBooleanAccessor(&UbRoutingProcess::m_flowletEnabled),
+                      MakeBooleanChecker())
+        .AddAttribute("FlowletTimeout",
+                      "Inter-packet gap of a flow after which a new output port may be chosen.",
+                      TimeValue(NanoSeconds(1000)),
+                      MakeTimeAccessor(&UbRoutingProcess::m_flowletTimeout),
+                      MakeTimeChecker())
+        .AddAttribute("FlowletTableSize",
+                      "Number of entries of the fixed-size flowlet table.",
+                      UintegerValue(4096),
+                      MakeUintegerAccessor(&UbRoutingProcess::m_flowletTableSize),
+                      MakeUintegerChecker<uint32_t>(1))
+        .AddAttribute("EnableAdaptiveRouting",
+                      "Choose output port by local egress occupancy (UGAL-style minimal/non-minimal choice). "
+                      "Packet-sprayed traffic adapts per packet; per-flow traffic adapts only at flowlet "
+                      "boundaries when EnableFlowlet is set and keeps its hashed path otherwise.",
+                      BooleanValue(false),
+                      MakeBooleanAccessor(&UbRoutingProcess::m_adaptiveEnabled),
+                      MakeBooleanChecker())
+        .AddAttribute("AdaptiveUseCredits",
+                      "Adaptive routing avoids ports whose CBFC credits of the packet VL are exhausted.",
+                      BooleanValue(true),
+                      MakeBooleanAccessor(&UbRoutingProcess::m_adaptiveUseCredits),
+                      MakeBooleanChecker())
+        .AddAttribute("UgalNonMinimalBias",
+                      "Cost multiplier of non-minimal routes in the UGAL decision.",
+                      DoubleValue(2.0),
+                      MakeDoubleAccessor(&UbRoutingProcess::m_ugalBias),
+                      MakeDoubleChecker<double>(1.0))
+        .AddAttribute("UgalThreshold",
+                      "Minimal route is kept unless its cost exceeds the biased non-minimal cost by this many bytes.",
+                      UintegerValue(UB_MTU_BYTE),
+                      MakeUintegerAccessor(&UbRoutingProcess::m_ugalThreshold),
+                      MakeUintegerChecker<uint32_t>());
     return tid;
 }
 
 UbRoutingProcess::UbRoutingProcess()
 {
+    m_flowletRandom = CreateObject<UniformRandomVariable>();
 }
 
 void UbRoutingProcess::AddShortestRoute(const uint32_t destIP, const std::vector<uint16_t>& outPorts)
@@ -111,10 +155,131 @@ bool UbRoutingProcess::RemoveOtherRoute(const uint32_t destIP)
     return m_rtOther.erase(destIP) > 0;
 }
 
-int UbRoutingProcess::GetOutPort(Ptr<Packet> packet, Ptr<UbQueueManager> queueManager, Ptr<UbController> ctrl)
+int UbRoutingProcess::GetOutPort(RoutingKey &rtKey, Ptr<UbQueueManager> queueManager, Ptr<Node> node,
+    uint16_t inPort)
 {
-    NS_ASSERT_MSG(0, "Not yet implemented!");
-    return -1;
+    // 1. 首先基于目的节点的port地址进行选择
+    int outPortId = SelectAdaptiveOutPort(rtKey, rtKey.dip, queueManager, node, inPort);
+    if (outPortId == -1) {
+        // 2. 如果找不到，掩盖port地址，使用主机的primary地址进行寻址
+        Ipv4Mask mask("255.255.255.0");
+        uint32_t dip = Ipv4Address(rtKey.dip).CombineMask(mask).Get();
+        outPortId = SelectAdaptiveOutPort(rtKey, dip, queueManager, node, inPort);
+        // 3. 如果还是找不到，报ASSERT
+        NS_ASSERT_MSG(outPortId != -1, "No available output port found");
+    }
+    return outPortId;
+}
+
+uint64_t UbRoutingProcess::GetPortCost(uint16_t port, uint8_t priority, Ptr<UbQueueManager> queueManager,
+    Ptr<Node> node)
+{
+    uint64_t cost = queueManager->GetEgressUsed(port, priority);
+    if (m_adaptiveUseCredits) {
+        Ptr<UbPort> ubPort = DynamicCast<UbPort>(node->GetDevice(port));
+        Ptr<UbFlowControl> fc = ubPort->GetFlowControl();
+        if (fc != nullptr && fc->GetFcType() == FcType::CBFC &&
+            DynamicCast<UbCbfc>(fc)->GetCrdTxfree(priority) <= 0) {
+            // 信用耗尽，下游已反压，只有全部候选都耗尽时才会选中
+            cost = UINT32_MAX + cost;
+        }
+    }
+    return cost;
+}
+
+int UbRoutingProcess::SelectLeastCostPort(const std::vector<uint16_t>& ports, uint16_t inPort, uint64_t hash64,
+    uint8_t priority, Ptr<UbQueueManager> queueManager, Ptr<Node> node, uint64_t &cost)
+{
+    std::vector<uint16_t> bestPorts;
+    uint64_t bestCost = UINT64_MAX;
+    for (uint16_t port : ports) {
+        if (port == inPort) {
+            continue;
+        }
+        uint64_t portCost = GetPortCost(port, priority, queueManager, node);
+        if (portCost < bestCost) {
+            bestCost = portCost;
+            bestPorts.clear();
+        }
+        if (portCost == bestCost) {
+            bestPorts.push_back(port);
+        }
+    }
+    if (bestPorts.empty()) {
+        return -1;
+    }
+    cost = bestCost;
+    return bestPorts[hash64 % bestPorts.size()];
+}
+
+int UbRoutingProcess::SelectAdaptiveOutPort(RoutingKey &rtKey, uint32_t dip, Ptr<UbQueueManager> queueManager,
+    Ptr<Node> node, uint16_t inPort)
+{
+    if (!rtKey.usePacketSpray && !m_flowletEnabled) {
+        // 逐流保序的报文逐包自适应会在流中途换路导致乱序，保持按流hash的路径
+        return SelectOutPort(rtKey.sip, dip, rtKey.sport, rtKey.dport, rtKey.priority, rtKey.useShortestPath,
+            false, inPort);
+    }
+    uint64_t hash64 = 0;
+    if (rtKey.usePacketSpray) {
+        hash64 = CalcHash(rtKey.sip, dip, rtKey.sport, rtKey.dport, rtKey.priority);
+    } else {
+        hash64 = CalcHash(rtKey.sip, dip, 0, 0, rtKey.priority);
+    }
+    FlowletEntry *flowlet = nullptr;
+    if (!rtKey.usePacketSpray) {
+        // 逐流报文只在flowlet边界按代价重新选路，flowlet内沿用原端口
+        flowlet = &GetFlowletEntry(hash64);
+        if (IsFlowletActive(*flowlet, hash64) && flowlet->outPort != inPort) {
+            auto shortestPorts = GetShortestOutPorts(dip);
+            bool shortest = std::find(shortestPorts.begin(), shortestPorts.end(), flowlet->outPort) !=
+                shortestPorts.end();
+            auto otherPorts = rtKey.useShortestPath ? std::vector<uint16_t>() : GetOtherOutPorts(dip);
+            if (shortest || std::find(otherPorts.begin(), otherPorts.end(), flowlet->outPort) != otherPorts.end()) {
+                flowlet->lastSeen = Simulator::Now();
+                m_selectShortestPaths = shortest;
+                return flowlet->outPort;
+            }
+        }
+    }
+    int outPort = SelectUgalOutPort(rtKey, dip, hash64, queueManager, node, inPort);
+    if (flowlet != nullptr && outPort != -1) {
+        NS_LOG_DEBUG("[UbRoutingProcess Adaptive] new flowlet, hash: " << hash64 << " port: " << outPort);
+        flowlet->hash = hash64;
+        flowlet->lastSeen = Simulator::Now();
+        flowlet->outPort = outPort;
+        flowlet->valid = true;
+    }
+    return outPort;
+}
+
+int UbRoutingProcess::SelectUgalOutPort(RoutingKey &rtKey, uint32_t dip, uint64_t hash64,
+    Ptr<UbQueueManager> queueManager, Ptr<Node> node, uint16_t inPort)
+{
+    uint64_t minCost = 0;
+    int minPort = SelectLeastCostPort(GetShortestOutPorts(dip), inPort, hash64, rtKey.priority,
+        queueManager, node, minCost);
+    m_selectShortestPaths = true;
+    // 只走最短路径，或者已经绕路过一次(包头路由策略被改为最短路径)，不再考虑绕路
+    if (rtKey.useShortestPath) {
+        return minPort;
+    }
+    uint64_t nonMinCost = 0;
+    int nonMinPort = SelectLeastCostPort(GetOtherOutPorts(dip), inPort, hash64, rtKey.priority,
+        queueManager, node, nonMinCost);
+    if (nonMinPort == -1) {
+        return minPort;
+    }
+    // UGAL：最短路径代价明显高于绕路代价(按跳数放大)时才绕路
+    if (minPort == -1 || minCost > m_ugalBias * nonMinCost + m_ugalThreshold) {
+        NS_LOG_DEBUG("[UbRoutingProcess Adaptive] non-minimal port: " << nonMinPort
+                    << " cost: " << nonMinCost
+                    << " minimal port: " << minPort
+                    << " cost: " << minCost);
+        m_selectShortestPaths = false;
+        return nonMinPort;
+    }
+    return minPort;
 }
 
 uint64_t UbRoutingProcess::CalcHash(uint32_t sip, uint32_t dip, uint16_t sport, uint16_t dport, uint8_t priority)
@@ -160,6 +325,9 @@ int UbRoutingProcess::SelectOutPort(uint32_t sip, uint32_t dip, uint16_t sport,
         }
         if (validPorts.size() == 0)
             return -1;
+        if (m_flowletEnabled && !usePacketSpray) {
+            return SelectFlowletPort(hash64, validPorts);
+        }
         idx = hash64 % validPorts.size();
         return validPorts[idx];
     } else {
@@ -172,15 +340,56 @@ int UbRoutingProcess::SelectOutPort(uint32_t sip, uint32_t dip, uint16_t sport,
         }
         if (validPorts.size() == 0)
             return -1;
-        idx = hash64 % validPorts.size();
+        uint16_t outPort = 0;
+        if (m_flowletEnabled && !usePacketSpray) {
+            outPort = SelectFlowletPort(hash64, validPorts);
+        } else {
+            idx = hash64 % validPorts.size();
+            outPort = validPorts[idx];
+        }
         auto shortestOutPorts = GetShortestOutPorts(dip);
-        if (std::find(shortestOutPorts.begin(), shortestOutPorts.end(), validPorts[idx]) != shortestOutPorts.end()) {
+        if (std::find(shortestOutPorts.begin(), shortestOutPorts.end(), outPort) != shortestOutPorts.end()) {
             m_selectShortestPaths = true;
         } else {
             m_selectShortestPaths = false;
         }
-        return validPorts[idx];
+        return outPort;
+    }
+}
+
+UbRoutingProcess::FlowletEntry& UbRoutingProcess::GetFlowletEntry(uint64_t hash64)
+{
+    if (m_flowletTable.empty()) {
+        m_flowletTable.resize(m_flowletTableSize);
+    }
+    return m_flowletTable[hash64 % m_flowletTable.size()];
+}
+
+bool UbRoutingProcess::IsFlowletActive(const FlowletEntry& entry, uint64_t hash64) const
+{
+    return entry.valid && entry.hash == hash64 && Simulator::Now() - entry.lastSeen < m_flowletTimeout;
+}
+
+uint16_t UbRoutingProcess::SelectFlowletPort(uint64_t hash64, const std::vector<uint16_t>& validPorts)
+{
+    Time now = Simulator::Now();
+    FlowletEntry& entry = GetFlowletEntry(hash64);
+    if (IsFlowletActive(entry, hash64) &&
+        std::find(validPorts.begin(), validPorts.end(), entry.outPort) != validPorts.end()) {
+        // 仍在同一个flowlet内，沿用原端口，避免乱序
+        entry.lastSeen = now;
+        return entry.outPort;
     }
+    // 新flowlet：随机重新选路，表项冲突时直接覆盖
+    uint32_t idx = m_flowletRandom->GetInteger(0, validPorts.size() - 1);
+    NS_LOG_DEBUG("[UbRoutingProcess Flowlet] new flowlet, hash: " << hash64
+                << " old port: " << (entry.valid ? (int)entry.outPort : -1)
+                << " new port: " << validPorts[idx]);
+    entry.hash = hash64;
+    entry.lastSeen = now;
+    entry.outPort = validPorts[idx];
+    entry.valid = true;
+    return entry.outPort;
 }
 
 bool UbRoutingProcess::GetSelectShortestPath()
@@ -3,11 +3,14 @@
 #define UB_ROUTING_PROCESS_H
 
 #include "ns3/node.h"
+#include "ns3/nstime.h"
+#include "ns3/random-variable-stream.h"
 #include <set>
 namespace ns3 {
 
 class UbQueueManager;
 class UbController;
+class UbPort;
 class UbPacketQueue;
 
 using VirtualOutputQueue_t = std::vector<std::vector<std::vector<Ptr<UbPacketQueue> > > >;
@@ -44,7 +47,10 @@ public:
     
     // 获取指定目的IP的出端口
     int GetOutPort(RoutingKey &rtKey, uint16_t inPort = UINT16_MAX);
-    int GetOutPort(Ptr<Packet> packet, Ptr<UbQueueManager> queueManager, Ptr<UbController> ctrl);
+    // 自适应路由：按本地出口队列占用(及可选的CBFC信用)在候选端口间选择，UGAL方式决定是否绕路
+    int GetOutPort(RoutingKey &rtKey, Ptr<UbQueueManager> queueManager, Ptr<Node> node,
+        uint16_t inPort = UINT16_MAX);
+    bool IsAdaptiveRoutingEnabled() { return m_adaptiveEnabled; }
     int SelectOutPort(uint32_t sip, uint32_t dip, uint16_t sport, uint16_t dport,
         uint8_t priority, bool rp, bool lbm, uint16_t inPort = UINT16_MAX);
     // 删除路由条目
@@ -67,6 +73,41 @@ private:
     bool m_selectShortestPaths = false;
     uint64_t CalcHash(uint32_t sip, uint32_t dip, uint16_t sport, uint16_t dport, uint8_t priority);
 
+    // flowlet表项，按流hash直接寻址，hash冲突时以完整hash区分
+    struct FlowletEntry {
+        uint64_t hash = 0;
+        Time lastSeen;
+        uint16_t outPort = UINT16_MAX;
+        bool valid = false;
+    };
+    // flowlet模式下选择出端口：同一flowlet内沿用上次端口，间隔超过超时时间才重新选路
+    uint16_t SelectFlowletPort(uint64_t hash64, const std::vector<uint16_t>& validPorts);
+    FlowletEntry& GetFlowletEntry(uint64_t hash64);
+    bool IsFlowletActive(const FlowletEntry& entry, uint64_t hash64) const;
+
+    // 自适应路由：端口拥塞代价(字节)，CBFC信用耗尽的端口代价最大
+    uint64_t GetPortCost(uint16_t port, uint8_t priority, Ptr<UbQueueManager> queueManager, Ptr<Node> node);
+    // 在候选端口中选代价最小者，代价相同按hash打散，返回-1表示无可用端口
+    int SelectLeastCostPort(const std::vector<uint16_t>& ports, uint16_t inPort, uint64_t hash64,
+        uint8_t priority, Ptr<UbQueueManager> queueManager, Ptr<Node> node, uint64_t &cost);
+    // 逐包喷洒的报文每包自适应；逐流报文只在flowlet边界自适应，未开启flowlet时按流hash选路
+    int SelectAdaptiveOutPort(RoutingKey &rtKey, uint32_t dip, Ptr<UbQueueManager> queueManager,
+        Ptr<Node> node, uint16_t inPort);
+    // UGAL：在最短路径与绕路路径中按代价选择出端口
+    int SelectUgalOutPort(RoutingKey &rtKey, uint32_t dip, uint64_t hash64, Ptr<UbQueueManager> queueManager,
+        Ptr<Node> node, uint16_t inPort);
+
+    bool m_flowletEnabled;
+    Time m_flowletTimeout;
+    uint32_t m_flowletTableSize;
+    std::vector<FlowletEntry> m_flowletTable;
+    Ptr<UniformRandomVariable> m_flowletRandom;
+
+    bool m_adaptiveEnabled;
+    bool m_adaptiveUseCredits;
+    double m_ugalBias;             // 绕路路径代价放大系数，非最短路径约为两倍跳数
+    uint32_t m_ugalThreshold;      // 最短路径代价超过绕路代价该字节数后才绕路
+
     // 全局端口集合池：存储所有唯一的端口集合
     std::unordered_map<std::vector<uint16_t>, std::shared_ptr<std::vector<uint16_t> >, VectorHash> m_portSetPool;
     
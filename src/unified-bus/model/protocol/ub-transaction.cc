@@ -1,6 +1,7 @@
 // SPDX-License-Identifier: GPL-2.0-only
 #include "ns3/log.h"
 #include "ns3/simulator.h"
+#include "ns3/enum.h"
 
 #include "ns3/ub-datatype.h"
 #include "ns3/ub-controller.h"
@@ -16,7 +17,14 @@ TypeId UbTransaction::GetTypeId(void)
 {
     static TypeId tid = TypeId("ns3::UbTransaction")
         .SetParent<Object>()
-        .SetGroupName("UnifiedBus");
+        .SetGroupName("UnifiedBus")
+        .AddAttribute("TpSelectionPolicy",
+                      "How a multi-path jetty steers its next WQE segment among bound TPs.",
+                      EnumValue(TpSelectionPolicy::ROUND_ROBIN),
+                      MakeEnumAccessor<TpSelectionPolicy>(&UbTransaction::m_tpSelectionPolicy),
+                      MakeEnumChecker(TpSelectionPolicy::ROUND_ROBIN, "RoundRobin",
+                                      TpSelectionPolicy::LEAST_OUTSTANDING, "LeastOutstanding",
+                                      TpSelectionPolicy::LEAST_RTT, "LeastRtt"));
     return tid;
 }
 
@@ -224,6 +232,17 @@ void UbTransaction::ScheduleWqeSegment(Ptr<UbTransportChannel> tp)
             if (currentJetty == nullptr) {
                 continue;
             }
+            // 多路径jetty的segment优先交给负载更轻的TP，当前tp跳过该jetty
+            if (m_tpSelectionPolicy != TpSelectionPolicy::ROUND_ROBIN) {
+                Ptr<UbTransportChannel> preferTp = SelectPreferredTp(currentJetty->GetJettyNum(), tp);
+                if (preferTp != tp) {
+                    // 目标TP已发完所有包，不会再主动申请调度，需要唤醒
+                    if (preferTp->IsSendCompleted()) {
+                        ApplyScheduleWqeSegment(preferTp);
+                    }
+                    continue;
+                }
+            }
             wqeSegment = currentJetty->GetNextWqeSegment();
             if (wqeSegment == nullptr) {
                 continue;
@@ -278,6 +297,46 @@ void UbTransaction::OnScheduleWqeSegmentFinish(Ptr<UbWqeSegment> segment)
     ScheduleWqeSegment(tp);
 }
 
+Ptr<UbTransportChannel> UbTransaction::SelectPreferredTp(uint32_t jettyNum, Ptr<UbTransportChannel> tp)
+{
+    auto it = m_jettyTpGroup.find(jettyNum);
+    if (it == m_jettyTpGroup.end()) {
+        return tp;
+    }
+    Ptr<UbTransportChannel> best = tp;
+    uint64_t bestBytes = tp->GetOutstandingBytes();
+    Time bestRtt = tp->GetSmoothedRtt();
+    Ptr<UbJetty> jetty = GetJetty(jettyNum);
+    for (auto candidate : it->second) {
+        if (candidate == tp || candidate->IsWqeSegmentLimited()) {
+            continue;
+        }
+        // 仅考虑与该jetty实际绑定的TP(单路径模式下只绑定了一个)
+        auto &jetties = m_tpRelatedJetties[candidate->GetTpn()];
+        if (std::find(jetties.begin(), jetties.end(), jetty) == jetties.end()) {
+            continue;
+        }
+        bool better = false;
+        if (m_tpSelectionPolicy == TpSelectionPolicy::LEAST_OUTSTANDING) {
+            better = candidate->GetOutstandingBytes() < bestBytes;
+        } else {
+            // 未测得RTT的TP视为最优，便于探测新路径；RTT相同(如都未测得)时比较未确认字节数
+            Time rtt = candidate->GetSmoothedRtt();
+            better = rtt < bestRtt || (rtt == bestRtt && candidate->GetOutstandingBytes() < bestBytes);
+        }
+        if (better) {
+            best = candidate;
+            bestBytes = candidate->GetOutstandingBytes();
+            bestRtt = candidate->GetSmoothedRtt();
+        }
+    }
+    if (best != tp) {
+        NS_LOG_DEBUG("Jetty " << jettyNum << " steers segment from tpn " << tp->GetTpn()
+                     << " to tpn " << best->GetTpn());
+    }
+    return best;
+}
+
 bool UbTransaction::ProcessWqeSegmentComplete(Ptr<UbWqeSegment> wqeSegment)
 {
     Ptr<UbJetty> jetty = GetJetty(wqeSegment->GetJettyNum());
@@ -21,6 +21,15 @@ namespace ns3 {
         UNO = 3     // Unreliable No Order
     };
 
+    /**
+     * @brief 多路径jetty选择TP的策略
+     */
+    enum class TpSelectionPolicy : uint8_t {
+        ROUND_ROBIN = 0,        // TP空闲时轮询拉取jetty的segment
+        LEAST_OUTSTANDING = 1,  // segment交给未确认字节数最少的TP
+        LEAST_RTT = 2           // segment交给平滑RTT最小的TP，RTT相同时比较未确认字节数
+    };
+
     class UbController;
     class UbJetty;
     class UbFunction;
@@ -86,6 +95,11 @@ namespace ns3 {
 
         void OnScheduleWqeSegmentFinish(Ptr<UbWqeSegment> segment);
 
+        // 按TpSelectionPolicy在jetty绑定的TP中选出最适合接收下一个segment的TP，相同时保留当前tp
+        Ptr<UbTransportChannel> SelectPreferredTp(uint32_t jettyNum, Ptr<UbTransportChannel> tp);
+
+        TpSelectionPolicy m_tpSelectionPolicy = TpSelectionPolicy::ROUND_ROBIN;
+
         uint32_t m_nodeId;
 
         // Tpn和Tp的对应map
@@ -1,9 +1,11 @@
 // SPDX-License-Identifier: GPL-2.0-only
+#include <cmath>
 #include "ns3/log.h"
 #include "ns3/simulator.h"
 #include "ns3/ub-controller.h"
 #include "ns3/ub-transaction.h"
 #include "ns3/ub-caqm.h"
+#include "ns3/ub-dcqcn.h"
 #include "../ub-network-address.h"
 #include "ns3/node.h"
 #include "ns3/ub-switch.h"
@@ -68,6 +70,21 @@ TypeId UbTransportChannel::GetTypeId(void)
                       BooleanValue(true),
                       MakeBooleanAccessor(&UbTransportChannel::m_useShortestPaths),
                       MakeBooleanChecker())
+        .AddAttribute("EnablePacing",
+                      "Enable per-TP packet pacing to smooth bursts.",
+                      BooleanValue(false),
+                      MakeBooleanAccessor(&UbTransportChannel::m_pacingEnabled),
+                      MakeBooleanChecker())
+        .AddAttribute("PacingRate",
+                      "Target pacing rate of TP payload. 0bps means cwnd/RTT from congestion control.",
+                      DataRateValue(DataRate("0bps")),
+                      MakeDataRateAccessor(&UbTransportChannel::m_pacingRate),
+                      MakeDataRateChecker())
+        .AddAttribute("PacingBurstSize",
+                      "Token bucket depth of the pacer in bytes.",
+                      UintegerValue(UB_MTU_BYTE),
+                      MakeUintegerAccessor(&UbTransportChannel::m_pacingBurstSize),
+                      MakeUintegerChecker<uint32_t>())
         .AddTraceSource("FirstPacketSendsNotify",
                         "Fires when the first packet of a WQE segment is sent.",
                         MakeTraceSourceAccessor(&UbTransportChannel::m_traceFirstPacketSendsNotify),
@@ -127,6 +144,7 @@ void UbTransportChannel::DoDispose()
     m_wqeSegmentVector.clear();
     m_congestionCtrl = nullptr;
     m_recvPsnBitset.clear();
+    m_pacingEvent.Cancel();
 }
 
 /**
@@ -174,10 +192,22 @@ Ptr<Packet> UbTransportChannel::GetNextPacket()
             }
             NS_LOG_DEBUG("[Caqm send][restCwnd] Rest cwnd:" << rest);
         }
+        // 速率类算法或pacer限速时，令牌不足则等待唤醒
+        Time delay = GetSendDelay(payload_size);
+        if (!delay.IsZero()) {
+            SchedulePacingWakeup(delay);
+            return nullptr;
+        }
 
         Ptr<Packet> p = GenDataPacket(currentSegment, payload_size);
 
         m_congestionCtrl->SenderUpdateCongestionCtrlData(m_psnSndNxt, payload_size);
+        PacerConsume(payload_size);
+        if (!m_rttSampling) {
+            m_rttSampling = true;
+            m_rttSamplePsn = m_psnSndNxt;
+            m_rttSampleTime = Simulator::Now();
+        }
 
         if (currentSegment->GetBytesLeft() == currentSegment->GetSize()) {
             // wqe segment first packet
@@ -244,6 +274,31 @@ uint32_t UbTransportChannel::GetNextPacketSize()
     if (!m_ackQ.empty()) {
         return m_ackQ.front()->GetSize();
     }
+    uint32_t payload_size = PeekNextPayloadSize();
+    if (payload_size > 0) {
+        pktSize = payload_size + headerSize;
+    }
+    return pktSize;
+}
+
+uint64_t UbTransportChannel::GetOutstandingBytes() const
+{
+    uint64_t bytes = 0;
+    for (const auto &segment : m_wqeSegmentVector) {
+        uint64_t psnEnd = segment->GetPsnStart() + segment->GetPsnSize();
+        if (m_psnSndUna >= psnEnd) {
+            continue;
+        }
+        // 除尾包外每个psn承载一个MTU
+        uint64_t ackedPsn = m_psnSndUna > segment->GetPsnStart() ? m_psnSndUna - segment->GetPsnStart() : 0;
+        uint64_t ackedBytes = std::min<uint64_t>(ackedPsn * UB_MTU_BYTE, segment->GetSize());
+        bytes += segment->GetSize() - ackedBytes;
+    }
+    return bytes;
+}
+
+uint32_t UbTransportChannel::PeekNextPayloadSize()
+{
     for (size_t i = 0; i < m_wqeSegmentVector.size(); ++i) {
         Ptr<UbWqeSegment> currentSegment = m_wqeSegmentVector[i];
         if (currentSegment == nullptr || currentSegment->IsSentCompleted()) {
@@ -253,10 +308,9 @@ uint32_t UbTransportChannel::GetNextPacketSize()
         if (payload_size > UB_MTU_BYTE) {
             payload_size = UB_MTU_BYTE;
         }
-        pktSize = payload_size + headerSize;
-        return pktSize;
+        return payload_size;
     }
-    return pktSize;
+    return 0;
 }
 Ptr<Packet> UbTransportChannel::GenDataPacket(Ptr<UbWqeSegment> wqeSegment, uint32_t payload_size)
 {
@@ -304,7 +358,7 @@ Ptr<Packet> UbTransportChannel::GenDataPacket(Ptr<UbWqeSegment> wqeSegment, uint
     UbPort::AddIpv4Header(p, this);
     // add network header
     UbNetworkHeader networkHeader;
-    if (m_congestionCtrl->GetCongestionAlgo() == CAQM) {
+    if (m_congestionCtrl->GetCongestionAlgo() == CAQM || m_congestionCtrl->GetCongestionAlgo() == DCQCN) {
         networkHeader = m_congestionCtrl->SenderGenNetworkHeader();
     }
     p->AddHeader(networkHeader);
@@ -338,6 +392,11 @@ void UbTransportChannel::RecvTpAck(Ptr<Packet> p)
     // 拿到多个packet后组成taack发送
     if ((TpHeader.GetPsn() + 1) > m_psnSndUna) {
         m_psnSndUna = TpHeader.GetPsn() + 1;
+        if (m_rttSampling && m_psnSndUna > m_rttSamplePsn) {
+            Time rtt = Simulator::Now() - m_rttSampleTime;
+            m_srtt = m_srtt.IsZero() ? rtt : (m_srtt * 7 + rtt) / 8;
+            m_rttSampling = false;
+        }
         if (m_sendWindowLimited && IsInflightLimited() == false) {
             m_sendWindowLimited = false;
             Ptr<UbPort> port = DynamicCast<UbPort>(NodeList::GetNode(m_nodeId)->GetDevice(m_sport));
@@ -411,6 +470,114 @@ void UbTransportChannel::RecvTpAck(Ptr<Packet> p)
     NS_LOG_DEBUG("Recv TP(data packet) acknowledgment");
 }
 
+/**
+ * @brief Receive Congestion Notification Packet
+ * @param p CNP packet, headers before tp header are removed
+ */
+void UbTransportChannel::RecvCnp(Ptr<Packet> p)
+{
+    UbTransportHeader TpHeader;
+    p->RemoveHeader(TpHeader);
+    NS_LOG_DEBUG("[Transport channel] Recv cnp."
+                  << " PacketUid: " << p->GetUid()
+                  << " Tpn: " << m_tpn
+                  << " Src: " << m_src
+                  << " Dst: " << m_dest);
+    m_congestionCtrl->SenderRecvCnp();
+}
+
+/**
+ * @brief Send Congestion Notification Packet back to sender through ack queue
+ */
+void UbTransportChannel::SendCnp(const Ipv4Header &ipv4Header, const UdpHeader &udpHeader,
+                                 const UbDatalinkPacketHeader &pktHeader)
+{
+    Ptr<Packet> cnp = Create<Packet>(0);
+    UbTransportHeader TpHeader;
+    TpHeader.SetTPOpcode(TpOpcode::TP_OPCODE_CNP);
+    TpHeader.SetNLP(0x0);
+    TpHeader.SetSrcTpn(m_tpn);
+    TpHeader.SetDestTpn(m_dstTpn);
+    TpHeader.SetPsn(m_psnRecvNxt);
+    cnp->AddHeader(TpHeader);
+    cnp->AddHeader(udpHeader);
+    UbPort::AddIpv4Header(cnp, ipv4Header.GetDestination(), ipv4Header.GetSource());
+    UbNetworkHeader networkHeader;
+    cnp->AddHeader(networkHeader);
+    UbDataLink::GenPacketHeader(cnp, false, true, pktHeader.GetCreditTargetVL(), pktHeader.GetPacketVL(),
+        0, 1, UbDatalinkHeaderConfig::PACKET_IPV4);
+    m_ackQ.push(cnp);
+    NS_LOG_DEBUG("[Transport channel] Send cnp."
+                  << " PacketUid: " << cnp->GetUid()
+                  << " Tpn: " << m_tpn
+                  << " Src: " << m_src
+                  << " Dst: " << m_dest);
+    Ptr<UbPort> port = DynamicCast<UbPort>(NodeList::GetNode(m_nodeId)->GetDevice(m_sport));
+    port->TriggerTransmit(); // 触发发送
+}
+
+Time UbTransportChannel::GetSendDelay(uint32_t payloadSize)
+{
+    Time ccDelay = m_congestionCtrl->GetSendDelay(payloadSize);
+    Time pacerDelay = GetPacerDelay(payloadSize);
+    return ccDelay > pacerDelay ? ccDelay : pacerDelay;
+}
+
+Time UbTransportChannel::GetPacerDelay(uint32_t payloadSize)
+{
+    if (!m_pacingEnabled) {
+        return Time(0);
+    }
+    DataRate rate = m_pacingRate;
+    if (rate.GetBitRate() == 0) {
+        rate = m_congestionCtrl->GetPacingRate();
+    }
+    if (rate.GetBitRate() == 0) {
+        // 尚无速率估计(如未测得RTT)，不做限制
+        return Time(0);
+    }
+    Time now = Simulator::Now();
+    // 桶深至少容纳一个包，否则令牌永远不足
+    double bucketSize = std::max<double>(m_pacingBurstSize, payloadSize);
+    if (m_pacingTokens < 0) {
+        m_pacingTokens = bucketSize;
+    } else {
+        m_pacingTokens += (now - m_pacingLastRefill).GetSeconds() * rate.GetBitRate() / 8;
+        if (m_pacingTokens > bucketSize) {
+            m_pacingTokens = bucketSize;
+        }
+    }
+    m_pacingLastRefill = now;
+    if (m_pacingTokens >= payloadSize) {
+        return Time(0);
+    }
+    return rate.CalculateBytesTxTime(uint32_t(std::ceil(payloadSize - m_pacingTokens)));
+}
+
+void UbTransportChannel::PacerConsume(uint32_t payloadSize)
+{
+    if (m_pacingEnabled && m_pacingTokens >= 0) {
+        m_pacingTokens -= payloadSize;
+    }
+}
+
+void UbTransportChannel::SchedulePacingWakeup(Time delay)
+{
+    if (m_pacingEvent.IsPending()) {
+        if (Simulator::GetDelayLeft(m_pacingEvent) <= delay) {
+            return;
+        }
+        m_pacingEvent.Cancel();
+    }
+    m_pacingEvent = Simulator::Schedule(delay, &UbTransportChannel::PacingWakeup, this);
+}
+
+void UbTransportChannel::PacingWakeup()
+{
+    Ptr<UbPort> port = DynamicCast<UbPort>(NodeList::GetNode(m_nodeId)->GetDevice(m_sport));
+    port->TriggerTransmit(); // 触发发送
+}
+
 
 void UbTransportChannel::SetUbTransport(uint32_t nodeId,
                                         uint32_t src,
@@ -491,6 +658,10 @@ void UbTransportChannel::RecvDataPacket(Ptr<Packet> p)
                      PacketType::PACKET, p->GetSize(), flowTag.GetFlowId(), traceTag);
     }
     ackp->AddPacketTag(flowTag);
+    // 收到拥塞标记的数据包，按需回复CNP
+    if (m_congestionCtrl->RecverCheckCnp(NetworkHeader)) {
+        SendCnp(ipv4Header, udpHeader, pktHeader);
+    }
     if (TpHeader.GetLastPacket()) {
         // 尾包被接收
         LastPacketReceivesNotify(m_nodeId, TpHeader.GetSrcTpn(), TpHeader.GetDestTpn(), TpHeader.GetTpMsn(),
@@ -605,6 +776,7 @@ void UbTransportChannel::ReTxTimeout()
     NS_ASSERT_MSG (m_retransAttemptsLeft > 0, "Avaliable retransmission attempts exhausted.");
     // 重传逻辑
     m_psnSndNxt = m_psnSndUna; // 将发送指针回退到未确认的包
+    m_rttSampling = false;     // 重传包的ack无法区分，放弃本次RTT采样
     // 重置已发送字节数
     for (size_t i = 0; i < m_wqeSegmentVector.size(); ++i) {
         Ptr<UbWqeSegment> currentSegment = m_wqeSegmentVector[i];
@@ -729,15 +901,19 @@ bool UbTransportChannel::IsEmpty()
         NS_LOG_DEBUG("Full Send Window");
         return true;
     }
-    if (m_congestionCtrl->GetCongestionAlgo() == CAQM) {
-        if (m_congestionCtrl->GetRestCwnd() >= UB_MTU_BYTE && m_psnSndNxt < m_tpPsnCnt) {
-            return false;
-        } else {
-            return true;
-        }
-    } else {
-        return m_psnSndNxt >= m_tpPsnCnt;
+    if (m_psnSndNxt >= m_tpPsnCnt) {
+        return true;
     }
+    if (m_congestionCtrl->GetCongestionAlgo() == CAQM && m_congestionCtrl->GetRestCwnd() < UB_MTU_BYTE) {
+        return true;
+    }
+    // 速率类算法或pacer限速，令牌不足时视为空，到时间由唤醒事件重新触发端口
+    Time delay = GetSendDelay(PeekNextPayloadSize());
+    if (!delay.IsZero()) {
+        SchedulePacingWakeup(delay);
+        return true;
+    }
+    return false;
 }
 
 IngressQueueType UbTransportChannel::GetIqType()
@@ -6,7 +6,10 @@
 #include "ns3/object.h"
 #include "ns3/packet.h"
 #include "ns3/ipv4-address.h"
+#include "ns3/ipv4-header.h"
+#include "ns3/udp-header.h"
 #include "ns3/callback.h"
+#include "ns3/data-rate.h"
 #include "ub-header.h"
 #include "ns3/timer.h"
 #include "ns3/ub-congestion-control.h"
@@ -78,7 +81,7 @@ public:
      * @param port Port to send through
      */
     Ptr<Packet> GetNextPacket() override;
-    uint32_t GetNextPacketSize();
+    uint32_t GetNextPacketSize() override;
     bool IsEmpty() override;
 
     Ptr<Packet> GenDataPacket(Ptr<UbWqeSegment> wqeSegment, uint32_t payload_size);
@@ -89,6 +92,12 @@ public:
      */
     void RecvTpAck(Ptr<Packet> p);
 
+    /**
+     * @brief Process Congestion Notification Packet, rate based congestion control only
+     * @param p CNP packet
+     */
+    void RecvCnp(Ptr<Packet> p);
+
     void SetUbTransport(uint32_t nodeId,
                         uint32_t src,
                         uint32_t dest,
@@ -232,11 +241,37 @@ public:
     void PushWqeSegment(Ptr<UbWqeSegment> segment) { m_wqeSegmentVector.push_back(segment); }
 
     uint32_t GetWqeSegmentVecSize() { return m_wqeSegmentVector.size(); }
+
+    /**
+     * @brief Bytes assigned to this TP but not yet acknowledged
+     */
+    uint64_t GetOutstandingBytes() const;
+
+    /**
+     * @brief Whether all assigned packets have been sent
+     */
+    bool IsSendCompleted() const { return m_psnSndNxt >= m_tpPsnCnt; }
+
+    /**
+     * @brief Smoothed RTT measured from data packet to ACK, zero before the first sample
+     */
+    Time GetSmoothedRtt() const { return m_srtt; }
 private:
     void DoDispose() override;
 
     Ptr<UbTransaction> GetTransaction();
 
+    uint32_t PeekNextPayloadSize();
+    void SendCnp(const Ipv4Header &ipv4Header, const UdpHeader &udpHeader, const UbDatalinkPacketHeader &pktHeader);
+    // 发送payloadSize字节前需要等待的时间，综合拥塞控制算法限速与TP pacer
+    Time GetSendDelay(uint32_t payloadSize);
+    // TP pacer令牌桶，速率取PacingRate，未配置时取拥塞控制算法给出的cwnd/RTT
+    Time GetPacerDelay(uint32_t payloadSize);
+    void PacerConsume(uint32_t payloadSize);
+    // 速率受限时只保留一个唤醒事件，令牌足够时触发端口发送
+    void SchedulePacingWakeup(Time delay);
+    void PacingWakeup();
+
     TracedCallback<uint32_t, uint32_t, uint32_t, uint32_t, uint32_t, uint32_t, uint32_t> m_traceFirstPacketSendsNotify;
     TracedCallback<uint32_t, uint32_t, uint32_t, uint32_t, uint32_t, uint32_t, uint32_t> m_traceLastPacketSendsNotify;
     TracedCallback<uint32_t, uint32_t, uint32_t, uint32_t, uint32_t, uint32_t, uint32_t> m_traceLastPacketACKsNotify;
@@ -310,6 +345,19 @@ private:
     uint16_t m_maxRetransAttempts;
     uint16_t m_retransExponentFactor;
     EventId m_retransEvent{};        //!< Retransmission event
+    EventId m_pacingEvent{};         //!< Pacing wakeup event
+
+    // RTT采样：同一时刻只跟踪一个psn，重传时放弃本次采样
+    bool m_rttSampling = false;
+    uint64_t m_rttSamplePsn = 0;
+    Time m_rttSampleTime;
+    Time m_srtt;
+
+    bool m_pacingEnabled;
+    DataRate m_pacingRate;           // 0bps表示按cwnd/RTT计算
+    uint32_t m_pacingBurstSize;      // 令牌桶深度(字节)
+    double m_pacingTokens = -1;      // 当前令牌(字节)，<0表示尚未初始化
+    Time m_pacingLastRefill;
     Time m_rto;                      //!< Retransmit timeout 25600ns
     uint16_t m_retransAttemptsLeft ; // 剩余的重传次数
 
@@ -0,0 +1,112 @@
+// SPDX-License-Identifier: GPL-2.0-only
+#include <algorithm>
+#include <sstream>
+#include <unordered_map>
+#include "ns3/log.h"
+#include "ns3/string.h"
+#include "ns3/uinteger.h"
+#include "ns3/ub-address-map.h"
+
+namespace ns3 {
+NS_LOG_COMPONENT_DEFINE("UbAddressMap");
+NS_OBJECT_ENSURE_REGISTERED(UbAddressMap);
+
+TypeId UbAddressMap::GetTypeId(void)
+{
+    static TypeId tid = TypeId("ns3::UbAddressMap")
+        .SetParent<Object>()
+        .SetGroupName("UnifiedBus")
+        .AddConstructor<UbAddressMap>()
+        .AddAttribute("MemoryNodes",
+                      "Memory nodes the global address space is striped across, e.g. \"1..16\" or \"2,4,6..9\". "
+                      "Empty disables memory pooling.",
+                      StringValue(""),
+                      MakeStringAccessor(&UbAddressMap::SetMemoryNodes, &UbAddressMap::GetMemoryNodesStr),
+                      MakeStringChecker())
+        .AddAttribute("Interleave",
+                      "Size (in bytes) of a stripe placed on one memory node.",
+                      UintegerValue(4096),
+                      MakeUintegerAccessor(&UbAddressMap::m_interleave),
+                      MakeUintegerChecker<uint32_t>(1))
+        .AddAttribute("BaseAddress",
+                      "Start of the global address space.",
+                      UintegerValue(0),
+                      MakeUintegerAccessor(&UbAddressMap::m_baseAddress),
+                      MakeUintegerChecker<uint64_t>());
+    return tid;
+}
+
+UbAddressMap::UbAddressMap()
+{
+}
+
+UbAddressMap::~UbAddressMap()
+{
+}
+
+// 以逗号分隔, 每项为单个节点或"a..b"范围
+void UbAddressMap::SetMemoryNodes(std::string nodes)
+{
+    m_nodesStr = nodes;
+    m_nodes.clear();
+    std::stringstream ss(nodes);
+    std::string item;
+    while (getline(ss, item, ',')) {
+        if (item.find_first_not_of(" \t") == std::string::npos) {
+            continue;
+        }
+        size_t dotPos = item.find("..");
+        if (dotPos != std::string::npos) {
+            uint32_t start = std::stoul(item.substr(0, dotPos));
+            uint32_t end = std::stoul(item.substr(dotPos + 2));
+            NS_ASSERT_MSG(start <= end, "Invalid memory node range: " << item);
+            for (uint32_t i = start; i <= end; i++) {
+                m_nodes.push_back(i);
+            }
+        } else {
+            m_nodes.push_back(std::stoul(item));
+        }
+    }
+}
+
+std::string UbAddressMap::GetMemoryNodesStr() const
+{
+    return m_nodesStr;
+}
+
+void UbAddressMap::Map(uint64_t address, uint32_t &node, uint64_t &localAddress, uint64_t &bytesInStripe) const
+{
+    NS_ASSERT_MSG(IsEnabled(), "Memory pooling is not enabled");
+    NS_ASSERT_MSG(address >= m_baseAddress, "Address " << address << " below the global address space");
+    uint64_t offset = address - m_baseAddress;
+    uint64_t page = offset / m_interleave;
+    uint64_t pageOffset = offset % m_interleave;
+    node = m_nodes[page % m_nodes.size()];
+    localAddress = (page / m_nodes.size()) * m_interleave + pageOffset;
+    bytesInStripe = m_interleave - pageOffset;
+}
+
+std::vector<UbAddressMap::Range> UbAddressMap::Split(uint64_t address, uint64_t length) const
+{
+    std::vector<Range> ranges;
+    std::unordered_map<uint32_t, size_t> rangeIdx;
+    uint64_t end = address + length;
+    while (address < end) {
+        uint32_t node;
+        uint64_t localAddress;
+        uint64_t bytesInStripe;
+        Map(address, node, localAddress, bytesInStripe);
+        uint64_t size = std::min(bytesInStripe, end - address);
+        auto it = rangeIdx.find(node);
+        if (it == rangeIdx.end()) {
+            rangeIdx[node] = ranges.size();
+            ranges.push_back({node, localAddress, size});
+        } else {
+            ranges[it->second].size += size;
+        }
+        address += size;
+    }
+    return ranges;
+}
+
+} // namespace ns3
@@ -0,0 +1,60 @@
+// SPDX-License-Identifier: GPL-2.0-only
+#ifndef UB_ADDRESS_MAP_H
+#define UB_ADDRESS_MAP_H
+
+#include <string>
+#include <vector>
+#include "ns3/object.h"
+
+namespace ns3 {
+
+/**
+ * @brief 内存池化的全局物理地址空间
+ *
+ * [BaseAddress, ...)按Interleave大小的页轮询条带化到MemoryNodes的各内存节点上:
+ * 全局页号p落在第p % N个节点, 节点内地址为(p / N) * Interleave + 页内偏移。
+ * 因此一段连续全局地址在同一节点上的各条带在节点内地址上也是连续的, 一个task按目标节点切分即可。
+ * MemoryNodes为空时不启用, LD/ST task仍按traffic.csv/trace中的dest发送。
+ */
+class UbAddressMap : public Object {
+public:
+    static TypeId GetTypeId(void);
+    UbAddressMap();
+    ~UbAddressMap() override;
+
+    bool IsEnabled() const {return !m_nodes.empty();}
+    const std::vector<uint32_t> &GetMemoryNodes() const {return m_nodes;}
+    uint32_t GetInterleave() const {return m_interleave;}
+
+    /**
+     * @brief 全局地址所在的内存节点及节点内地址
+     * @param bytesInStripe 从该地址到所在条带末尾的字节数
+     */
+    void Map(uint64_t address, uint32_t &node, uint64_t &localAddress, uint64_t &bytesInStripe) const;
+
+    // 一个内存节点上的连续节点内区间
+    struct Range {
+        uint32_t node;
+        uint64_t address;
+        uint64_t size;
+    };
+    /**
+     * @brief 将全局区间[address, address + length)切分为各内存节点上的连续区间
+     *
+     * 同一节点上的各条带在节点内地址连续, 每个节点只产生一个区间, 按首次访问的顺序排列; length为0时返回空
+     */
+    std::vector<Range> Split(uint64_t address, uint64_t length) const;
+
+private:
+    void SetMemoryNodes(std::string nodes);
+    std::string GetMemoryNodesStr() const;
+
+    std::vector<uint32_t> m_nodes;
+    std::string m_nodesStr;
+    uint32_t m_interleave;
+    uint64_t m_baseAddress;
+};
+
+} // namespace ns3
+
+#endif /* UB_ADDRESS_MAP_H */
@@ -0,0 +1,452 @@
+// SPDX-License-Identifier: GPL-2.0-only
+#include <set>
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+#include "ns3/enum.h"
+#include "ns3/uinteger.h"
+#include "ns3/node-list.h"
+#include "ns3/hbm-cache.h"
+#include "ns3/hbm-controller.h"
+#include "ns3/ub-controller.h"
+#include "ns3/ub-ldst-api.h"
+#include "ns3/ub-coherence.h"
+
+namespace ns3 {
+NS_LOG_COMPONENT_DEFINE("UbCoherence");
+NS_OBJECT_ENSURE_REGISTERED(UbCoherenceDirectory);
+NS_OBJECT_ENSURE_REGISTERED(UbCoherenceAgent);
+
+namespace {
+Ptr<UbLdstApi> GetLdstApi(uint32_t nodeId)
+{
+    return NodeList::GetNode(nodeId)->GetObject<UbController>()->GetUbFunction()->GetUbLdstApi();
+}
+} // namespace
+
+TypeId UbCoherenceDirectory::GetTypeId(void)
+{
+    static TypeId tid = TypeId("ns3::UbCoherenceDirectory")
+        .SetParent<Object>()
+        .SetGroupName("UnifiedBus")
+        .AddConstructor<UbCoherenceDirectory>()
+        .AddAttribute("Protocol",
+                      "Coherence protocol of the home directory.",
+                      EnumValue(UbCoherenceDirectory::MESI),
+                      MakeEnumAccessor<Protocol>(&UbCoherenceDirectory::m_protocol),
+                      MakeEnumChecker(UbCoherenceDirectory::MSI, "Msi",
+                                      UbCoherenceDirectory::MESI, "Mesi"))
+        .AddAttribute("LineSize",
+                      "Coherence granularity (in bytes), a power of 2 between 64 and 8192.",
+                      UintegerValue(64),
+                      MakeUintegerAccessor(&UbCoherenceDirectory::m_lineSize),
+                      MakeUintegerChecker<uint32_t>(64, 8192))
+        .AddAttribute("LookupLatency",
+                      "Directory lookup time before snoops or the memory access are issued.",
+                      TimeValue(NanoSeconds(5)),
+                      MakeTimeAccessor(&UbCoherenceDirectory::m_lookupLatency),
+                      MakeTimeChecker());
+    return tid;
+}
+
+UbCoherenceDirectory::UbCoherenceDirectory()
+{
+}
+
+UbCoherenceDirectory::~UbCoherenceDirectory()
+{
+}
+
+void UbCoherenceDirectory::DoDispose()
+{
+    m_entries.clear();
+    m_waiting.clear();
+    Object::DoDispose();
+}
+
+void UbCoherenceDirectory::Init(uint32_t nodeId)
+{
+    NS_ASSERT_MSG((m_lineSize & (m_lineSize - 1)) == 0, "UbCoherenceDirectory LineSize must be a power of 2");
+    m_nodeId = nodeId;
+}
+
+bool UbCoherenceDirectory::TestSharer(const Entry &entry, uint32_t node)
+{
+    uint32_t word = node / 64;
+    return word < entry.sharers.size() && (entry.sharers[word] >> (node % 64) & 1);
+}
+
+void UbCoherenceDirectory::SetSharer(Entry &entry, uint32_t node)
+{
+    uint32_t word = node / 64;
+    if (word >= entry.sharers.size()) {
+        entry.sharers.resize(word + 1, 0);
+    }
+    entry.sharers[word] |= 1ULL << (node % 64);
+}
+
+void UbCoherenceDirectory::ClearSharer(Entry &entry, uint32_t node)
+{
+    uint32_t word = node / 64;
+    if (word < entry.sharers.size()) {
+        entry.sharers[word] &= ~(1ULL << (node % 64));
+    }
+}
+
+std::vector<uint32_t> UbCoherenceDirectory::GetSharers(const Entry &entry)
+{
+    std::vector<uint32_t> nodes;
+    for (uint32_t word = 0; word < entry.sharers.size(); word++) {
+        uint64_t bits = entry.sharers[word];
+        while (bits != 0) {
+            uint32_t bit = __builtin_ctzll(bits);
+            nodes.push_back(word * 64 + bit);
+            bits &= bits - 1;
+        }
+    }
+    return nodes;
+}
+
+uint32_t UbCoherenceDirectory::HandleRequest(uint32_t contextId, uint32_t src, uint64_t address, uint32_t size,
+                                             bool isWrite, uint8_t vl)
+{
+    uint32_t txnId = m_txns.Alloc();
+    // 事务号经侦听报文cTAH中16位的IniTaSsn往返
+    NS_ASSERT_MSG(txnId <= UINT16_MAX, "Too many outstanding coherence transactions");
+    Transaction &txn = m_txns[txnId];
+    txn.contextId = contextId;
+    txn.src = src;
+    txn.address = address;
+    txn.size = size;
+    txn.firstLine = address / m_lineSize;
+    txn.lastLine = (address + size - 1) / m_lineSize;
+    txn.isWrite = isWrite;
+    txn.vl = vl;
+    m_requests++;
+    m_waiting.push_back(txnId);
+    TryStart();
+    return txnId;
+}
+
+bool UbCoherenceDirectory::IsBusy(const Transaction &txn) const
+{
+    for (uint64_t line = txn.firstLine; line <= txn.lastLine; line++) {
+        auto it = m_entries.find(line);
+        if (it != m_entries.end() && it->second.busy) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief 按到达顺序开始不访问忙行的事务, 后到的请求不越过仍在等待的同一行上的请求
+ */
+void UbCoherenceDirectory::TryStart()
+{
+    std::set<uint64_t> reserved;
+    for (auto it = m_waiting.begin(); it != m_waiting.end();) {
+        Transaction &txn = m_txns[*it];
+        bool blocked = IsBusy(txn);
+        for (uint64_t line = txn.firstLine; !blocked && line <= txn.lastLine; line++) {
+            blocked = reserved.count(line) > 0;
+        }
+        if (!blocked) {
+            uint32_t txnId = *it;
+            it = m_waiting.erase(it);
+            Start(txnId);
+            continue;
+        }
+        if (!txn.waited) {
+            txn.waited = true;
+            m_conflicts++;
+        }
+        for (uint64_t line = txn.firstLine; line <= txn.lastLine; line++) {
+            reserved.insert(line);
+        }
+        ++it;
+    }
+}
+
+void UbCoherenceDirectory::Start(uint32_t txnId)
+{
+    Transaction &txn = m_txns[txnId];
+    // 侦听目标 -> 是否仅降级
+    std::map<uint32_t, bool> targets;
+    for (uint64_t line = txn.firstLine; line <= txn.lastLine; line++) {
+        Entry &entry = m_entries[line];
+        entry.busy = true;
+        if (txn.isWrite) {
+            for (auto node : GetSharers(entry)) {
+                if (node != txn.src) {
+                    targets[node] = false;
+                }
+            }
+        } else if (entry.state == UbCoherenceState::E || entry.state == UbCoherenceState::M) {
+            for (auto node : GetSharers(entry)) {
+                if (node != txn.src) {
+                    targets.emplace(node, true);
+                }
+            }
+        }
+    }
+    txn.pendingAcks = targets.size();
+    if (targets.empty()) {
+        Simulator::Schedule(m_lookupLatency, &UbCoherenceDirectory::IssueAccess, this, txnId);
+        return;
+    }
+    m_snoopedRequests++;
+    txn.snoopStart = Simulator::Now();
+    auto ldstApi = GetLdstApi(m_nodeId);
+    for (auto &[node, downgrade] : targets) {
+        if (downgrade) {
+            m_downgrades++;
+        } else {
+            m_invalidations++;
+        }
+        NS_LOG_DEBUG("[UbCoherenceDirectory] node " << m_nodeId << " txn " << txnId << " snoops node " << node
+                     << (downgrade ? " (downgrade)" : " (invalidate)") << " address " << txn.address);
+        Simulator::Schedule(m_lookupLatency, &UbLdstApi::SendSnoop, ldstApi, node, txnId, txn.address, txn.size,
+                            downgrade, txn.vl);
+    }
+}
+
+void UbCoherenceDirectory::OnSnoopAck(uint32_t txnId, uint32_t dirtyBytes)
+{
+    Transaction &txn = m_txns[txnId];
+    NS_LOG_DEBUG("[UbCoherenceDirectory] node " << m_nodeId << " txn " << txnId << " snoop ack, dirty bytes "
+                 << dirtyBytes);
+    NS_ASSERT_MSG(txn.pendingAcks > 0, "Unexpected snoop ack, txn " << txnId);
+    txn.dirtyBytes += dirtyBytes;
+    if (--txn.pendingAcks > 0) {
+        return;
+    }
+    m_totalSnoopTime += Simulator::Now() - txn.snoopStart;
+    if (txn.dirtyBytes > 0) {
+        // owner的脏数据先写回, 再执行请求自身的访存
+        m_snoopWritebacks++;
+        AccessMemory(txnId, txn.address, txn.dirtyBytes, true);
+        return;
+    }
+    IssueAccess(txnId);
+}
+
+void UbCoherenceDirectory::HBMAccessDone(uint64_t requestId)
+{
+    if (requestId == WRITEBACK_REQUEST) {
+        return;
+    }
+    IssueAccess(requestId);
+}
+
+void UbCoherenceDirectory::IssueAccess(uint32_t txnId)
+{
+    GetLdstApi(m_nodeId)->IssueMemoryAccess(m_txns[txnId].contextId);
+}
+
+void UbCoherenceDirectory::AccessMemory(uint64_t requestId, uint64_t address, uint32_t size, bool isWrite)
+{
+    auto node = NodeList::GetNode(m_nodeId);
+    auto cache = node->GetObject<HBMCache>();
+    if (cache != nullptr) {
+        cache->SendRequest(requestId, address, size, isWrite, this);
+        return;
+    }
+    node->GetObject<HBMController>()->SendRequest(requestId, address, size, isWrite, this);
+}
+
+UbCoherenceState UbCoherenceDirectory::Complete(uint32_t txnId)
+{
+    Transaction &txn = m_txns[txnId];
+    UbCoherenceState grant;
+    if (txn.isWrite) {
+        grant = m_protocol == MESI ? UbCoherenceState::E : UbCoherenceState::M;
+    } else {
+        bool shared = false;
+        for (uint64_t line = txn.firstLine; !shared && line <= txn.lastLine; line++) {
+            for (auto node : GetSharers(m_entries[line])) {
+                shared |= node != txn.src;
+            }
+        }
+        grant = (m_protocol == MESI && !shared) ? UbCoherenceState::E : UbCoherenceState::S;
+    }
+    for (uint64_t line = txn.firstLine; line <= txn.lastLine; line++) {
+        Entry &entry = m_entries[line];
+        entry.busy = false;
+        if (grant == UbCoherenceState::S) {
+            // 被降级的owner保留为共享者
+            entry.state = UbCoherenceState::S;
+        } else {
+            entry.sharers.clear();
+            entry.state = grant;
+        }
+        SetSharer(entry, txn.src);
+    }
+    m_txns.Free(txnId);
+    TryStart();
+    return grant;
+}
+
+void UbCoherenceDirectory::OnWriteback(uint32_t src, uint64_t address, uint32_t size)
+{
+    m_evictionWritebacks++;
+    uint64_t lastLine = (address + size - 1) / m_lineSize;
+    for (uint64_t line = address / m_lineSize; line <= lastLine; line++) {
+        auto it = m_entries.find(line);
+        if (it == m_entries.end() || !TestSharer(it->second, src)) {
+            continue;
+        }
+        Entry &entry = it->second;
+        ClearSharer(entry, src);
+        if (GetSharers(entry).empty()) {
+            entry.state = UbCoherenceState::I;
+            if (!entry.busy) {
+                m_entries.erase(it);
+            }
+        }
+    }
+    AccessMemory(WRITEBACK_REQUEST, address, size, true);
+}
+
+Time UbCoherenceDirectory::GetAverageSnoopTime() const
+{
+    return m_snoopedRequests == 0 ? Time(0) : m_totalSnoopTime / static_cast<int64_t>(m_snoopedRequests);
+}
+
+TypeId UbCoherenceAgent::GetTypeId(void)
+{
+    static TypeId tid = TypeId("ns3::UbCoherenceAgent")
+        .SetParent<Object>()
+        .SetGroupName("UnifiedBus")
+        .AddConstructor<UbCoherenceAgent>()
+        .AddAttribute("Capacity",
+                      "Maximum number of lines held by the node.",
+                      UintegerValue(16384),
+                      MakeUintegerAccessor(&UbCoherenceAgent::m_capacity),
+                      MakeUintegerChecker<uint32_t>(1))
+        .AddAttribute("HitLatency",
+                      "Time to serve a LD/ST slice from a line held by the node.",
+                      TimeValue(NanoSeconds(2)),
+                      MakeTimeAccessor(&UbCoherenceAgent::m_hitLatency),
+                      MakeTimeChecker());
+    return tid;
+}
+
+UbCoherenceAgent::UbCoherenceAgent()
+{
+}
+
+UbCoherenceAgent::~UbCoherenceAgent()
+{
+}
+
+void UbCoherenceAgent::Init(uint32_t nodeId, uint32_t lineSize)
+{
+    m_nodeId = nodeId;
+    m_lineSize = lineSize;
+}
+
+/**
+ * @brief 切片覆盖的块与home侧事务一致, 为从下一个地址起的64B * 2^length
+ */
+bool UbCoherenceAgent::HandleAccess(Ptr<UbLdstTaskSegment> taskSegment)
+{
+    uint32_t home = taskSegment->GetDest();
+    uint64_t address = taskSegment->GetNextAddress();
+    uint64_t firstLine = address / m_lineSize;
+    uint64_t lastLine = (address + taskSegment->GetDataSize() - 1) / m_lineSize;
+    bool isWrite = taskSegment->GetType() == UbMemOperationType::STORE;
+    bool hit = true;
+    for (uint64_t line = firstLine; hit && line <= lastLine; line++) {
+        auto it = m_lines.find({home, line});
+        hit = it != m_lines.end() && (!isWrite || it->second.state != UbCoherenceState::S);
+    }
+    if (!hit) {
+        m_misses++;
+        for (uint64_t line = firstLine; line <= lastLine; line++) {
+            m_pending[{home, line}].count++;
+        }
+        return false;
+    }
+    m_hits++;
+    for (uint64_t line = firstLine; line <= lastLine; line++) {
+        Line &entry = m_lines[{home, line}];
+        m_lru.splice(m_lru.begin(), m_lru, entry.lru);
+        if (isWrite) {
+            entry.state = UbCoherenceState::M;
+        }
+    }
+    taskSegment->UpdateSentBytes(taskSegment->PeekNextDataSize());
+    return true;
+}
+
+void UbCoherenceAgent::OnGrant(uint32_t home, uint64_t address, uint32_t size, UbCoherenceState state, uint8_t vl)
+{
+    uint64_t lastLine = (address + size - 1) / m_lineSize;
+    for (uint64_t line = address / m_lineSize; line <= lastLine; line++) {
+        LineKey key = {home, line};
+        auto it = m_pending.find(key);
+        if (it != m_pending.end()) {
+            bool snooped = it->second.snooped;
+            if (--it->second.count == 0) {
+                m_pending.erase(it);
+            }
+            // 授予在途时home已开始后续事务, 该授予已失效
+            if (snooped) {
+                continue;
+            }
+        }
+        Install(key, state, vl);
+    }
+}
+
+void UbCoherenceAgent::Install(const LineKey &key, UbCoherenceState state, uint8_t vl)
+{
+    auto it = m_lines.find(key);
+    if (it != m_lines.end()) {
+        it->second.state = state;
+        m_lru.splice(m_lru.begin(), m_lru, it->second.lru);
+        return;
+    }
+    m_lru.push_front(key);
+    m_lines[key] = {state, m_lru.begin()};
+    if (m_lines.size() <= m_capacity) {
+        return;
+    }
+    LineKey victim = m_lru.back();
+    m_lru.pop_back();
+    if (m_lines[victim].state == UbCoherenceState::M) {
+        m_writebacks++;
+        GetLdstApi(m_nodeId)->SendWriteback(victim.first, victim.second * m_lineSize, m_lineSize, vl);
+    }
+    m_lines.erase(victim);
+}
+
+uint32_t UbCoherenceAgent::OnSnoop(uint32_t home, uint64_t address, uint32_t size, bool downgrade)
+{
+    m_snoops++;
+    uint32_t dirtyBytes = 0;
+    uint64_t lastLine = (address + size - 1) / m_lineSize;
+    for (uint64_t line = address / m_lineSize; line <= lastLine; line++) {
+        LineKey key = {home, line};
+        auto pending = m_pending.find(key);
+        if (pending != m_pending.end()) {
+            pending->second.snooped = true;
+        }
+        auto it = m_lines.find(key);
+        if (it == m_lines.end()) {
+            continue;
+        }
+        if (it->second.state == UbCoherenceState::M) {
+            dirtyBytes += m_lineSize;
+        }
+        if (downgrade) {
+            it->second.state = UbCoherenceState::S;
+        } else {
+            m_lru.erase(it->second.lru);
+            m_lines.erase(it);
+        }
+    }
+    return dirtyBytes;
+}
+
+} // namespace ns3
@@ -0,0 +1,186 @@
+// SPDX-License-Identifier: GPL-2.0-only
+#ifndef UB_COHERENCE_H
+#define UB_COHERENCE_H
+
+#include <deque>
+#include <list>
+#include <map>
+#include <unordered_map>
+#include <vector>
+#include "ns3/object.h"
+#include "ns3/nstime.h"
+#include "ns3/ub-datatype.h"
+#include "ns3/hbm-request.h"
+
+namespace ns3 {
+
+/**
+ * @brief 行的一致性状态, 请求者一侧的S/E/M经cATAH的Status字段授予, 0表示非一致性响应
+ */
+enum class UbCoherenceState : uint8_t {
+    I = 0,
+    S = 1,
+    E = 2,
+    M = 3
+};
+
+/**
+ * @brief 内存节点(home)上的目录
+ *
+ * 每行记录状态与共享者位向量, E/M时唯一的共享者即owner。收到LOAD/STORE请求后先经LookupLatency查目录:
+ * LOAD遇到其他节点持有E/M时向owner发降级侦听, STORE向除请求者外的全部共享者发无效化侦听,
+ * 侦听应答携带owner的脏数据, 先写回HBM再执行请求自身的访存, 响应中授予请求者行状态:
+ * LOAD在MESI下无其他共享者时授予E, 否则授予S; STORE在MESI下授予E(数据已写入home), MSI下授予M。
+ * 一个请求处理期间其覆盖的行处于忙态, 访问忙行的请求按到达顺序等待。
+ * 只建模时序, 不建模数据内容; 侦听与写回报文和数据报文竞争相同的VOQ和HBM bank。
+ */
+class UbCoherenceDirectory : public Object, public HBMClient {
+public:
+    enum Protocol {
+        MSI,
+        MESI
+    };
+
+    static TypeId GetTypeId(void);
+    UbCoherenceDirectory();
+    ~UbCoherenceDirectory() override;
+
+    void Init(uint32_t nodeId);
+    uint32_t GetLineSize() const {return m_lineSize;}
+
+    /**
+     * @brief 收到LOAD/STORE请求, 侦听完成后经UbLdstApi::IssueMemoryAccess访问内存
+     * @param contextId 请求在UbLdstApi中的接收上下文
+     * @return 事务号, 内存访问完成后交给Complete
+     */
+    uint32_t HandleRequest(uint32_t contextId, uint32_t src, uint64_t address, uint32_t size, bool isWrite,
+                           uint8_t vl);
+    // 请求的内存访问完成, 更新目录并返回授予请求者的行状态
+    UbCoherenceState Complete(uint32_t txnId);
+    // 侦听应答, dirtyBytes为owner写回的脏数据量
+    void OnSnoopAck(uint32_t txnId, uint32_t dirtyBytes);
+    // 请求者淘汰M态行的写回
+    void OnWriteback(uint32_t src, uint64_t address, uint32_t size);
+    void HBMAccessDone(uint64_t requestId) override;
+
+    uint64_t GetRequests() const {return m_requests;}
+    uint64_t GetConflicts() const {return m_conflicts;}
+    uint64_t GetInvalidations() const {return m_invalidations;}
+    uint64_t GetDowngrades() const {return m_downgrades;}
+    uint64_t GetSnoopWritebacks() const {return m_snoopWritebacks;}
+    uint64_t GetEvictionWritebacks() const {return m_evictionWritebacks;}
+    Time GetAverageSnoopTime() const;
+
+private:
+    struct Entry {
+        UbCoherenceState state = UbCoherenceState::I;
+        std::vector<uint64_t> sharers;      // 共享者位向量, 按nodeId索引
+        bool busy = false;
+    };
+    struct Transaction {
+        uint32_t contextId = 0;
+        uint32_t src = 0;
+        uint64_t firstLine = 0;
+        uint64_t lastLine = 0;
+        uint64_t address = 0;
+        uint32_t size = 0;
+        bool isWrite = false;
+        uint8_t vl = 0;
+        uint32_t pendingAcks = 0;
+        uint32_t dirtyBytes = 0;
+        bool waited = false;
+        Time snoopStart;
+    };
+    static constexpr uint64_t WRITEBACK_REQUEST = UINT64_MAX;
+
+    void DoDispose() override;
+    void TryStart();
+    bool IsBusy(const Transaction &txn) const;
+    void Start(uint32_t txnId);
+    void IssueAccess(uint32_t txnId);
+    void AccessMemory(uint64_t requestId, uint64_t address, uint32_t size, bool isWrite);
+
+    static bool TestSharer(const Entry &entry, uint32_t node);
+    static void SetSharer(Entry &entry, uint32_t node);
+    static void ClearSharer(Entry &entry, uint32_t node);
+    static std::vector<uint32_t> GetSharers(const Entry &entry);
+
+    Protocol m_protocol;
+    uint32_t m_lineSize;
+    Time m_lookupLatency;
+
+    uint32_t m_nodeId = 0;
+    std::unordered_map<uint64_t, Entry> m_entries;     // 行号 -> 目录项, 回到I态且无共享者时删除
+    HBMPool<Transaction> m_txns;
+    std::deque<uint32_t> m_waiting;                     // 按到达顺序等待开始的事务
+
+    uint64_t m_requests = 0;
+    uint64_t m_conflicts = 0;
+    uint64_t m_invalidations = 0;
+    uint64_t m_downgrades = 0;
+    uint64_t m_snoopWritebacks = 0;
+    uint64_t m_evictionWritebacks = 0;
+    uint64_t m_snoopedRequests = 0;
+    Time m_totalSnoopTime;
+};
+
+/**
+ * @brief 请求者一侧的行状态
+ *
+ * 按(home节点, 行地址)记录本节点持有的S/E/M行, 至多Capacity行, 超出时淘汰最久未用的行:
+ * S/E行静默淘汰, M行以WriteBackFull写回home。LD/ST线程的每个切片先查行状态,
+ * LOAD覆盖的行均有效、STORE覆盖的行均为E/M时在HitLatency后本地完成(STORE将E置为M), 否则照常发往home,
+ * 并在响应授予状态前将这些行记为在途; 在途期间收到的侦听使该次授予作废。
+ */
+class UbCoherenceAgent : public Object {
+public:
+    static TypeId GetTypeId(void);
+    UbCoherenceAgent();
+    ~UbCoherenceAgent() override;
+
+    void Init(uint32_t nodeId, uint32_t lineSize);
+    Time GetHitLatency() const {return m_hitLatency;}
+
+    // LD/ST线程下一个切片, 返回true表示由本地行状态满足
+    bool HandleAccess(Ptr<UbLdstTaskSegment> taskSegment);
+    // home授予[address, address + size)上的行状态
+    void OnGrant(uint32_t home, uint64_t address, uint32_t size, UbCoherenceState state, uint8_t vl);
+    // home的侦听, 返回需写回的脏数据量
+    uint32_t OnSnoop(uint32_t home, uint64_t address, uint32_t size, bool downgrade);
+
+    uint64_t GetHits() const {return m_hits;}
+    uint64_t GetMisses() const {return m_misses;}
+    uint64_t GetSnoops() const {return m_snoops;}
+    uint64_t GetWritebacks() const {return m_writebacks;}
+
+private:
+    using LineKey = std::pair<uint32_t, uint64_t>;     // (home, 行号)
+    struct Line {
+        UbCoherenceState state = UbCoherenceState::I;
+        std::list<LineKey>::iterator lru;
+    };
+    struct Pending {
+        uint32_t count = 0;
+        bool snooped = false;
+    };
+
+    void Install(const LineKey &key, UbCoherenceState state, uint8_t vl);
+
+    uint32_t m_capacity;
+    Time m_hitLatency;
+
+    uint32_t m_nodeId = 0;
+    uint32_t m_lineSize = 64;
+    std::map<LineKey, Line> m_lines;
+    std::list<LineKey> m_lru;                           // 队首为最近使用
+    std::map<LineKey, Pending> m_pending;
+
+    uint64_t m_hits = 0;
+    uint64_t m_misses = 0;
+    uint64_t m_snoops = 0;
+    uint64_t m_writebacks = 0;
+};
+
+} // namespace ns3
+
+#endif /* UB_COHERENCE_H */
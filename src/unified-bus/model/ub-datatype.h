@@ -91,7 +91,10 @@ enum class TaOpcode : uint8_t {
     TA_OPCODE_DISCONNECT_SCID = 0x16,  // Disconnect SCID
     TA_OPCODE_WRITEBACK_FULL = 0x17,   // WriteBackFull
     TA_OPCODE_WRITEBACK_PTL = 0x18,    // WriteBackPtl
-    TA_OPCODE_MAX = 0x19               // 无效的TA OPCODE
+    TA_OPCODE_SNOOP_INVALIDATE = 0x19, // 一致性目录侦听: 无效化 (仿真扩展)
+    TA_OPCODE_SNOOP_DOWNGRADE = 0x1A,  // 一致性目录侦听: 降级为S (仿真扩展)
+    TA_OPCODE_SNOOP_ACK = 0x1B,        // 侦听应答, 携带脏数据 (仿真扩展)
+    TA_OPCODE_MAX = 0x1C               // 无效的TA OPCODE
 };
 
 enum class UbDatalinkHeaderConfig : uint8_t {
@@ -267,6 +270,33 @@ public:
         m_bytesLeft = size;
     }
 
+    void SetAddress(uint64_t address)
+    {
+        m_address = address;
+    }
+
+    uint64_t GetAddress() const
+    {
+        return m_address;
+    }
+
+    // 下一个packet访问的内存地址
+    uint64_t GetNextAddress() const
+    {
+        return m_address + (m_size - m_bytesLeft);
+    }
+
+    // 由预取引擎发出的LOAD, 不属于任何task
+    void SetPrefetch(bool prefetch)
+    {
+        m_prefetch = prefetch;
+    }
+
+    bool IsPrefetch() const
+    {
+        return m_prefetch;
+    }
+
     void SetPacketInfo(uint32_t packetSize, uint32_t length)
     {
         m_length = length;
@@ -367,6 +397,7 @@ private:
     uint32_t m_bytesLeft = 0;       // 剩余的字节数
     uint32_t m_msn = 0;
     uint32_t m_packetSize = 0; // 请求包的payload size
+    bool m_prefetch = false;
 };
 
 // ============================================================================
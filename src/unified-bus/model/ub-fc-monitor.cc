@@ -0,0 +1,237 @@
+// SPDX-License-Identifier: GPL-2.0-only
+#include <sstream>
+#include <algorithm>
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+#include "ns3/boolean.h"
+#include "ns3/node-list.h"
+#include "ns3/ub-port.h"
+#include "ns3/ub-link.h"
+#include "ns3/ub-switch.h"
+#include "ns3/ub-tag.h"
+#include "ns3/ub-flow-control.h"
+#include "ns3/ub-fc-monitor.h"
+
+namespace ns3 {
+NS_LOG_COMPONENT_DEFINE("UbFcMonitor");
+NS_OBJECT_ENSURE_REGISTERED(UbFcMonitor);
+
+TypeId UbFcMonitor::GetTypeId(void)
+{
+    static TypeId tid = TypeId("ns3::UbFcMonitor")
+        .SetParent<Object>()
+        .SetGroupName("UnifiedBus")
+        .AddConstructor<UbFcMonitor>()
+        .AddAttribute("CheckInterval",
+                      "Interval between two wait-for graph checks, also the HOL blocking sampling period.",
+                      TimeValue(MicroSeconds(10)),
+                      MakeTimeAccessor(&UbFcMonitor::m_checkInterval),
+                      MakeTimeChecker())
+        .AddAttribute("DeadlockThreshold",
+                      "A (port, VL) buffer must stay flow-control blocked this long to join the wait-for graph.",
+                      TimeValue(MicroSeconds(100)),
+                      MakeTimeAccessor(&UbFcMonitor::m_deadlockThreshold),
+                      MakeTimeChecker())
+        .AddAttribute("StopOnDeadlock",
+                      "Stop the simulation once a deadlock cycle is detected.",
+                      BooleanValue(false),
+                      MakeBooleanAccessor(&UbFcMonitor::m_stopOnDeadlock),
+                      MakeBooleanChecker())
+        .AddTraceSource("DeadlockDetected",
+                        "A cycle of flow-control blocked buffers is detected.",
+                        MakeTraceSourceAccessor(&UbFcMonitor::m_traceDeadlock),
+                        "ns3::UbFcMonitor::DeadlockTracedCallback")
+        .AddTraceSource("HolBlocking",
+                        "Accumulated time a (port, VL) had queued packets blocked by flow control.",
+                        MakeTraceSourceAccessor(&UbFcMonitor::m_traceHolBlocking),
+                        "ns3::UbFcMonitor::HolBlockingTracedCallback");
+    return tid;
+}
+
+UbFcMonitor::UbFcMonitor()
+{
+}
+
+UbFcMonitor::~UbFcMonitor()
+{
+}
+
+void UbFcMonitor::DoDispose()
+{
+    m_checkEvent.Cancel();
+    m_blockedSince.clear();
+    m_persistent.clear();
+    m_waitFor.clear();
+    m_reportedCycles.clear();
+    m_holBlockedTime.clear();
+    Object::DoDispose();
+}
+
+void UbFcMonitor::Start()
+{
+    m_checkEvent = Simulator::Schedule(m_checkInterval, &UbFcMonitor::Check, this);
+}
+
+/**
+ * @brief 出端口VL上存在被流控限制的非空VOQ即为阻塞, 控制报文VOQ不受流控
+ */
+bool UbFcMonitor::IsBlocked(Ptr<UbSwitch> sw, Ptr<UbPort> port, uint32_t vl)
+{
+    uint32_t outPort = port->GetIfIndex();
+    auto flowControl = port->GetFlowControl();
+    for (uint32_t inPort = 0; inPort < sw->GetPortsNum(); inPort++) {
+        if (inPort == outPort) {
+            continue;
+        }
+        auto voq = sw->GetVoq(outPort, vl, inPort);
+        if (!voq->IsEmpty() && flowControl->IsFcLimited(voq)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief 阻塞缓冲等待对端入端口缓冲释放, 对端该入端口的报文排队在其他出端口的VOQ上
+ */
+const std::vector<uint64_t> &UbFcMonitor::GetWaitFor(uint64_t vertex)
+{
+    auto it = m_waitFor.find(vertex);
+    if (it != m_waitFor.end()) {
+        return it->second;
+    }
+    std::vector<uint64_t> &succ = m_waitFor[vertex];
+    uint32_t vl = VertexVl(vertex);
+    auto port = DynamicCast<UbPort>(NodeList::GetNode(VertexNode(vertex))->GetDevice(VertexPort(vertex)));
+    auto link = DynamicCast<UbLink>(port->GetChannel());
+    if (link == nullptr) {
+        return succ;
+    }
+    Ptr<UbPort> peer = link->GetDestination(port);
+    uint32_t peerNode = peer->GetNode()->GetId();
+    uint32_t peerInPort = peer->GetIfIndex();
+    auto peerSw = peer->GetNode()->GetObject<UbSwitch>();
+    for (uint32_t outPort = 0; outPort < peerSw->GetPortsNum(); outPort++) {
+        if (outPort == peerInPort) {
+            continue;
+        }
+        uint64_t next = MakeVertex(peerNode, outPort, vl);
+        if (m_persistent.count(next) && !peerSw->GetVoq(outPort, vl, peerInPort)->IsEmpty()) {
+            succ.push_back(next);
+        }
+    }
+    return succ;
+}
+
+/**
+ * @brief 在持续阻塞顶点构成的等待图上查找经过start的环
+ */
+bool UbFcMonitor::FindCycle(uint64_t start, std::vector<uint64_t> &cycle)
+{
+    std::set<uint64_t> visited;
+    std::vector<std::pair<uint64_t, size_t>> stack;
+    stack.emplace_back(start, 0);
+    visited.insert(start);
+    while (!stack.empty()) {
+        auto &[vertex, idx] = stack.back();
+        const auto &succ = GetWaitFor(vertex);
+        if (idx >= succ.size()) {
+            stack.pop_back();
+            continue;
+        }
+        uint64_t next = succ[idx++];
+        if (next == start) {
+            for (auto &entry : stack) {
+                cycle.push_back(entry.first);
+            }
+            return true;
+        }
+        if (visited.insert(next).second) {
+            stack.emplace_back(next, 0);
+        }
+    }
+    return false;
+}
+
+std::string UbFcMonitor::DescribeCycle(const std::vector<uint64_t> &cycle)
+{
+    std::ostringstream oss;
+    oss << "Deadlock cycle:";
+    for (size_t i = 0; i < cycle.size(); i++) {
+        uint32_t nodeId = VertexNode(cycle[i]);
+        uint32_t portId = VertexPort(cycle[i]);
+        uint32_t vl = VertexVl(cycle[i]);
+        auto sw = NodeList::GetNode(nodeId)->GetObject<UbSwitch>();
+        oss << (i == 0 ? " " : " -> ") << "(node " << nodeId << " port " << portId << " vl " << vl << " flows:";
+        std::set<uint32_t> flows;
+        for (uint32_t inPort = 0; inPort < sw->GetPortsNum(); inPort++) {
+            auto voq = sw->GetVoq(portId, vl, inPort);
+            UbFlowTag flowTag;
+            if (inPort != portId && !voq->IsEmpty() && voq->Front()->PeekPacketTag(flowTag)) {
+                flows.insert(flowTag.GetFlowId());
+            }
+        }
+        for (auto flowId : flows) {
+            oss << " " << flowId;
+        }
+        oss << ")";
+    }
+    return oss.str();
+}
+
+void UbFcMonitor::Check()
+{
+    Time now = Simulator::Now();
+    std::vector<uint64_t> newPersistent;
+    m_waitFor.clear();
+    for (uint32_t nodeId = 0; nodeId < NodeList::GetNNodes(); nodeId++) {
+        auto node = NodeList::GetNode(nodeId);
+        auto sw = node->GetObject<UbSwitch>();
+        for (uint32_t portId = 0; portId < sw->GetPortsNum(); portId++) {
+            auto port = DynamicCast<UbPort>(node->GetDevice(portId));
+            for (uint32_t vl = 0; vl < sw->GetVLNum(); vl++) {
+                uint64_t vertex = MakeVertex(nodeId, portId, vl);
+                if (!IsBlocked(sw, port, vl)) {
+                    m_blockedSince.erase(vertex);
+                    m_persistent.erase(vertex);
+                    continue;
+                }
+                m_holBlockedTime[vertex] += m_checkInterval;
+                auto it = m_blockedSince.emplace(vertex, now).first;
+                if (now - it->second >= m_deadlockThreshold && m_persistent.insert(vertex).second) {
+                    newPersistent.push_back(vertex);
+                }
+            }
+        }
+    }
+    // 新出现的环必经过新进入持续阻塞态的顶点
+    for (auto vertex : newPersistent) {
+        std::vector<uint64_t> cycle;
+        if (!FindCycle(vertex, cycle)) {
+            continue;
+        }
+        std::vector<uint64_t> key = cycle;
+        std::rotate(key.begin(), std::min_element(key.begin(), key.end()), key.end());
+        if (!m_reportedCycles.insert(key).second) {
+            continue;
+        }
+        m_deadlockCount++;
+        std::string info = DescribeCycle(key);
+        NS_LOG_WARN("[UbFcMonitor] " << info);
+        m_traceDeadlock(info);
+        if (m_stopOnDeadlock) {
+            Simulator::Stop();
+            return;
+        }
+    }
+    m_checkEvent = Simulator::Schedule(m_checkInterval, &UbFcMonitor::Check, this);
+}
+
+void UbFcMonitor::ReportHolBlocking()
+{
+    for (auto &[vertex, blockedTime] : m_holBlockedTime) {
+        m_traceHolBlocking(VertexNode(vertex), VertexPort(vertex), VertexVl(vertex), blockedTime);
+    }
+}
+
+} // namespace ns3
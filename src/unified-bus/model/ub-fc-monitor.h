@@ -0,0 +1,82 @@
+// SPDX-License-Identifier: GPL-2.0-only
+#ifndef UB_FC_MONITOR_H
+#define UB_FC_MONITOR_H
+
+#include <map>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "ns3/object.h"
+#include "ns3/nstime.h"
+#include "ns3/event-id.h"
+#include "ns3/traced-callback.h"
+
+namespace ns3 {
+class UbSwitch;
+class UbPort;
+
+/**
+ * @brief 无损网络(PFC/CBFC)死锁与HOL阻塞检测器
+ *
+ * 顶点为交换机出端口的(node, port, VL)缓冲, 当该出端口VL上有非空VOQ且被PFC暂停或CBFC信用不足时为阻塞态。
+ * 阻塞顶点(n, p, v)等待对端(n', q)入端口VL v的缓冲释放, 该缓冲中的报文在n'上排队于VOQ[p'][v][q],
+ * 因此若(n', p', v)同样阻塞, 则存在等待边(n, p, v) -> (n', p', v)。
+ * 持续阻塞超过DeadlockThreshold的顶点构成的等待图中出现环即判定为死锁。
+ * 每个检测周期只从新进入持续阻塞态的顶点出发搜索环, 已上报的环不重复上报。
+ */
+class UbFcMonitor : public Object {
+public:
+    static TypeId GetTypeId(void);
+    UbFcMonitor();
+    ~UbFcMonitor() override;
+
+    void Start();
+
+    // 输出各(node, port, VL)被流控阻塞的累计时长
+    void ReportHolBlocking();
+
+    uint32_t GetDeadlockCount() {return m_deadlockCount;}
+
+    /**
+     * @brief 检测到死锁
+     * @param cycle 环的描述, 含各缓冲及其队首报文所属流
+     */
+    typedef void (*DeadlockTracedCallback)(std::string cycle);
+    typedef void (*HolBlockingTracedCallback)(uint32_t nodeId, uint32_t portId, uint32_t vl, Time blockedTime);
+
+private:
+    void DoDispose() override;
+    void Check();
+    bool IsBlocked(Ptr<UbSwitch> sw, Ptr<UbPort> port, uint32_t vl);
+    const std::vector<uint64_t> &GetWaitFor(uint64_t vertex);
+    bool FindCycle(uint64_t start, std::vector<uint64_t> &cycle);
+    std::string DescribeCycle(const std::vector<uint64_t> &cycle);
+
+    static uint64_t MakeVertex(uint32_t nodeId, uint32_t portId, uint32_t vl)
+    {
+        return (static_cast<uint64_t>(nodeId) << 32) | (static_cast<uint64_t>(portId) << 8) | vl;
+    }
+    static uint32_t VertexNode(uint64_t vertex) {return vertex >> 32;}
+    static uint32_t VertexPort(uint64_t vertex) {return (vertex >> 8) & 0xFFFFFF;}
+    static uint32_t VertexVl(uint64_t vertex) {return vertex & 0xFF;}
+
+    Time m_checkInterval;
+    Time m_deadlockThreshold;
+    bool m_stopOnDeadlock;
+    EventId m_checkEvent;
+
+    std::unordered_map<uint64_t, Time> m_blockedSince;          // 顶点进入阻塞态的时刻
+    std::set<uint64_t> m_persistent;                            // 持续阻塞的顶点
+    std::unordered_map<uint64_t, std::vector<uint64_t>> m_waitFor;  // 本周期已计算的等待边
+    std::set<std::vector<uint64_t>> m_reportedCycles;
+    std::map<uint64_t, Time> m_holBlockedTime;                  // HOL阻塞累计时长
+    uint32_t m_deadlockCount = 0;
+
+    TracedCallback<std::string> m_traceDeadlock;
+    TracedCallback<uint32_t, uint32_t, uint32_t, Time> m_traceHolBlocking;
+};
+
+} // namespace ns3
+
+#endif /* UB_FC_MONITOR_H */
@@ -1,13 +1,12 @@
 // SPDX-License-Identifier: GPL-2.0-only
 #include "ns3/ub-ldst-instance.h"
 #include "ns3/ub-ldst-thread.h"
-#include "ns3/hbm-bank.h"
-#include "ns3/hbm-helper.h"
+#include "ns3/ub-address-map.h"
+#include "ns3/hbm-cache.h"
+#include "ns3/hbm-controller.h"
 #include "ub-ldst-instance.h"
 #include "ns3/random-variable-stream.h"
 
-//#define SIM_HBM_INTERNAL
-
 namespace ns3 {
 NS_LOG_COMPONENT_DEFINE("UbLdstInstance");
 
@@ -63,12 +62,9 @@ void UbLdstInstance::Init(uint32_t nodeId)
 {
     for (uint32_t threadId = 0; threadId < m_threadNum; threadId++) {
         auto ldstThread = CreateObject<UbLdstThread>();
-        
-        #ifdef SIM_HBM_INTERNAL
-            ldstThread->DoInitialize();
-        #endif
         ldstThread->SetNode(nodeId);
         ldstThread->SetThreadId(threadId);
+        ldstThread->InitPrefetcher();
         m_threads.push_back(ldstThread);
     }
 }
@@ -76,6 +72,19 @@ void UbLdstInstance::Init(uint32_t nodeId)
 void UbLdstInstance::DoDispose()
 {
     m_threads.clear();
+    m_taskFinishCallbacks.clear();
+    m_addressMap = nullptr;
+}
+
+void UbLdstInstance::SetAddressMap(Ptr<UbAddressMap> addressMap)
+{
+    m_addressMap = addressMap;
+}
+
+uint32_t UbLdstInstance::GetTargetOutstanding(uint32_t dest) const
+{
+    auto it = m_targetOutstanding.find(dest);
+    return it == m_targetOutstanding.end() ? 0 : it->second;
 }
 
 void UbLdstInstance::SetClientCallback(Callback<void, uint32_t> cb)
@@ -83,57 +92,170 @@ void UbLdstInstance::SetClientCallback(Callback<void, uint32_t> cb)
     FinishCallback = cb;
 }
 
+void UbLdstInstance::HandleLdstTask(uint32_t src, uint32_t dest, uint32_t length, uint32_t taskId,
+                                    UbMemOperationType type, const std::vector<uint32_t> &threadIds, uint64_t address,
+                                    Callback<void, uint32_t> finishCb)
+{
+    NS_ASSERT_MSG(m_taskFinishCallbacks.count(taskId) == 0, "LDST taskId " << taskId << " is still in flight");
+    m_taskFinishCallbacks[taskId] = finishCb;
+    HandleLdstTask(src, dest, length, taskId, type, threadIds, address);
+}
+
 void UbLdstInstance::HandleLdstTask(uint32_t src, uint32_t dest, uint32_t length, uint32_t taskId,
                                     UbMemOperationType type, const std::vector<uint32_t> &threadIds, uint64_t address)
 {
+    NS_ASSERT_MSG(m_taskTargetOutstanding.count(taskId) == 0, "LDST taskId " << taskId << " is still in flight");
     uint32_t threadsNum = threadIds.size();
-    // 将数据均分下发给thread
-    uint32_t partSize = length / threadsNum;
+    std::vector<UbAddressMap::Range> ranges;
+    if (m_addressMap != nullptr) {
+        ranges = m_addressMap->Split(address, length);
+    } else {
+        ranges.push_back({dest, address, length});
+    }
 
     FirstPacketSendsNotify(this->GetObject<Node>()->GetId(), taskId);
     MemTaskStartsNotify(this->GetObject<Node>()->GetId(), taskId);
-    for (uint32_t i = 0; i < threadsNum; i++) {
-        uint32_t segmentSize = partSize;
-        if (i == threadsNum - 1) {
-            segmentSize += length - partSize * threadsNum;
+    if (ranges.empty()) {
+        // 长度为0的task不访问任何内存节点
+        Simulator::ScheduleNow(&UbLdstInstance::FinishTask, this, taskId);
+        return;
+    }
+    // 目标数少于线程数时, 各目标区间再按线程均分, taskSegment轮询分配给thread
+    uint32_t partsPerTarget = std::max<uint32_t>(1, threadsNum / ranges.size());
+    uint32_t segmentIdx = 0;
+    for (auto &range : ranges) {
+        if (range.node == src) {
+            AccessLocalMemory(CreateTaskSegment(src, src, range.size, range.address, taskId, type));
+            continue;
+        }
+        uint32_t partsNum = std::max<uint64_t>(1, std::min<uint64_t>(partsPerTarget, range.size));
+        uint32_t partSize = range.size / partsNum;
+        for (uint32_t i = 0; i < partsNum; i++) {
+            uint32_t segmentSize = partSize;
+            if (i == partsNum - 1) {
+                segmentSize += range.size - static_cast<uint64_t>(partSize) * partsNum;
+            }
+            uint32_t threadId = threadIds[segmentIdx++ % threadsNum];
+            auto taskSegment = CreateTaskSegment(src, range.node, segmentSize,
+                                                 range.address + static_cast<uint64_t>(partSize) * i, taskId, type);
+            taskSegment->SetThreadId(threadId);
+            Simulator::ScheduleNow(&UbLdstThread::PushTaskSegment, GetLdstThread(threadId), taskSegment);
         }
-        uint32_t threadId = threadIds[i];
-        auto ldstThread = GetLdstThread(threadId);
-        auto taskSegment = CreateObject<UbLdstTaskSegment>();
-        taskSegment->SetSrc(src);
-        taskSegment->SetDest(dest);
-        taskSegment->SetSize(segmentSize);
-        taskSegment->SetTaskId(taskId);
-        taskSegment->SetTaskSegmentId(m_currentTaskId);
-        taskSegment->SetType(type);
-        taskSegment->SetThreadId(threadId);
-        m_taskToSegmentMap[taskId].push_back(taskSegment);
-        m_taskSegmentsMap[m_currentTaskId] = taskSegment;
-        m_taskSegmentCompletedNum[taskId] = 0;
-        m_currentTaskId++;
-        Simulator::ScheduleNow(&UbLdstThread::PushTaskSegment, ldstThread, taskSegment);
     }
 }
 
+Ptr<UbLdstTaskSegment> UbLdstInstance::CreateTaskSegment(uint32_t src, uint32_t dest, uint32_t size,
+                                                         uint64_t address, uint32_t taskId, UbMemOperationType type)
+{
+    auto taskSegment = CreateObject<UbLdstTaskSegment>();
+    taskSegment->SetSrc(src);
+    taskSegment->SetDest(dest);
+    taskSegment->SetSize(size);
+    taskSegment->SetAddress(address);
+    taskSegment->SetTaskId(taskId);
+    uint32_t taskSegmentId = AllocTaskSegmentId();
+    taskSegment->SetTaskSegmentId(taskSegmentId);
+    taskSegment->SetType(type);
+    m_taskToSegmentMap[taskId].push_back(taskSegment);
+    m_taskSegmentsMap[taskSegmentId] = taskSegment;
+    m_taskTargetOutstanding[taskId][dest]++;
+    m_targetOutstanding[dest]++;
+    return taskSegment;
+}
+
+/**
+ * @brief 地址池包含本节点时, 落在本节点的区间不经网络, 作为一次访存交给本地cache/HBM
+ */
+void UbLdstInstance::AccessLocalMemory(Ptr<UbLdstTaskSegment> taskSegment)
+{
+    auto node = this->GetObject<Node>();
+    bool isWrite = taskSegment->GetType() == UbMemOperationType::STORE;
+    auto cache = node->GetObject<HBMCache>();
+    if (cache != nullptr) {
+        cache->SendRequest(taskSegment->GetTaskSegmentId(), taskSegment->GetAddress(), taskSegment->GetSize(),
+                           isWrite, this);
+        return;
+    }
+    auto hbmController = node->GetObject<HBMController>();
+    NS_ASSERT_MSG(hbmController != nullptr, "Node " << node->GetId() << " in the memory pool has no HBM");
+    hbmController->SendRequest(taskSegment->GetTaskSegmentId(), taskSegment->GetAddress(), taskSegment->GetSize(),
+                               isWrite, this);
+}
+
+void UbLdstInstance::HBMAccessDone(uint64_t requestId)
+{
+    OnTaskSegmentCompleted(m_taskSegmentsMap[requestId]);
+}
+
+/**
+ * @brief taskSegmentId经cTAH中16位的IniTaSsn往返, 按16位回绕分配并跳过仍在途的id
+ */
+uint32_t UbLdstInstance::AllocTaskSegmentId()
+{
+    NS_ASSERT_MSG(m_taskSegmentsMap.size() <= UINT16_MAX, "Too many outstanding LDST task segments");
+    while (m_taskSegmentsMap.count(m_currentTaskId) > 0) {
+        m_currentTaskId = (m_currentTaskId + 1) & UINT16_MAX;
+    }
+    uint32_t taskSegmentId = m_currentTaskId;
+    m_currentTaskId = (m_currentTaskId + 1) & UINT16_MAX;
+    return taskSegmentId;
+}
+
+void UbLdstInstance::RegisterPrefetchSegment(Ptr<UbLdstTaskSegment> taskSegment)
+{
+    uint32_t taskSegmentId = AllocTaskSegmentId();
+    taskSegment->SetTaskSegmentId(taskSegmentId);
+    m_taskSegmentsMap[taskSegmentId] = taskSegment;
+}
+
 void UbLdstInstance::OnRecvAck(uint32_t taskSegmentId)
 {
     auto taskSegment = m_taskSegmentsMap[taskSegmentId];
     if (taskSegment == nullptr) {
         NS_ASSERT_MSG(0, "taskSegment invalid!");
     }
+    if (taskSegment->IsPrefetch()) {
+        m_taskSegmentsMap.erase(taskSegmentId);
+    }
     uint32_t threadId = taskSegment->GetThreadId();
     auto ldstThread = GetLdstThread(threadId);
     Simulator::ScheduleNow(&UbLdstThread::UpdateTask, ldstThread, taskSegment);
 }
 
-void UbLdstInstance::OnTaskSegmentCompleted(uint32_t taskId)
+void UbLdstInstance::OnTaskSegmentCompleted(Ptr<UbLdstTaskSegment> taskSegment)
 {
-    m_taskSegmentCompletedNum[taskId]++;
-    if (m_taskSegmentCompletedNum[taskId] == m_taskToSegmentMap[taskId].size()) {
-        LastPacketACKsNotify(this->GetObject<Node>()->GetId(), taskId);
-        MemTaskCompletesNotify(this->GetObject<Node>()->GetId(), taskId);
+    uint32_t taskId = taskSegment->GetTaskId();
+    uint32_t dest = taskSegment->GetDest();
+    if (--m_targetOutstanding[dest] == 0) {
+        m_targetOutstanding.erase(dest);
+    }
+    auto &targets = m_taskTargetOutstanding[taskId];
+    if (--targets[dest] == 0) {
+        targets.erase(dest);
+    }
+    if (targets.empty()) {
+        FinishTask(taskId);
+    }
+}
+
+void UbLdstInstance::FinishTask(uint32_t taskId)
+{
+    LastPacketACKsNotify(this->GetObject<Node>()->GetId(), taskId);
+    MemTaskCompletesNotify(this->GetObject<Node>()->GetId(), taskId);
+    // 释放已完成task的记录, 长时间回放时内存不随task数增长
+    for (auto &segment : m_taskToSegmentMap[taskId]) {
+        m_taskSegmentsMap.erase(segment->GetTaskSegmentId());
+    }
+    m_taskToSegmentMap.erase(taskId);
+    m_taskTargetOutstanding.erase(taskId);
+    auto cbIt = m_taskFinishCallbacks.find(taskId);
+    if (cbIt == m_taskFinishCallbacks.end()) {
         FinishCallback(taskId);
+        return;
     }
+    auto finishCb = cbIt->second;
+    m_taskFinishCallbacks.erase(cbIt);
+    finishCb(taskId);
 }
 
 Ptr<UbLdstThread> UbLdstInstance::GetLdstThread(uint32_t threadId)
@@ -2,17 +2,17 @@
 #ifndef UB_LDST_INSTANCE_H
 #define UB_LDST_INSTANCE_H
 
+#include <map>
 #include "ns3/ub-datatype.h"
 #include "ns3/ub-network-address.h"
 #include "ns3/node-list.h"
 #include "ns3/node.h"
-#include "ns3/hbm-helper.h"
-#include "ns3/hbm-controller.h"
+#include "ns3/hbm-request.h"
 
 namespace ns3 {
 class UbLdstThread;
-class HBMController;
-class UbLdstInstance : public Object {
+class UbAddressMap;
+class UbLdstInstance : public Object, public HBMClient {
 public:
     static TypeId GetTypeId(void);
     UbLdstInstance();
@@ -22,14 +22,32 @@ public:
     // 接收任务接口，分配给thread
     void HandleLdstTask(uint32_t src, uint32_t dest, uint32_t size, uint32_t taskId,
                         UbMemOperationType type, const std::vector<uint32_t> &threadIds, uint64_t address);
+    // 同上, task完成时回调finishCb而非SetClientCallback设置的回调, 供与UbApp共用本实例的其他发起者使用
+    void HandleLdstTask(uint32_t src, uint32_t dest, uint32_t size, uint32_t taskId,
+                        UbMemOperationType type, const std::vector<uint32_t> &threadIds, uint64_t address,
+                        Callback<void, uint32_t> finishCb);
 
     void SetClientCallback(Callback<void, uint32_t> cb);
     Ptr<UbLdstThread> GetLdstThread(uint32_t threadId);
     Callback<void, uint32_t> FinishCallback;
     void OnRecvAck(uint32_t taskSegmentId);
-    void OnTaskSegmentCompleted(uint32_t taskId);
+    void OnTaskSegmentCompleted(Ptr<UbLdstTaskSegment> taskSegment);
+    // 为预取LOAD分配taskSegmentId, 响应经OnRecvAck返回所属thread
+    void RegisterPrefetchSegment(Ptr<UbLdstTaskSegment> taskSegment);
+    uint32_t GetThreadNum() const {return m_threadNum;}
+    // 设置后task按全局地址切分到各内存节点, 忽略task的dest
+    void SetAddressMap(Ptr<UbAddressMap> addressMap);
+    // 发往目标节点尚未完成的taskSegment数
+    uint32_t GetTargetOutstanding(uint32_t dest) const;
+    // 地址池中落在本节点的taskSegment直接访问本地HBM, 完成后回调
+    void HBMAccessDone(uint64_t requestId) override;
 
 private:
+    Ptr<UbLdstTaskSegment> CreateTaskSegment(uint32_t src, uint32_t dest, uint32_t size, uint64_t address,
+                                             uint32_t taskId, UbMemOperationType type);
+    void AccessLocalMemory(Ptr<UbLdstTaskSegment> taskSegment);
+    void FinishTask(uint32_t taskId);
+    uint32_t AllocTaskSegmentId();
     void MemTaskStartsNotify(uint32_t nodeId, uint32_t memTaskId);
     void LastPacketACKsNotify(uint32_t nodeId, uint32_t taskId);
     void MemTaskCompletesNotify(uint32_t nodeId, uint32_t taskId);
@@ -37,12 +55,13 @@ private:
     void LastPacketSendsNotify(uint32_t nodeId, uint32_t memTaskId);
     std::unordered_map<uint32_t, std::vector<Ptr<UbLdstTaskSegment>>> m_taskToSegmentMap;  // taskid -> taskSegments
     std::vector<Ptr<UbLdstThread>> m_threads;
-    std::unordered_map<uint32_t, uint32_t> m_taskSegmentCompletedNum;
+    // taskid -> (dest -> 未完成的taskSegment数), 各目标均完成时task完成
+    std::unordered_map<uint32_t, std::map<uint32_t, uint32_t>> m_taskTargetOutstanding;
+    std::map<uint32_t, uint32_t> m_targetOutstanding;
     std::unordered_map<uint32_t, Ptr<UbLdstTaskSegment>> m_taskSegmentsMap;
-     
-    Ptr<HBMController> m_hbm_controller = HBMHelper().Create(8);
-    // This implements the HBM model
-    
+    std::unordered_map<uint32_t, Callback<void, uint32_t>> m_taskFinishCallbacks;     // taskid -> 完成回调
+    Ptr<UbAddressMap> m_addressMap;
+
     uint32_t m_currentTaskId = 0;
     uint32_t m_threadNum = 0;
     uint32_t m_queuePriority = 0;
@@ -0,0 +1,240 @@
+// SPDX-License-Identifier: GPL-2.0-only
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+#include "ns3/uinteger.h"
+#include "ns3/node-list.h"
+#include "ns3/ub-controller.h"
+#include "ns3/ub-ldst-api.h"
+#include "ns3/ub-ldst-instance.h"
+#include "ns3/ub-ldst-prefetcher.h"
+
+namespace ns3 {
+NS_LOG_COMPONENT_DEFINE("UbLdstPrefetcher");
+NS_OBJECT_ENSURE_REGISTERED(UbLdstPrefetcher);
+
+TypeId UbLdstPrefetcher::GetTypeId(void)
+{
+    static TypeId tid = TypeId("ns3::UbLdstPrefetcher")
+        .SetParent<Object>()
+        .SetGroupName("UnifiedBus")
+        .AddConstructor<UbLdstPrefetcher>()
+        .AddAttribute("Depth",
+                      "Number of slices prefetched ahead of the demand on a trained stream.",
+                      UintegerValue(4),
+                      MakeUintegerAccessor(&UbLdstPrefetcher::m_depth),
+                      MakeUintegerChecker<uint32_t>(1))
+        .AddAttribute("BufferSize",
+                      "Number of slices the prefetch buffer holds, in flight or ready.",
+                      UintegerValue(32),
+                      MakeUintegerAccessor(&UbLdstPrefetcher::m_bufferSize),
+                      MakeUintegerChecker<uint32_t>(1))
+        .AddAttribute("StreamNum",
+                      "Number of LOAD streams tracked at the same time.",
+                      UintegerValue(8),
+                      MakeUintegerAccessor(&UbLdstPrefetcher::m_streamNum),
+                      MakeUintegerChecker<uint32_t>(1))
+        .AddAttribute("TrainThreshold",
+                      "Consecutive accesses with the same stride needed before prefetching.",
+                      UintegerValue(2),
+                      MakeUintegerAccessor(&UbLdstPrefetcher::m_trainThreshold),
+                      MakeUintegerChecker<uint32_t>(1))
+        .AddAttribute("MaxStride",
+                      "Largest stride (bytes) a stream may learn.",
+                      UintegerValue(65536),
+                      MakeUintegerAccessor(&UbLdstPrefetcher::m_maxStride),
+                      MakeUintegerChecker<uint64_t>(1))
+        .AddAttribute("HitLatency",
+                      "Latency of serving a LOAD from the prefetch buffer.",
+                      TimeValue(NanoSeconds(10)),
+                      MakeTimeAccessor(&UbLdstPrefetcher::m_hitLatency),
+                      MakeTimeChecker());
+    return tid;
+}
+
+UbLdstPrefetcher::UbLdstPrefetcher()
+{
+}
+
+UbLdstPrefetcher::~UbLdstPrefetcher()
+{
+}
+
+void UbLdstPrefetcher::DoDispose()
+{
+    m_buffer.clear();
+    m_readyOrder.clear();
+    m_streams.clear();
+    Object::DoDispose();
+}
+
+void UbLdstPrefetcher::Init(uint32_t nodeId, Callback<void, Ptr<UbLdstTaskSegment>> demandDone)
+{
+    m_nodeId = nodeId;
+    m_demandDone = demandDone;
+    m_streams.assign(m_streamNum, Stream());
+}
+
+double UbLdstPrefetcher::GetAccuracy() const
+{
+    return m_issued == 0 ? 0 : static_cast<double>(m_useful) / m_issued;
+}
+
+double UbLdstPrefetcher::GetCoverage() const
+{
+    uint64_t demands = m_useful + m_demandMisses;
+    return demands == 0 ? 0 : static_cast<double>(m_useful) / demands;
+}
+
+bool UbLdstPrefetcher::HandleDemand(Ptr<UbLdstTaskSegment> taskSegment)
+{
+    uint64_t address = taskSegment->GetNextAddress();
+    uint32_t size = taskSegment->PeekNextDataSize();
+    bool served = false;
+    auto it = m_buffer.find({taskSegment->GetDest(), address});
+    if (it != m_buffer.end()) {
+        taskSegment->UpdateSentBytes(size);
+        m_useful++;
+        served = true;
+        if (it->second.ready) {
+            m_buffer.erase(it);
+            Simulator::Schedule(m_hitLatency, &UbLdstPrefetcher::CompleteDemand, this, taskSegment);
+        } else {
+            m_late++;
+            it->second.waiters.push_back(taskSegment);
+        }
+        NS_LOG_DEBUG("[UbLdstPrefetcher HandleDemand] NodeId: " << m_nodeId << " hit address: " << address);
+    } else {
+        m_demandMisses++;
+    }
+    Train(taskSegment, address, size);
+    return served;
+}
+
+/**
+ * @brief 以相同步长命中的流提升置信度, 否则就近重置步长或替换最久未用的流
+ */
+void UbLdstPrefetcher::Train(Ptr<UbLdstTaskSegment> demand, uint64_t address, uint32_t size)
+{
+    uint32_t dest = demand->GetDest();
+    Stream *stream = nullptr;
+    Stream *nearest = nullptr;
+    uint64_t nearestDist = m_maxStride + 1;
+    for (auto &s : m_streams) {
+        if (!s.valid || s.dest != dest) {
+            continue;
+        }
+        int64_t delta = static_cast<int64_t>(address - s.lastAddr);
+        if (s.stride != 0 && delta == s.stride) {
+            stream = &s;
+            break;
+        }
+        uint64_t dist = delta < 0 ? -delta : delta;
+        if (delta != 0 && dist < nearestDist) {
+            nearest = &s;
+            nearestDist = dist;
+        }
+    }
+    if (stream != nullptr) {
+        stream->confidence++;
+    } else if (nearest != nullptr) {
+        stream = nearest;
+        stream->stride = static_cast<int64_t>(address - stream->lastAddr);
+        stream->confidence = 1;
+    } else {
+        stream = &m_streams[0];
+        for (auto &s : m_streams) {
+            if (!s.valid) {
+                stream = &s;
+                break;
+            }
+            if (s.lastUse < stream->lastUse) {
+                stream = &s;
+            }
+        }
+        *stream = Stream();
+        stream->valid = true;
+        stream->dest = dest;
+    }
+    stream->lastAddr = address;
+    stream->lastUse = ++m_useClock;
+    if (stream->stride == 0 || stream->confidence < m_trainThreshold) {
+        return;
+    }
+    for (uint32_t k = 1; k <= m_depth; k++) {
+        uint64_t target = address + stream->stride * static_cast<int64_t>(k);
+        if (m_buffer.count({dest, target}) > 0) {
+            continue;
+        }
+        if (!Reserve()) {
+            return;
+        }
+        IssuePrefetch(demand, target, size);
+    }
+}
+
+/**
+ * @brief 为新预取预留缓冲位置, 缓冲满时淘汰最早返回的未用预取, 全部在途则放弃
+ */
+bool UbLdstPrefetcher::Reserve()
+{
+    while (m_buffer.size() >= m_bufferSize) {
+        if (m_readyOrder.empty()) {
+            return false;
+        }
+        auto it = m_buffer.find(m_readyOrder.front());
+        m_readyOrder.pop_front();
+        if (it != m_buffer.end() && it->second.ready) {
+            m_buffer.erase(it);
+            m_unused++;
+        }
+    }
+    return true;
+}
+
+void UbLdstPrefetcher::IssuePrefetch(Ptr<UbLdstTaskSegment> demand, uint64_t address, uint32_t size)
+{
+    auto prefetch = CreateObject<UbLdstTaskSegment>();
+    prefetch->SetSrc(demand->GetSrc());
+    prefetch->SetDest(demand->GetDest());
+    prefetch->SetType(UbMemOperationType::LOAD);
+    prefetch->SetPriority(demand->GetPriority());
+    prefetch->SetTaskId(demand->GetTaskId());
+    prefetch->SetThreadId(demand->GetThreadId());
+    prefetch->SetSize(size);
+    prefetch->SetAddress(address);
+    prefetch->SetPacketInfo(demand->GetPacketSize(), demand->GetLength());
+    prefetch->SetPrefetch(true);
+    m_buffer[{prefetch->GetDest(), address}] = Entry();
+    m_issued++;
+
+    auto node = NodeList::GetNode(m_nodeId);
+    node->GetObject<UbLdstInstance>()->RegisterPrefetchSegment(prefetch);
+    NS_LOG_DEBUG("[UbLdstPrefetcher IssuePrefetch] NodeId: " << m_nodeId << " dest: " << prefetch->GetDest()
+        << " address: " << address);
+    node->GetObject<UbController>()->GetUbFunction()->GetUbLdstApi()->LdstProcess(prefetch);
+}
+
+void UbLdstPrefetcher::CompleteDemand(Ptr<UbLdstTaskSegment> taskSegment)
+{
+    m_demandDone(taskSegment);
+}
+
+void UbLdstPrefetcher::OnPrefetchResponse(Ptr<UbLdstTaskSegment> prefetchSegment)
+{
+    BufferKey key = {prefetchSegment->GetDest(), prefetchSegment->GetAddress()};
+    auto it = m_buffer.find(key);
+    if (it == m_buffer.end()) {
+        return;
+    }
+    if (it->second.waiters.empty()) {
+        it->second.ready = true;
+        m_readyOrder.push_back(key);
+        return;
+    }
+    for (auto &waiter : it->second.waiters) {
+        Simulator::ScheduleNow(&UbLdstPrefetcher::CompleteDemand, this, waiter);
+    }
+    m_buffer.erase(it);
+}
+
+} // namespace ns3
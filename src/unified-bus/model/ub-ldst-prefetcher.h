@@ -0,0 +1,92 @@
+// SPDX-License-Identifier: GPL-2.0-only
+#ifndef UB_LDST_PREFETCHER_H
+#define UB_LDST_PREFETCHER_H
+
+#include <deque>
+#include <map>
+#include <vector>
+#include "ns3/object.h"
+#include "ns3/nstime.h"
+#include "ns3/callback.h"
+#include "ns3/ub-datatype.h"
+
+namespace ns3 {
+
+/**
+ * @brief LD/ST线程发起端的stride/stream预取引擎
+ *
+ * 按(目的节点, 地址)跟踪至多StreamNum条LOAD流, 同一条流上连续TrainThreshold次以相同步长访问后,
+ * 沿该步长提前发出Depth个预取LOAD, 响应存入本地预取缓冲(至多BufferSize个切片)。
+ * 需求LOAD命中已返回的预取数据时在HitLatency后本地完成, 命中在途预取时等待其响应, 均不再经过网络。
+ * 缓冲满时淘汰最早返回且未被使用的预取数据。
+ */
+class UbLdstPrefetcher : public Object {
+public:
+    static TypeId GetTypeId(void);
+    UbLdstPrefetcher();
+    ~UbLdstPrefetcher() override;
+
+    void Init(uint32_t nodeId, Callback<void, Ptr<UbLdstTaskSegment>> demandDone);
+
+    // 需求LOAD下一个切片, 返回true表示由预取缓冲服务, 完成时回调demandDone
+    bool HandleDemand(Ptr<UbLdstTaskSegment> taskSegment);
+
+    // 预取LOAD响应
+    void OnPrefetchResponse(Ptr<UbLdstTaskSegment> prefetchSegment);
+
+    uint64_t GetIssued() const {return m_issued;}
+    uint64_t GetUseful() const {return m_useful;}
+    uint64_t GetLate() const {return m_late;}
+    uint64_t GetUnused() const {return m_unused;}
+    uint64_t GetDemandMisses() const {return m_demandMisses;}
+    // 准确率: 被使用的预取 / 发出的预取
+    double GetAccuracy() const;
+    // 覆盖率: 由预取服务的需求 / 全部需求
+    double GetCoverage() const;
+
+private:
+    using BufferKey = std::pair<uint32_t, uint64_t>;    // (dest, address)
+
+    struct Stream {
+        uint32_t dest = 0;
+        uint64_t lastAddr = 0;
+        int64_t stride = 0;
+        uint32_t confidence = 0;
+        uint64_t lastUse = 0;
+        bool valid = false;
+    };
+    struct Entry {
+        bool ready = false;
+        std::vector<Ptr<UbLdstTaskSegment>> waiters;   // 命中在途预取的需求
+    };
+
+    void DoDispose() override;
+    void Train(Ptr<UbLdstTaskSegment> demand, uint64_t address, uint32_t size);
+    bool Reserve();
+    void IssuePrefetch(Ptr<UbLdstTaskSegment> demand, uint64_t address, uint32_t size);
+    void CompleteDemand(Ptr<UbLdstTaskSegment> taskSegment);
+
+    uint32_t m_depth;
+    uint32_t m_bufferSize;
+    uint32_t m_streamNum;
+    uint32_t m_trainThreshold;
+    uint64_t m_maxStride;
+    Time m_hitLatency;
+
+    uint32_t m_nodeId = 0;
+    Callback<void, Ptr<UbLdstTaskSegment>> m_demandDone;
+    std::vector<Stream> m_streams;
+    std::map<BufferKey, Entry> m_buffer;
+    std::deque<BufferKey> m_readyOrder;      // 已返回的预取, 按返回顺序淘汰
+    uint64_t m_useClock = 0;
+
+    uint64_t m_issued = 0;
+    uint64_t m_useful = 0;
+    uint64_t m_late = 0;
+    uint64_t m_unused = 0;
+    uint64_t m_demandMisses = 0;
+};
+
+} // namespace ns3
+
+#endif /* UB_LDST_PREFETCHER_H */
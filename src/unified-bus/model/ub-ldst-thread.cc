@@ -6,11 +6,11 @@
 #include "ns3/ub-routing-process.h"
 
 #include "ns3/log.h"
+#include "ns3/boolean.h"
 #include "ns3/simulator.h"
 #include "ns3/ub-controller.h"
 #include "ns3/ub-datatype.h"
-#include "ns3/hbm-controller.h"
-#include "ns3/hbm-bank.h"
+#include "ns3/ub-coherence.h"
 
 namespace ns3 {
 NS_LOG_COMPONENT_DEFINE("UbLdstThread");
@@ -46,7 +46,12 @@ TypeId UbLdstThread::GetTypeId(void)
                                           "Payload size (bytes) for each LOAD request.",
                                           UintegerValue(64),
                                           MakeUintegerAccessor(&UbLdstThread::m_loadReqSize),
-                                          MakeUintegerChecker<uint32_t>());
+                                          MakeUintegerChecker<uint32_t>())
+                            .AddAttribute("EnablePrefetch",
+                                          "Prefetch sequential/strided LOAD streams (see ns3::UbLdstPrefetcher).",
+                                          BooleanValue(false),
+                                          MakeBooleanAccessor(&UbLdstThread::m_enablePrefetch),
+                                          MakeBooleanChecker());
 
     return tid;
 }
@@ -59,11 +64,6 @@ UbLdstThread::~UbLdstThread()
 {
 }
 
-void UbLdstThread::DoInitialize(void) {
-    Simulator::ScheduleNow(&UbLdstThread::InternalHBMAccess, this);
-    Object::DoInitialize();
-}
-
 uint32_t UbLdstThread::CalcLength(uint32_t size)
 {
     // size = 64B * (2 ^ length)
@@ -86,6 +86,15 @@ void UbLdstThread::Init()
     m_storeReqSize = 64 * (1 << m_storeReqLength);
 }
 
+void UbLdstThread::InitPrefetcher()
+{
+    if (!m_enablePrefetch) {
+        return;
+    }
+    m_prefetcher = CreateObject<UbLdstPrefetcher>();
+    m_prefetcher->Init(m_nodeId, MakeCallback(&UbLdstThread::UpdateTask, this));
+}
+
 void UbLdstThread::SetLoadReqSize(uint32_t size)
 {
     m_loadReqSize = size;
@@ -145,6 +154,13 @@ void UbLdstThread::HandleLoadTask()
         auto node = NodeList::GetNode(m_nodeId);
         auto ldstapi = node->GetObject<UbController>()->GetUbFunction()->GetUbLdstApi();
         m_loadOutstanding--;
+        if (ServeFromLines(node, taskSegment)) {
+            continue;
+        }
+        if (m_prefetcher != nullptr && m_prefetcher->HandleDemand(taskSegment)) {
+            // 由预取缓冲服务, 完成时经UpdateTask归还outstanding
+            continue;
+        }
         ldstapi->LdstProcess(taskSegment);
     }
 }
@@ -169,39 +185,24 @@ void UbLdstThread::HandleStoreTask()
         auto node = NodeList::GetNode(m_nodeId);
         auto ldstapi = node->GetObject<UbController>()->GetUbFunction()->GetUbLdstApi();
         m_storeOutstanding--;
+        if (ServeFromLines(node, taskSegment)) {
+            continue;
+        }
         ldstapi->LdstProcess(taskSegment);
     }
 }
 
-uint32_t UbLdstThread::GetHBMIntensity(void) {
-    return this->m_hbm_intensity;
-}
-
-void UbLdstThread::InternalHBMAccess(void) {
-    
-    auto node = NodeList::GetNode(m_nodeId);
-    if (node->GetObject<UbSwitch>()->GetNodeType() != UB_DEVICE)
-        return;
-
-    NS_LOG_DEBUG("Node " << m_nodeId << " makes 2 HBM access at " << Simulator::Now().GetNanoSeconds());
-
-    
-    auto rng = node->GetObject<UniformRandomVariable>();
-    auto hbm = node->GetObject<HBMController>();
-
-    auto jitter = rng->GetInteger(0, 10);
-    bool positive = rng->GetInteger(0, 1) == 0;
-
-    auto hbm_intensity = this->GetHBMIntensity();
-
-    // Very simple logic here, can expand to get more realistic internal traffic patterns
-    for(uint32_t i = 0; i < hbm_intensity; i++) {
-        auto random_bank = rng->GetInteger(0, HBM_BANK_PER_DIE-1);
-        hbm->SendRequest(i, 0x1000, HBM_BANK_ATOMIC_SIZE, random_bank, false, [](void* p){}, nullptr);
+/**
+ * @brief 开启一致性时, 本节点持有的行满足访问则在HitLatency后本地完成, 完成时经UpdateTask归还outstanding
+ */
+bool UbLdstThread::ServeFromLines(Ptr<Node> node, Ptr<UbLdstTaskSegment> taskSegment)
+{
+    auto agent = node->GetObject<UbCoherenceAgent>();
+    if (agent == nullptr || !agent->HandleAccess(taskSegment)) {
+        return false;
     }
-
-    Simulator::Schedule(NanoSeconds(positive ? this->m_fire_period + jitter : this->m_fire_period - jitter),
-    &UbLdstThread::InternalHBMAccess, this);
+    Simulator::Schedule(agent->GetHitLatency(), &UbLdstThread::UpdateTask, this, taskSegment);
+    return true;
 }
 
 void UbLdstThread::SetNode(uint32_t nodeId)
@@ -216,13 +217,18 @@ void UbLdstThread::SetThreadId(uint32_t threadId)
 
 void UbLdstThread::UpdateTask(Ptr<UbLdstTaskSegment> taskSegment)
 {
+    if (taskSegment->IsPrefetch()) {
+        m_prefetcher->OnPrefetchResponse(taskSegment);
+        return;
+    }
     auto taskSegmentId = taskSegment->GetTaskSegmentId();
     m_waitingAckNum[taskSegmentId]--;
     NS_LOG_DEBUG("[UbLdstThread UpdateTask] m_waitingAckNum[" << taskSegmentId << "]"
                  << m_waitingAckNum[taskSegmentId]);
     if (m_waitingAckNum[taskSegmentId] == 0) {
+        m_waitingAckNum.erase(taskSegmentId);
         auto ldstInstance = NodeList::GetNode(m_nodeId)->GetObject<UbLdstInstance>();
-        ldstInstance->OnTaskSegmentCompleted(taskSegment->GetTaskId());
+        ldstInstance->OnTaskSegmentCompleted(taskSegment);
     }
     if (taskSegment->GetType() == UbMemOperationType::LOAD) {
         m_loadOutstanding++;
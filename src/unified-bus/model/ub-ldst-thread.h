@@ -2,6 +2,7 @@
 #ifndef UB_LDST_THREAD_H
 #define UB_LDST_THREAD_H
 #include "ns3/ub-ldst-instance.h"
+#include "ns3/ub-ldst-prefetcher.h"
 
 namespace ns3 {
 class UbController;
@@ -13,7 +14,6 @@ public:
     static TypeId GetTypeId(void);
     UbLdstThread();
     virtual ~UbLdstThread();
-    void DoInitialize(void) override;
     void Init();
     void PushTaskSegment(Ptr<UbLdstTaskSegment> taskSegment);
     void HandleTaskSegment();
@@ -25,12 +25,12 @@ public:
     void SetLoadReqSize(uint32_t size);
     void SetStoreReqLength(uint32_t length);
     void SetLoadRspLength(uint32_t length);
+    // EnablePrefetch时创建预取引擎, 需在SetNode之后调用
+    void InitPrefetcher();
+    Ptr<UbLdstPrefetcher> GetPrefetcher() {return m_prefetcher;}
 private:
-
-    void InternalHBMAccess();
-    uint32_t GetHBMIntensity();
-
     uint32_t CalcLength(uint32_t size);
+    bool ServeFromLines(Ptr<Node> node, Ptr<UbLdstTaskSegment> taskSegment);
     uint32_t m_nodeId;
     uint32_t m_threadId;
     std::queue<Ptr<UbLdstTaskSegment>> m_loadQueue;
@@ -44,10 +44,8 @@ private:
     uint32_t m_storeOutstanding; // 发数据包--, 收ack ++
     uint32_t m_loadOutstanding; // 发数据包--, 收ack ++
     std::unordered_map<uint32_t, uint32_t> m_waitingAckNum;
-
-    const uint32_t m_fire_period = 500; // nanoseconds
-    const uint32_t m_hbm_intensity = 2;
-
+    bool m_enablePrefetch;
+    Ptr<UbLdstPrefetcher> m_prefetcher;
 };
 } // namespace ns3
 
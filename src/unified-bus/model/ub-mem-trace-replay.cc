@@ -0,0 +1,167 @@
+// SPDX-License-Identifier: GPL-2.0-only
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "ns3/abort.h"
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+#include "ns3/uinteger.h"
+#include "ns3/node-list.h"
+#include "ns3/ub-ldst-instance.h"
+#include "ns3/ub-mem-trace-replay.h"
+
+namespace ns3 {
+NS_LOG_COMPONENT_DEFINE("UbMemTraceReplay");
+NS_OBJECT_ENSURE_REGISTERED(UbMemTraceReplay);
+
+TypeId UbMemTraceReplay::GetTypeId(void)
+{
+    static TypeId tid = TypeId("ns3::UbMemTraceReplay")
+        .SetParent<Object>()
+        .SetGroupName("UnifiedBus")
+        .AddConstructor<UbMemTraceReplay>()
+        .AddAttribute("Lookahead",
+                      "Maximum number of trace records issued but not yet completed.",
+                      UintegerValue(1024),
+                      MakeUintegerAccessor(&UbMemTraceReplay::m_lookahead),
+                      MakeUintegerChecker<uint32_t>(1))
+        .AddTraceSource("RecordIssued",
+                        "A trace record is handed to the LD/ST instance of its source node.",
+                        MakeTraceSourceAccessor(&UbMemTraceReplay::m_traceRecordIssued),
+                        "ns3::UbMemTraceReplay::RecordTracedCallback")
+        .AddTraceSource("RecordCompleted",
+                        "A trace record completes.",
+                        MakeTraceSourceAccessor(&UbMemTraceReplay::m_traceRecordCompleted),
+                        "ns3::UbMemTraceReplay::RecordTracedCallback");
+    return tid;
+}
+
+UbMemTraceReplay::UbMemTraceReplay()
+{
+}
+
+UbMemTraceReplay::~UbMemTraceReplay()
+{
+}
+
+void UbMemTraceReplay::DoDispose()
+{
+    m_issueEvent.Cancel();
+    if (m_data != nullptr) {
+        munmap(const_cast<uint8_t *>(m_data), m_mapSize);
+        m_data = nullptr;
+    }
+    m_inFlight.clear();
+    Object::DoDispose();
+}
+
+void UbMemTraceReplay::EncodeRecord(const UbMemTraceRecord &record, uint8_t *buf)
+{
+    std::memcpy(buf, &record.deltaNs, 4);
+    std::memcpy(buf + 4, &record.src, 4);
+    std::memcpy(buf + 8, &record.dst, 4);
+    std::memcpy(buf + 12, &record.address, 8);
+    std::memcpy(buf + 20, &record.size, 4);
+    std::memcpy(buf + 24, &record.threadId, 2);
+    buf[26] = record.isWrite;
+    buf[27] = record.reserved;
+}
+
+UbMemTraceRecord UbMemTraceReplay::DecodeRecord(const uint8_t *buf)
+{
+    UbMemTraceRecord record;
+    std::memcpy(&record.deltaNs, buf, 4);
+    std::memcpy(&record.src, buf + 4, 4);
+    std::memcpy(&record.dst, buf + 8, 4);
+    std::memcpy(&record.address, buf + 12, 8);
+    std::memcpy(&record.size, buf + 20, 4);
+    std::memcpy(&record.threadId, buf + 24, 2);
+    record.isWrite = buf[26];
+    record.reserved = buf[27];
+    return record;
+}
+
+void UbMemTraceReplay::Start(const std::string &filename)
+{
+    // 文件与格式错误在优化编译(断言关闭)下同样需要报告
+    int fd = open(filename.c_str(), O_RDONLY);
+    NS_ABORT_MSG_IF(fd < 0, "Can not open File: " << filename);
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        NS_FATAL_ERROR("Can not stat File: " << filename);
+    }
+    NS_ABORT_MSG_IF(static_cast<size_t>(st.st_size) < MAGIC_SIZE, "Invalid memory trace: " << filename);
+    m_mapSize = st.st_size;
+    void *addr = mmap(nullptr, m_mapSize, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    NS_ABORT_MSG_IF(addr == MAP_FAILED, "Can not mmap File: " << filename);
+    // 顺序读取, 已读页可由内核回收
+    madvise(addr, m_mapSize, MADV_SEQUENTIAL);
+    m_data = static_cast<const uint8_t *>(addr);
+    NS_ABORT_MSG_IF(std::memcmp(m_data, MAGIC, MAGIC_SIZE) != 0, "Invalid memory trace magic: " << filename);
+    NS_ABORT_MSG_IF((m_mapSize - MAGIC_SIZE) % RECORD_SIZE != 0, "Truncated memory trace: " << filename);
+    m_offset = MAGIC_SIZE;
+    m_lastIssue = Simulator::Now();
+    NS_LOG_INFO("[UbMemTraceReplay Start] " << filename << " records: " << (m_mapSize - MAGIC_SIZE) / RECORD_SIZE);
+    m_issueEvent = Simulator::ScheduleNow(&UbMemTraceReplay::IssueNext, this);
+}
+
+bool UbMemTraceReplay::IsCompleted() const
+{
+    return m_data == nullptr || (m_offset >= m_mapSize && m_inFlight.empty());
+}
+
+void UbMemTraceReplay::IssueNext()
+{
+    while (m_offset < m_mapSize && m_inFlight.size() < m_lookahead) {
+        UbMemTraceRecord record = DecodeRecord(m_data + m_offset);
+        Time issueTime = m_lastIssue + NanoSeconds(record.deltaNs);
+        if (issueTime > Simulator::Now()) {
+            m_issueEvent = Simulator::Schedule(issueTime - Simulator::Now(), &UbMemTraceReplay::IssueNext, this);
+            return;
+        }
+        m_offset += RECORD_SIZE;
+        m_lastIssue = Simulator::Now();
+        Issue(record);
+    }
+}
+
+void UbMemTraceReplay::Issue(const UbMemTraceRecord &record)
+{
+    NS_ABORT_MSG_IF(record.src >= NodeList::GetNNodes(), "Trace source node " << record.src << " does not exist");
+    auto ldst = NodeList::GetNode(record.src)->GetObject<UbLdstInstance>();
+    NS_ABORT_MSG_IF(ldst == nullptr || ldst->GetThreadNum() == 0, "Trace source node " << record.src
+                    << " has no LD/ST thread");
+    if (record.size == 0) {
+        return;
+    }
+    uint32_t taskId = m_nextTaskId;
+    m_nextTaskId = m_nextTaskId == UINT32_MAX ? TASK_ID_BASE : m_nextTaskId + 1;
+    std::vector<uint32_t> threadIds = {record.threadId % ldst->GetThreadNum()};
+    m_inFlight[taskId] = record.src;
+    m_issued++;
+    m_traceRecordIssued(record.src, taskId);
+    // 完成回调按task登记, 不覆盖UbApp在同一实例上设置的回调
+    ldst->HandleLdstTask(record.src, record.dst, record.size, taskId,
+                         record.isWrite ? UbMemOperationType::STORE : UbMemOperationType::LOAD,
+                         threadIds, record.address, MakeCallback(&UbMemTraceReplay::OnTaskCompleted, this));
+}
+
+void UbMemTraceReplay::OnTaskCompleted(uint32_t taskId)
+{
+    auto it = m_inFlight.find(taskId);
+    if (it == m_inFlight.end()) {
+        return;
+    }
+    m_traceRecordCompleted(it->second, taskId);
+    m_inFlight.erase(it);
+    m_completed++;
+    if (!m_issueEvent.IsPending()) {
+        m_issueEvent = Simulator::ScheduleNow(&UbMemTraceReplay::IssueNext, this);
+    }
+}
+
+} // namespace ns3
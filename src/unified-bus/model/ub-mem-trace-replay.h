@@ -0,0 +1,83 @@
+// SPDX-License-Identifier: GPL-2.0-only
+#ifndef UB_MEM_TRACE_REPLAY_H
+#define UB_MEM_TRACE_REPLAY_H
+
+#include <string>
+#include <unordered_map>
+#include "ns3/object.h"
+#include "ns3/nstime.h"
+#include "ns3/event-id.h"
+#include "ns3/traced-callback.h"
+
+namespace ns3 {
+
+/**
+ * @brief 二进制访存trace的一条记录, 文件中按小端紧凑存放(28字节), 文件头为8字节魔数"UBMEMTR1"
+ */
+struct UbMemTraceRecord {
+    uint32_t deltaNs;       // 距上一条记录的时间间隔
+    uint32_t src;           // 发起访存的节点
+    uint32_t dst;           // 内存所在节点
+    uint64_t address;
+    uint32_t size;
+    uint16_t threadId;      // 发起节点上的LD/ST线程, 超出ThreadNum时取模
+    uint8_t isWrite;        // 0: LOAD, 1: STORE
+    uint8_t reserved;
+};
+
+/**
+ * @brief LD/ST访存trace回放
+ *
+ * 将trace文件mmap后顺序读取, 每条记录作为一个单线程LD/ST task交给发起节点的UbLdstInstance,
+ * 同一线程上的记录按trace顺序进入该线程, 并发度受线程的LoadOutstanding/StoreOutstanding限制。
+ * 在途(已下发未完成)记录数不超过Lookahead, 达到上限时暂停读取, 因此回放内存与trace长度无关。
+ * 记录按deltaNs相对上一条记录的下发时刻发出, 因Lookahead暂停后的记录顺延。
+ */
+class UbMemTraceReplay : public Object {
+public:
+    static constexpr char MAGIC[] = "UBMEMTR1";
+    static constexpr uint32_t MAGIC_SIZE = 8;
+    static constexpr uint32_t RECORD_SIZE = 28;
+    // 回放task的taskId从此开始, 与traffic.csv中的taskId不重叠
+    static constexpr uint32_t TASK_ID_BASE = 0x80000000;
+
+    static TypeId GetTypeId(void);
+    UbMemTraceReplay();
+    ~UbMemTraceReplay() override;
+
+    // mmap trace文件并开始回放
+    void Start(const std::string &filename);
+
+    bool IsCompleted() const;
+    uint64_t GetIssued() const {return m_issued;}
+    uint64_t GetCompleted() const {return m_completed;}
+
+    // 将一条记录编码为文件格式, 供生成trace的工具使用
+    static void EncodeRecord(const UbMemTraceRecord &record, uint8_t *buf);
+    static UbMemTraceRecord DecodeRecord(const uint8_t *buf);
+
+private:
+    void DoDispose() override;
+    void IssueNext();
+    void Issue(const UbMemTraceRecord &record);
+    void OnTaskCompleted(uint32_t taskId);
+
+    uint32_t m_lookahead;
+
+    const uint8_t *m_data = nullptr;    // mmap区域
+    size_t m_mapSize = 0;
+    size_t m_offset = 0;                // 下一条记录的偏移
+    Time m_lastIssue;
+    EventId m_issueEvent;
+    uint32_t m_nextTaskId = TASK_ID_BASE;
+    std::unordered_map<uint32_t, uint32_t> m_inFlight;     // taskId -> src node
+    uint64_t m_issued = 0;
+    uint64_t m_completed = 0;
+
+    TracedCallback<uint32_t, uint32_t> m_traceRecordIssued;     // (src, taskId)
+    TracedCallback<uint32_t, uint32_t> m_traceRecordCompleted;  // (src, taskId)
+};
+
+} // namespace ns3
+
+#endif /* UB_MEM_TRACE_REPLAY_H */
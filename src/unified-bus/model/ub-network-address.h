@@ -27,6 +27,10 @@ struct TrafficRecord
 };
 
 constexpr long DEFAULT_PORT_BUFFER_SIZE = 2097152;
+constexpr long DEFAULT_SHARED_BUFFER_SIZE = 33554432;
+constexpr long DEFAULT_PFC_HEADROOM_SIZE = 65536;
+constexpr long DEFAULT_ECN_KMIN = 40960;
+constexpr long DEFAULT_ECN_KMAX = 163840;
 // 根据NodeId转IPv4地址
 constexpr int BYTE_RANGE = 256;
 inline Ipv4Address NodeIdToIp(uint32_t id)
@@ -154,5 +158,26 @@ inline uint32_t IpToCna24(Ipv4Address ip)
     return NodeIdToCna24(node_id);
 }
 
+// 按LDST网络头宽度(CNA16/CNA24)转换
+inline uint32_t NodeIdToCna(uint32_t nodeId, bool cna24)
+{
+    return cna24 ? NodeIdToCna24(nodeId) : NodeIdToCna16(nodeId);
+}
+
+inline uint32_t CnaToNodeId(uint32_t cnaAddr, bool cna24)
+{
+    return cna24 ? Cna24ToNodeId(cnaAddr) : Cna16ToNodeId(cnaAddr);
+}
+
+inline uint32_t CnaToPortId(uint32_t cnaAddr, bool cna24)
+{
+    return cna24 ? Cna24ToPortId(cnaAddr) : Cna16ToPortId(cnaAddr);
+}
+
+inline Ipv4Address CnaToIp(uint32_t cnaAddr, bool cna24)
+{
+    return cna24 ? Cna24ToIp(cnaAddr) : Cna16ToIp(cnaAddr);
+}
+
 }
 #endif
@@ -8,6 +8,7 @@
 using namespace utils;
 
 namespace ns3 {
+NS_OBJECT_ENSURE_REGISTERED(UbEgressQueue);
 NS_OBJECT_ENSURE_REGISTERED(UbPort);
 NS_LOG_COMPONENT_DEFINE("UbPort");
 
@@ -39,7 +40,18 @@ TypeId UbEgressQueue::GetTypeId(void)
             "The maximum number of packets accepted by this eq.",
             UintegerValue(100),
             MakeUintegerAccessor(&UbEgressQueue::m_maxIngressQueues),
-            MakeUintegerChecker<uint32_t>());
+            MakeUintegerChecker<uint32_t>())
+            .AddAttribute(
+            "MaxBytes",
+            "The maximum number of bytes accepted by this eq. The allocator stops granting when it is full.",
+            UintegerValue(65536),
+            MakeUintegerAccessor(&UbEgressQueue::m_maxBytes),
+            MakeUintegerChecker<uint32_t>())
+            .AddTraceSource(
+            "BackPressure",
+            "The allocator is back-pressured by a full UbEgressQueue.",
+            MakeTraceSourceAccessor(&UbEgressQueue::m_traceBackPressure),
+            "ns3::UbEgressQueue::BackPressureTracedCallback");
     return tid;
 }
 
@@ -47,15 +59,41 @@ UbEgressQueue::UbEgressQueue()
 {
 }
 
-bool UbEgressQueue::DoEnqueue(PacketEntry packetEntry)
+bool UbEgressQueue::IsFull()
 {
-    NS_LOG_FUNCTION (this);
+    return m_egressQ.size() >= m_maxIngressQueues || m_bytes >= m_maxBytes;
+}
+
+void UbEgressQueue::NotifyBackPressure()
+{
+    if (m_backPressured) {
+        return;
+    }
+    m_backPressured = true;
+    m_backPressureCount++;
+    m_traceBackPressure(m_bytes);
+    NS_LOG_LOGIC ("[UbEgressQueue NotifyBackPressure] Egress Queue bytes: " << m_bytes);
+}
 
-    if (m_egressQ.size () >= m_maxIngressQueues) {
-        NS_LOG_LOGIC ("Queue full (at max packets) -- droppping pkt");
+bool UbEgressQueue::ReleaseBackPressure()
+{
+    // 仍在门限以上时保持反压, 避免同一次反压被重复计数
+    if (!m_backPressured || IsFull()) {
         return false;
     }
+    m_backPressured = false;
+    return true;
+}
+
+bool UbEgressQueue::DoEnqueue(PacketEntry packetEntry)
+{
+    NS_LOG_FUNCTION (this);
+
+    // 报文已出ingress queue并扣除流控资源, 此处不能丢包
+    NS_ASSERT_MSG(!IsFull(), "Egress queue overflow, allocator must check IsFull before granting");
     m_egressQ.push(packetEntry);
+    m_bytes += std::get<2>(packetEntry)->GetSize();
+    m_peakBytes = std::max(m_peakBytes, m_bytes);
 
     NS_LOG_LOGIC ("[UbEgressQueue DoEnqueue] Egress Queue size: " << m_egressQ.size ());
 
@@ -84,6 +122,7 @@ PacketEntry UbEgressQueue::DoDequeue()
 
     auto packetEntry = m_egressQ.front ();
     m_egressQ.pop();
+    m_bytes -= std::get<2>(packetEntry)->GetSize();
 
     NS_LOG_LOGIC ("[UbEgressQueue DoDequeue] Egress Queue size: " << m_egressQ.size ());
 
@@ -95,6 +134,11 @@ bool UbEgressQueue::IsEmpty()
     return m_egressQ.empty();
 }
 
+uint32_t UbEgressQueue::GetSize()
+{
+    return m_egressQ.size();
+}
+
 /******************
  * UbPort
  *****************/
@@ -138,6 +182,22 @@ TypeId UbPort::GetTypeId(void)
                           UintegerValue(2),
                           MakeUintegerAccessor(&UbPort::m_cbfcRetCellGrainControlPacket),
                           MakeUintegerChecker<uint8_t>())
+            .AddAttribute("CbfcCreditBatching",
+                          "Aggregate Cbfc credits per VL, piggyback them on reverse data packets and "
+                          "send credit control frames only on timeout or when CbfcCreditFlushGrains is reached",
+                          BooleanValue(false),
+                          MakeBooleanAccessor(&UbPort::m_cbfcCreditBatching),
+                          MakeBooleanChecker())
+            .AddAttribute("CbfcCreditReturnInterval",
+                          "Max time a returnable credit waits for piggyback before a credit control frame is sent",
+                          TimeValue(NanoSeconds(100)),
+                          MakeTimeAccessor(&UbPort::m_cbfcCreditReturnInterval),
+                          MakeTimeChecker())
+            .AddAttribute("CbfcCreditFlushGrains",
+                          "Control packet grains of one VL that trigger an immediate credit control frame",
+                          UintegerValue(16),
+                          MakeUintegerAccessor(&UbPort::m_cbfcCreditFlushGrains),
+                          MakeUintegerChecker<uint32_t>(1, 0x3F))
             .AddAttribute("CbfcInitCreditCell",
                           "According to the configuration of the receive buffer at the connected node port, "
                           "the unit is cell",
@@ -219,6 +279,7 @@ void UbPort::CreateAndInitFc(const std::string& type)
         auto flowControl = DynamicCast<UbCbfc>(m_flowControl);
         flowControl->Init(m_cbfcFlitLen, m_cbfcFlitsPerCell, m_cbfcRetCellGrainDataPacket,
             m_cbfcRetCellGrainControlPacket, m_cbfcPortTxfree, GetNode()->GetId(), m_portId);
+        flowControl->SetCreditBatching(m_cbfcCreditBatching, m_cbfcCreditReturnInterval, m_cbfcCreditFlushGrains);
         NS_LOG_DEBUG("[UbPort CreateAndInitFc] flowControl Cbfc Init");
     } else if (type == "PFC") {
         m_flowControl = CreateObject<UbPfc>();
@@ -277,9 +338,9 @@ void UbPort::DequeuePacket(void)
     m_currentPkt = packet;
     m_currentInPortId = inPortId;
     m_currentPriority = priority;
-    if (m_ubEQ->IsEmpty()) {
-        // Switch allocation when port sendding packet.
-        auto allocator = GetNode()->GetObject<UbSwitch>()->GetAllocator();
+    if (m_ubEQ->ReleaseBackPressure() || m_ubEQ->IsEmpty()) {
+        // Switch allocation when port sendding packet, or eq has room again after back-pressure.
+        auto allocator = GetNode()->GetObject<UbSwitch>()->GetAllocator(m_portId);
         Simulator::ScheduleNow(&UbSwitchAllocator::TriggerAllocator, allocator, this);
     }
 
@@ -292,7 +353,13 @@ void UbPort::DequeuePacket(void)
         m_faultCallBack(packet, GetNode()->GetId(), m_portId, this);
         return;
     }
-    TransmitPacket(packet, Time(0));
+    // 多die节点: 本地报文需先跨die到达本端口
+    Time delay = Time(0);
+    if (inPortId == m_portId) {
+        Time crossing = GetNode()->GetObject<UbSwitch>()->GetLocalEgressDelay(m_portId, packet);
+        delay = Max(Time(0), crossing - m_bps.CalculateBytesTxTime(packet->GetSize()));
+    }
+    TransmitPacket(packet, delay);
     return;
 }
 
@@ -311,12 +378,32 @@ void UbPort::TransmitPacket(Ptr<Packet> packet, Time delay)
         packet->AddPacketTag(tag);
     }
 
+    // 捎带返回对端的信用证
+    m_flowControl->PiggybackCredit(packet);
     Time txTime = m_bps.CalculateBytesTxTime(packet->GetSize()) + delay;
+    // 直通转发的包, 出端口不能早于入端口收完包尾
+    UbTimestampTag ctTag;
+    if (packet->RemovePacketTag(ctTag)) {
+        txTime = Max(txTime, ctTag.GetTime() - Simulator::Now());
+    }
     Time txCompleteTime = txTime + m_tInterframeGap;
     TraComEventNotify(packet, txCompleteTime);
 
     Simulator::Schedule(txCompleteTime, &UbPort::TransmitComplete, this);
-    bool result = m_channel->TransmitStart(packet, this, txTime);
+    bool result = false;
+    auto peerSwitch = m_channel->GetDestination(this)->GetNode()->GetObject<UbSwitch>();
+    uint32_t headerSize = peerSwitch->GetCutThroughHeaderSize();
+    if (peerSwitch->IsCutThroughEnable() && packet->GetSize() > headerSize) {
+        // 对端直通模式: 包头到达即交付, 标记包尾到达时间; 拷贝避免与m_currentPkt共享
+        Time headerTime = Max(m_bps.CalculateBytesTxTime(headerSize),
+                              txTime - m_bps.CalculateBytesTxTime(packet->GetSize() - headerSize));
+        Ptr<Packet> ctPacket = packet->Copy();
+        Time tailArrival = Simulator::Now() + txTime + m_channel->GetDelay();
+        ctPacket->AddPacketTag(UbTimestampTag(UbTimestampType::TAIL_ARRIVAL, tailArrival));
+        result = m_channel->TransmitStart(ctPacket, this, headerTime);
+    } else {
+        result = m_channel->TransmitStart(packet, this, txTime);
+    }
     if (result == false) {
         NS_LOG_DEBUG("[DequeueAndTransmit]: send fail");
     }
@@ -343,6 +430,7 @@ void UbPort::Receive(Ptr<Packet> packet)
         packet->AddPacketTag(tag);
     }
     PortRxNotify(GetNode()->GetId(), m_portId, packet->GetSize());
+    m_flowControl->HandlePiggybackCredit(packet);
     GetNode()->GetObject<UbSwitch>()->SwitchHandlePacket(this, packet);
 
     return;
@@ -439,7 +527,7 @@ void UbPort::TriggerTransmit()
     }
     if (m_ubEQ->IsEmpty()) {
         NS_LOG_DEBUG("[UbPort TriggerTransmit] trigger Allocator");
-        auto allocator = GetNode()->GetObject<UbSwitch>()->GetAllocator();
+        auto allocator = GetNode()->GetObject<UbSwitch>()->GetAllocator(m_portId);
         Simulator::ScheduleNow(&UbSwitchAllocator::TriggerAllocator, allocator, this);
         return;
     }
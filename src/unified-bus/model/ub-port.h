@@ -48,20 +48,45 @@ public:
     std::queue<PacketEntry> m_egressQ; // 通过算法分配到的包, inPortId, priority, packet
 
     uint32_t m_maxIngressQueues;   // eq存储最大包数
+    uint32_t m_maxBytes;           // eq存储最大字节数
 
     static TypeId GetTypeId(void);
     explicit UbEgressQueue();
 
-    bool DoEnqueue(PacketEntry packetEntry);  // 向端口eq塞入包
+    // 分配器授权前检查eq是否已满, 未满时可再接纳一个包(字节数至多超出一个包)
+    bool IsFull();
+    // eq已满, 分配器停止授权, 记录一次反压
+    void NotifyBackPressure();
+    // 出队后eq降到门限以下时清除反压状态, 返回true表示需重新触发分配器
+    bool ReleaseBackPressure();
+
+    bool DoEnqueue(PacketEntry packetEntry);  // 向端口eq塞入包, 调用前须由IsFull确认有空间
     PacketEntry Peekqueue(void);
     PacketEntry DoDequeue(void);
     // 为报文添加UDP、IPV4、DL packet头
     void AddPacketHeader(Ptr<UbTransportChannel> tp, Ptr<Packet> p, bool credit, bool ack);
 
     bool IsEmpty();
+    uint32_t GetSize();
+    uint64_t GetBytes() {return m_bytes;}
+    uint64_t GetPeakBytes() {return m_peakBytes;}
+    uint64_t GetBackPressureCount() {return m_backPressureCount;}
 
     TracedCallback<Ptr<const Packet>, uint32_t> m_traceUbEnqueue;
     TracedCallback<Ptr<const Packet>, uint32_t> m_traceUbDequeue;
+    TracedCallback<uint64_t> m_traceBackPressure;    // 参数为反压时eq中的字节数
+
+    /**
+     * @brief 分配器因eq满而被反压
+     * @param bytes 反压时eq中的字节数
+     */
+    typedef void (*BackPressureTracedCallback)(uint64_t bytes);
+
+private:
+    uint64_t m_bytes = 0;                // eq当前字节数
+    uint64_t m_peakBytes = 0;            // eq字节数峰值
+    uint64_t m_backPressureCount = 0;    // 反压次数
+    bool m_backPressured = false;        // 分配器是否因eq满而停止授权
 };
 
 enum class SendState {
@@ -220,6 +245,9 @@ private:
     uint8_t m_cbfcRetCellGrainDataPacket;       // 数据包返回的CRD的粒度，通常从以下选项中选择 {1, 2, 4, 8, 16, 32, 64, 128}
     uint8_t m_cbfcRetCellGrainControlPacket;    // 控制报文返回的CRD的粒度，通常从以下选项中选择 {1, 2, 4, 8, 16, 32, 64, 128}
     int32_t m_cbfcPortTxfree;
+    bool m_cbfcCreditBatching;
+    Time m_cbfcCreditReturnInterval;
+    uint32_t m_cbfcCreditFlushGrains;
 
     // pfc
     int32_t m_pfcUpThld;
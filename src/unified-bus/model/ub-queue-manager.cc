@@ -1,6 +1,11 @@
 // SPDX-License-Identifier: GPL-2.0-only
+#include <algorithm>
 #include "ns3/ub-queue-manager.h"
 #include "ns3/ub-header.h"
+#include "ns3/double.h"
+#include "ns3/boolean.h"
+#include "ns3/uinteger.h"
+#include "ns3/trace-source-accessor.h"
 
 namespace ns3 {
 
@@ -93,6 +98,9 @@ uint32_t UbPacketQueue::GetNextPacketSize()
 /*-----------------------------------------UbQueueManager----------------------------------------------*/
 UbQueueManager::UbQueueManager(void)
 {
+    m_ecnRandom = CreateObject<UniformRandomVariable>();
+    m_ecnRandom->SetAttribute("Min", DoubleValue(0.0));
+    m_ecnRandom->SetAttribute("Max", DoubleValue(1.0));
 }
 
 TypeId UbQueueManager::GetTypeId(void)
@@ -105,7 +113,46 @@ TypeId UbQueueManager::GetTypeId(void)
         "Port Buffer Size in Byte.",
         UintegerValue(utils::DEFAULT_PORT_BUFFER_SIZE),
         MakeUintegerAccessor(&UbQueueManager::m_bufferSize),
-        MakeUintegerChecker<uint32_t>());
+        MakeUintegerChecker<uint32_t>())
+        .AddAttribute("EcnKMin",
+        "Egress queue size in Byte below which packets are never ECN marked.",
+        UintegerValue(utils::DEFAULT_ECN_KMIN),
+        MakeUintegerAccessor(&UbQueueManager::m_ecnKMin),
+        MakeUintegerChecker<uint32_t>())
+        .AddAttribute("EcnKMax",
+        "Egress queue size in Byte above which packets are always ECN marked.",
+        UintegerValue(utils::DEFAULT_ECN_KMAX),
+        MakeUintegerAccessor(&UbQueueManager::m_ecnKMax),
+        MakeUintegerChecker<uint32_t>())
+        .AddAttribute("EcnPMax",
+        "ECN mark probability when egress queue size reaches EcnKMax.",
+        DoubleValue(0.2),
+        MakeDoubleAccessor(&UbQueueManager::m_ecnPMax),
+        MakeDoubleChecker<double>(0.0, 1.0))
+        .AddAttribute("EnableSharedBuffer",
+        "Use a switch wide shared buffer with dynamic thresholds instead of static per port BufferSize.",
+        BooleanValue(false),
+        MakeBooleanAccessor(&UbQueueManager::m_sharedBufferEnable),
+        MakeBooleanChecker())
+        .AddAttribute("SharedBufferSize",
+        "Shared buffer pool size of the switch in Byte.",
+        UintegerValue(utils::DEFAULT_SHARED_BUFFER_SIZE),
+        MakeUintegerAccessor(&UbQueueManager::m_sharedBufferSize),
+        MakeUintegerChecker<uint64_t>())
+        .AddAttribute("DtAlpha",
+        "Dynamic threshold factor, a queue may use up to alpha * free shared buffer.",
+        DoubleValue(1.0),
+        MakeDoubleAccessor(&UbQueueManager::m_dtAlpha),
+        MakeDoubleChecker<double>(0.0))
+        .AddAttribute("HeadroomSize",
+        "Per port/priority headroom in Byte reserved outside the shared pool to absorb in-flight data after PFC pause.",
+        UintegerValue(utils::DEFAULT_PFC_HEADROOM_SIZE),
+        MakeUintegerAccessor(&UbQueueManager::m_headroomSize),
+        MakeUintegerChecker<uint32_t>())
+        .AddTraceSource("BufferDrop",
+        "Packet dropped at ingress admission, port, priority, size",
+        MakeTraceSourceAccessor(&UbQueueManager::m_traceBufferDrop),
+        "ns3::UbQueueManager::BufferDrop");
     return tid;
 }
 
@@ -119,6 +166,10 @@ void UbQueueManager::Init()
     for (auto& i : m_egressBuf) {
         i.resize(m_vlNum);
     }
+    m_egressPortBuf.assign(m_portsNum, 0);
+    for (auto* buf : {&m_headroomBuf, &m_ingressPeak, &m_headroomPeak, &m_dropCnt}) {
+        buf->assign(m_portsNum, std::vector<uint64_t>(m_vlNum, 0));
+    }
 }
 
 uint64_t UbQueueManager::GetIngressUsed(uint32_t port, uint32_t priority)
@@ -128,16 +179,72 @@ uint64_t UbQueueManager::GetIngressUsed(uint32_t port, uint32_t priority)
 
 bool UbQueueManager::CheckIngress(uint32_t port, uint32_t priority, uint32_t pSize)
 {
-    return (m_ingressBuf[port][priority] + pSize < m_bufferSize);
+    bool admit;
+    if (m_sharedBufferEnable) {
+        admit = CheckSharedAdmission(port, priority, pSize)
+                || m_headroomBuf[port][priority] + pSize <= m_headroomSize;
+    } else {
+        admit = (m_ingressBuf[port][priority] + pSize < m_bufferSize);
+    }
+    if (!admit) {
+        NS_LOG_DEBUG("[QMU CheckIngress] drop port: " << port << " priority: " << priority
+                     << " ingress: " << m_ingressBuf[port][priority]
+                     << " headroom: " << m_headroomBuf[port][priority]
+                     << " shared: " << m_sharedUsed);
+        m_dropCnt[port][priority]++;
+        m_traceBufferDrop(port, priority, pSize);
+    }
+    return admit;
+}
+
+uint64_t UbQueueManager::GetDynamicThreshold()
+{
+    uint64_t freeSize = m_sharedBufferSize > m_sharedUsed ? m_sharedBufferSize - m_sharedUsed : 0;
+    return static_cast<uint64_t>(m_dtAlpha * freeSize);
+}
+
+uint64_t UbQueueManager::GetIngressSharedUsed(uint32_t port, uint32_t priority)
+{
+    return m_ingressBuf[port][priority] - m_headroomBuf[port][priority];
+}
+
+/**
+ * @brief 动态门限准入：队列共享部分不超过alpha * 共享池剩余，且共享池有空间
+ */
+bool UbQueueManager::CheckSharedAdmission(uint32_t port, uint32_t priority, uint32_t pSize)
+{
+    return m_sharedUsed + pSize <= m_sharedBufferSize
+           && GetIngressSharedUsed(port, priority) + pSize <= GetDynamicThreshold();
 }
 
 void UbQueueManager::PushIngress(uint32_t port, uint32_t priority, uint32_t pSize)
 {
+    if (m_sharedBufferEnable) {
+        // 超出动态门限的部分进入headroom(PFC暂停后的在途数据), headroom不超过HeadroomSize,
+        // 未经CheckIngress准入的报文(如跨die本地交付)溢出部分计入共享池
+        uint64_t toHeadroom = 0;
+        if (!CheckSharedAdmission(port, priority, pSize)) {
+            uint64_t headroomFree = m_headroomSize > m_headroomBuf[port][priority]
+                                    ? m_headroomSize - m_headroomBuf[port][priority] : 0;
+            toHeadroom = std::min<uint64_t>(headroomFree, pSize);
+        }
+        m_headroomBuf[port][priority] += toHeadroom;
+        m_headroomPeak[port][priority] = std::max(m_headroomPeak[port][priority], m_headroomBuf[port][priority]);
+        m_sharedUsed += pSize - toHeadroom;
+        m_sharedUsedPeak = std::max(m_sharedUsedPeak, m_sharedUsed);
+    }
     m_ingressBuf[port][priority] += pSize;
+    m_ingressPeak[port][priority] = std::max(m_ingressPeak[port][priority], m_ingressBuf[port][priority]);
 }
 
 void UbQueueManager::PopIngress(uint32_t port, uint32_t priority, uint32_t pSize)
 {
+    if (m_sharedBufferEnable) {
+        // 先释放headroom, 再释放共享池
+        uint64_t fromHeadroom = std::min<uint64_t>(m_headroomBuf[port][priority], pSize);
+        m_headroomBuf[port][priority] -= fromHeadroom;
+        m_sharedUsed -= pSize - fromHeadroom;
+    }
     m_ingressBuf[port][priority] -= pSize;
 }
 
@@ -148,20 +255,31 @@ uint64_t UbQueueManager::GetEgressUsed(uint32_t port, uint32_t priority)
 
 uint64_t UbQueueManager::GetAllEgressUsed(uint32_t port)
 {
-    uint64_t sum = 0;
-    for (uint32_t i = 0; i < m_vlNum; i++) {
-        sum += m_egressBuf[port][i];
-    }
-    return sum;
+    return m_egressPortBuf[port];
 }
 
 void UbQueueManager::PushEgress(uint32_t port, uint32_t priority, uint32_t pSize)
 {
     m_egressBuf[port][priority] += pSize;
+    m_egressPortBuf[port] += pSize;
 }
 
 void UbQueueManager::PopEgress(uint32_t port, uint32_t priority, uint32_t pSize)
 {
     m_egressBuf[port][priority] -= pSize;
+    m_egressPortBuf[port] -= pSize;
+}
+
+bool UbQueueManager::CheckEcnMark(uint32_t port, uint32_t priority)
+{
+    uint64_t qLen = m_egressBuf[port][priority];
+    if (qLen <= m_ecnKMin) {
+        return false;
+    }
+    if (qLen >= m_ecnKMax) {
+        return true;
+    }
+    double p = m_ecnPMax * (qLen - m_ecnKMin) / (m_ecnKMax - m_ecnKMin);
+    return m_ecnRandom->GetValue() < p;
 }
 } // namespace ns3
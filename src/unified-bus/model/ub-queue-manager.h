@@ -4,6 +4,8 @@
 
 #include "ns3/object.h"
 #include "ns3/packet.h"
+#include "ns3/random-variable-stream.h"
+#include "ns3/traced-callback.h"
 #include "ub-network-address.h"
 
 namespace ns3 {
@@ -99,14 +101,50 @@ public:
     void PopIngress(uint32_t port, uint32_t priority, uint32_t pSize);
     void PopEgress(uint32_t port, uint32_t priority, uint32_t pSize);
     void SetBufferSize(uint32_t size);
+    // 根据出口队列占用判断是否对报文做ECN标记(RED)
+    bool CheckEcnMark(uint32_t port, uint32_t priority);
+
+    // 共享缓存模式
+    bool IsSharedBufferEnable() { return m_sharedBufferEnable; }
+    // 动态门限: alpha * 共享池剩余空间
+    uint64_t GetDynamicThreshold();
+    // 入口队列占用的共享池部分(不含headroom)
+    uint64_t GetIngressSharedUsed(uint32_t port, uint32_t priority);
+    uint64_t GetSharedUsed() { return m_sharedUsed; }
+    uint64_t GetSharedUsedPeak() { return m_sharedUsedPeak; }
+    uint64_t GetIngressPeak(uint32_t port, uint32_t priority) { return m_ingressPeak[port][priority]; }
+    uint64_t GetHeadroomUsed(uint32_t port, uint32_t priority) { return m_headroomBuf[port][priority]; }
+    uint64_t GetHeadroomPeak(uint32_t port, uint32_t priority) { return m_headroomPeak[port][priority]; }
+    uint64_t GetDropCount(uint32_t port, uint32_t priority) { return m_dropCnt[port][priority]; }
 
 private:
+    bool CheckSharedAdmission(uint32_t port, uint32_t priority, uint32_t pSize);
+
     using DarrayU64 = std::vector<std::vector<uint64_t>>;
     uint32_t m_vlNum = 0;
     uint32_t m_portsNum = 0;
     uint32_t m_bufferSize;
     DarrayU64 m_ingressBuf;    // 入口缓存
     DarrayU64 m_egressBuf;    // 出口缓存
+    std::vector<uint64_t> m_egressPortBuf;    // 出口缓存按端口聚合
+
+    // 共享缓存：交换机全局共享池 + 每(port, priority)的PFC headroom
+    bool m_sharedBufferEnable;
+    uint64_t m_sharedBufferSize;
+    double m_dtAlpha;
+    uint32_t m_headroomSize;
+    uint64_t m_sharedUsed = 0;
+    uint64_t m_sharedUsedPeak = 0;
+    DarrayU64 m_headroomBuf;    // headroom占用
+    DarrayU64 m_ingressPeak;
+    DarrayU64 m_headroomPeak;
+    DarrayU64 m_dropCnt;
+    TracedCallback<uint32_t, uint32_t, uint32_t> m_traceBufferDrop;    // port, priority, size
+    // ECN标记门限：占用 < Kmin不标记，> Kmax必标记，之间按Pmax线性概率标记
+    uint32_t m_ecnKMin;
+    uint32_t m_ecnKMax;
+    double m_ecnPMax;
+    Ptr<UniformRandomVariable> m_ecnRandom;
 };
 } // namespace ns3
 
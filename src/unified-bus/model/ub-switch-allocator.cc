@@ -4,10 +4,17 @@
 #include "ns3/ub-port.h"
 #include "protocol/ub-routing-process.h"
 #include "ub-queue-manager.h"
+#include "ns3/string.h"
+#include "ns3/uinteger.h"
+#include "ns3/boolean.h"
+#include <sstream>
 
 namespace ns3 {
 
 NS_OBJECT_ENSURE_REGISTERED(UbSwitchAllocator);
+NS_OBJECT_ENSURE_REGISTERED(UbRoundRobinAllocator);
+NS_OBJECT_ENSURE_REGISTERED(UbDwrrAllocator);
+NS_OBJECT_ENSURE_REGISTERED(UbIslipAllocator);
 NS_LOG_COMPONENT_DEFINE("UbSwitchAllocator");
 
 TypeId UbSwitchAllocator::GetTypeId(void)
@@ -76,6 +83,7 @@ void UbRoundRobinAllocator::Init()
     auto node = NodeList::GetNode(m_nodeId);
     uint32_t portsNum = node->GetNDevices();
     auto vlNum = node->GetObject<UbSwitch>()->GetVLNum();
+    m_vlNum = vlNum;
     m_rrIdx.resize(portsNum);
     for (auto &v: m_rrIdx) {
         v.resize(vlNum, 0);
@@ -110,6 +118,13 @@ void UbRoundRobinAllocator::AllocateNextPacket(Ptr<UbPort> outPort)
     // 轮询调度
     NS_LOG_DEBUG("[UbRoundRobinAllocator AllocateNextPacket] portId: " << outPort->GetIfIndex());
     auto outPortId = outPort->GetIfIndex();
+    // eq满时停止授权, 报文留在ingress queue中, 端口出队后重新触发
+    if (outPort->GetUbQueue()->IsFull()) {
+        outPort->GetUbQueue()->NotifyBackPressure();
+        m_isRunning[outPortId] = false;
+        m_oneMoreRound[outPortId] = false;
+        return;
+    }
     auto ingressQueue = SelectNextIngressQueue(outPort);
     // 调度得到的ingressqueue加入egressqueue
     if (ingressQueue != nullptr) {
@@ -133,25 +148,362 @@ void UbRoundRobinAllocator::AllocateNextPacket(Ptr<UbPort> outPort)
 
 Ptr<UbIngressQueue> UbRoundRobinAllocator::SelectNextIngressQueue(Ptr<UbPort> outPort)
 {
-    uint32_t idx;
-    uint32_t pi;
     uint32_t outPortId = outPort->GetIfIndex();
+    for (uint32_t pi = 0 ; pi < m_vlNum; pi++) {
+        int qidx = FindIngressQueueInVl(outPort, pi);
+        if (qidx >= 0) {
+            return GrantIngressQueue(outPortId, pi, qidx);
+        }
+    }
+    return nullptr;
+}
+
+int UbRoundRobinAllocator::FindIngressQueueInVl(Ptr<UbPort> outPort, uint32_t pi)
+{
+    uint32_t outPortId = outPort->GetIfIndex();
+    size_t qSize = m_igsrc[outPortId][pi].size();
+    for (uint32_t idx = 0; idx < qSize; idx++) {
+        auto qidx = (idx + m_rrIdx[outPortId][pi]) % qSize;
+        if (!m_igsrc[outPortId][pi][qidx]->IsEmpty() &&
+            !outPort->GetFlowControl()->IsFcLimited(m_igsrc[outPortId][pi][qidx])) {
+            return qidx;
+        }
+    }
+    return -1;
+}
+
+Ptr<UbIngressQueue> UbRoundRobinAllocator::GrantIngressQueue(uint32_t outPortId, uint32_t pi, uint32_t qidx)
+{
+    m_rrIdx[outPortId][pi] = (qidx + 1) % m_igsrc[outPortId][pi].size();
+    NS_LOG_DEBUG("[UbSwitchAllocator DispatchPacket] " << " NodeId: " << m_nodeId
+        << " PortId: " << outPortId << " vl: " << pi << " qidx: " << qidx);
+    return m_igsrc[outPortId][pi][qidx];
+}
+
+/*-----------------------------------------UbDwrrAllocator----------------------------------------------*/
+TypeId UbDwrrAllocator::GetTypeId(void)
+{
+    static TypeId tid = TypeId("ns3::UbDwrrAllocator")
+        .SetParent<UbRoundRobinAllocator>()
+        .AddConstructor<UbDwrrAllocator>()
+        .AddAttribute("VlWeights",
+                      "Comma separated DWRR weight of each VL, e.g. \"4,2,1\". Missing VLs use weight 1.",
+                      StringValue(""),
+                      MakeStringAccessor(&UbDwrrAllocator::m_vlWeightsStr),
+                      MakeStringChecker())
+        .AddAttribute("QuantumBytes",
+                      "Bytes credited to a VL of weight 1 per DWRR round.",
+                      UintegerValue(UB_MTU_BYTE),
+                      MakeUintegerAccessor(&UbDwrrAllocator::m_quantumBytes),
+                      MakeUintegerChecker<uint32_t>(1))
+        .AddAttribute("EnableStrictPriority",
+                      "Serve link control frames and StrictPriorityVl before DWRR VLs.",
+                      BooleanValue(false),
+                      MakeBooleanAccessor(&UbDwrrAllocator::m_strictPriorityEnable),
+                      MakeBooleanChecker())
+        .AddAttribute("StrictPriorityVl",
+                      "VL carrying ACK/control traffic in the strict priority class, out of range means none.",
+                      UintegerValue(UINT32_MAX),
+                      MakeUintegerAccessor(&UbDwrrAllocator::m_strictPriorityVl),
+                      MakeUintegerChecker<uint32_t>());
+    return tid;
+}
+
+void UbDwrrAllocator::Init()
+{
+    UbRoundRobinAllocator::Init();
+    uint32_t portsNum = m_igsrc.size();
+    ParseVlWeights();
+    m_curVl.resize(portsNum, 0);
+    m_quantumAdded.resize(portsNum, false);
+    m_deficit.resize(portsNum);
+    for (auto &d : m_deficit) {
+        d.resize(m_vlNum, 0);
+    }
+}
+
+void UbDwrrAllocator::ParseVlWeights()
+{
+    m_quantum.assign(m_vlNum, m_quantumBytes);
+    std::stringstream ss(m_vlWeightsStr);
+    std::string item;
+    uint32_t vl = 0;
+    while (std::getline(ss, item, ',') && vl < m_vlNum) {
+        size_t first = item.find_first_not_of(" \t");
+        if (first != std::string::npos) {
+            std::string digits = item.substr(first, item.find_last_not_of(" \t") - first + 1);
+            // 先校验再转换, 避免std::stoul对非法输入抛异常
+            NS_ASSERT_MSG(digits.size() <= 9 && digits.find_first_not_of("0123456789") == std::string::npos,
+                          "Invalid DWRR VL weight: \"" << item << "\" in VlWeights \"" << m_vlWeightsStr << "\"");
+            uint64_t weight = std::stoul(digits);
+            NS_ASSERT_MSG(weight > 0, "DWRR VL weight must be positive!");
+            NS_ASSERT_MSG(weight * m_quantumBytes <= UINT32_MAX, "DWRR VL weight " << weight << " is too large");
+            m_quantum[vl] = weight * m_quantumBytes;
+        }
+        vl++;
+    }
+}
+
+/**
+ * @brief 严格优先级类：同端口控制帧队列(VOQ且inport==outport)以及StrictPriorityVl
+ */
+Ptr<UbIngressQueue> UbDwrrAllocator::SelectStrictPriority(Ptr<UbPort> outPort)
+{
+    uint32_t outPortId = outPort->GetIfIndex();
+    for (uint32_t pi = 0; pi < m_vlNum; pi++) {
+        auto ctrlQ = m_igsrc[outPortId][pi].size() > outPortId ? m_igsrc[outPortId][pi][outPortId] : nullptr;
+        if (ctrlQ != nullptr && ctrlQ->GetIqType() == IngressQueueType::VOQ && !ctrlQ->IsEmpty()
+            && !outPort->GetFlowControl()->IsFcLimited(ctrlQ)) {
+            return GrantIngressQueue(outPortId, pi, outPortId);
+        }
+    }
+    if (m_strictPriorityVl < m_vlNum) {
+        int qidx = FindIngressQueueInVl(outPort, m_strictPriorityVl);
+        if (qidx >= 0) {
+            return GrantIngressQueue(outPortId, m_strictPriorityVl, qidx);
+        }
+    }
+    return nullptr;
+}
+
+/**
+ * @brief DWRR: 当前VL配额足够则继续服务，否则切换到下一个VL并补充配额。
+ * 空VL的赤字清零；配额不小于报文长度时每次调度至多访问m_vlNum + 1个VL。
+ */
+Ptr<UbIngressQueue> UbDwrrAllocator::SelectNextIngressQueue(Ptr<UbPort> outPort)
+{
+    uint32_t outPortId = outPort->GetIfIndex();
+    if (m_strictPriorityEnable) {
+        auto igq = SelectStrictPriority(outPort);
+        if (igq != nullptr) {
+            return igq;
+        }
+    }
+    uint32_t &vl = m_curVl[outPortId];
+    uint32_t visited = 0;
+    bool backlogged = false;
+    while (true) {
+        if (visited == m_vlNum) {
+            if (!backlogged) {
+                return nullptr;
+            }
+            visited = 0;
+            backlogged = false;
+        }
+        int qidx = -1;
+        if (!(m_strictPriorityEnable && vl == m_strictPriorityVl)) {
+            qidx = FindIngressQueueInVl(outPort, vl);
+        }
+        if (qidx < 0) {
+            m_deficit[outPortId][vl] = 0;
+        } else {
+            backlogged = true;
+            if (!m_quantumAdded[outPortId]) {
+                m_deficit[outPortId][vl] += m_quantum[vl];
+                m_quantumAdded[outPortId] = true;
+            }
+            int64_t pktSize = m_igsrc[outPortId][vl][qidx]->GetNextPacketSize();
+            if (pktSize <= m_deficit[outPortId][vl]) {
+                m_deficit[outPortId][vl] -= pktSize;
+                return GrantIngressQueue(outPortId, vl, qidx);
+            }
+        }
+        vl = (vl + 1) % m_vlNum;
+        m_quantumAdded[outPortId] = false;
+        visited++;
+    }
+}
+
+/*-----------------------------------------UbIslipAllocator----------------------------------------------*/
+TypeId UbIslipAllocator::GetTypeId(void)
+{
+    static TypeId tid = TypeId("ns3::UbIslipAllocator")
+        .SetParent<UbSwitchAllocator>()
+        .AddConstructor<UbIslipAllocator>()
+        .AddAttribute("Iterations",
+                      "Request/grant/accept iterations of one iSLIP matching.",
+                      UintegerValue(2),
+                      MakeUintegerAccessor(&UbIslipAllocator::m_iterations),
+                      MakeUintegerChecker<uint32_t>(1))
+        .AddAttribute("Speedup",
+                      "Matchings per allocation cycle, i.e. packets an input/output may get per cycle.",
+                      UintegerValue(2),
+                      MakeUintegerAccessor(&UbIslipAllocator::m_speedup),
+                      MakeUintegerChecker<uint32_t>(1))
+        .AddAttribute("EgressQueueDepth",
+                      "Packets kept in the egress queue ahead of the transmitter.",
+                      UintegerValue(4),
+                      MakeUintegerAccessor(&UbIslipAllocator::m_egressQueueDepth),
+                      MakeUintegerChecker<uint32_t>(1));
+    return tid;
+}
+
+void UbIslipAllocator::Init()
+{
     auto node = NodeList::GetNode(m_nodeId);
-    auto vlNum = node->GetObject<UbSwitch>()->GetVLNum();
-    for (pi = 0 ; pi < vlNum; pi++) {
-        size_t qSize = m_igsrc[outPortId][pi].size();
-        for (idx = 0; idx < qSize; idx++) {
-            auto qidx = (idx + m_rrIdx[outPortId][pi]) % qSize;
-            if (!m_igsrc[outPortId][pi][qidx]->IsEmpty() &&
-                !outPort->GetFlowControl()->IsFcLimited(m_igsrc[outPortId][pi][qidx])) {
-                m_rrIdx[outPortId][pi] = (qidx + 1) % qSize;
-                NS_LOG_DEBUG("[UbSwitchAllocator DispatchPacket] " << " NodeId: " << node->GetId()
-                << " PortId: " << outPortId <<" qidx: "<< qidx);
-                return m_igsrc[outPortId][pi][qidx];
+    m_portsNum = node->GetNDevices();
+    m_vlNum = node->GetObject<UbSwitch>()->GetVLNum();
+    m_igsrc.resize(m_portsNum);
+    for (auto &i : m_igsrc) {
+        i.resize(m_vlNum);
+    }
+    m_rrIdx.resize(m_portsNum);
+    for (auto &v : m_rrIdx) {
+        v.resize(m_vlNum, 0);
+    }
+    m_grantPtr.resize(m_portsNum, 0);
+    m_acceptPtr.resize(m_portsNum * 2, 0);
+}
+
+void UbIslipAllocator::DoDispose()
+{
+    m_cycleEvent.Cancel();
+    UbSwitchAllocator::DoDispose();
+}
+
+void UbIslipAllocator::TriggerAllocator(Ptr<UbPort> outPort)
+{
+    NS_LOG_DEBUG("[UbIslipAllocator TriggerAllocator] portId: " << outPort->GetIfIndex());
+    if (m_cycleEvent.IsPending()) {
+        return;
+    }
+    m_cycleEvent = Simulator::Schedule(m_allocationTime, &UbIslipAllocator::RunCycle, this);
+}
+
+uint32_t UbIslipAllocator::GetInputId(Ptr<UbIngressQueue> igq, uint32_t outPortId)
+{
+    uint32_t inPortId = igq->GetInPortId();
+    return inPortId == outPortId ? m_portsNum + outPortId : inPortId;
+}
+
+/**
+ * @brief 授权阶段：取最高优先级(VL号最小)有请求的VL，按授权指针选择输入
+ */
+bool UbIslipAllocator::SelectRequest(Ptr<UbPort> outPort, std::vector<bool> &inputMatched, IslipRequest &req)
+{
+    uint32_t outPortId = outPort->GetIfIndex();
+    uint32_t inputsNum = m_portsNum * 2;
+    for (uint32_t pi = 0; pi < m_vlNum; pi++) {
+        auto &queues = m_igsrc[outPortId][pi];
+        size_t qSize = queues.size();
+        uint32_t bestDist = UINT32_MAX;
+        for (uint32_t idx = 0; idx < qSize; idx++) {
+            uint32_t qidx = (idx + m_rrIdx[outPortId][pi]) % qSize;
+            auto igq = queues[qidx];
+            uint32_t inputId = GetInputId(igq, outPortId);
+            if (inputMatched[inputId] || igq->IsEmpty() || outPort->GetFlowControl()->IsFcLimited(igq)) {
+                continue;
+            }
+            uint32_t dist = (inputId + inputsNum - m_grantPtr[outPortId]) % inputsNum;
+            if (dist < bestDist) {
+                bestDist = dist;
+                req.igq = igq;
+                req.inputId = inputId;
+                req.priority = pi;
+                req.qidx = qidx;
             }
         }
+        if (bestDist != UINT32_MAX) {
+            return true;
+        }
+    }
+    return false;
+}
+
+std::vector<std::pair<uint32_t, UbIslipAllocator::IslipRequest> > UbIslipAllocator::Match(
+    std::vector<Ptr<UbPort> > &ports)
+{
+    uint32_t inputsNum = m_portsNum * 2;
+    std::vector<bool> outputMatched(m_portsNum, false);
+    std::vector<bool> inputMatched(inputsNum, false);
+    std::vector<std::pair<uint32_t, IslipRequest> > matches;
+    for (uint32_t it = 0; it < m_iterations; it++) {
+        // 请求+授权: 每个未匹配出端口授权一个输入
+        std::vector<std::vector<std::pair<uint32_t, IslipRequest> > > grants(inputsNum);
+        bool anyGrant = false;
+        for (uint32_t out = 0; out < m_portsNum; out++) {
+            IslipRequest req;
+            if (outputMatched[out] || ports[out] == nullptr || !SelectRequest(ports[out], inputMatched, req)) {
+                continue;
+            }
+            grants[req.inputId].emplace_back(out, req);
+            anyGrant = true;
+        }
+        if (!anyGrant) {
+            break;
+        }
+        // 接受: 每个输入按接受指针接受一个授权, 仅第一次迭代更新指针
+        for (uint32_t in = 0; in < inputsNum; in++) {
+            if (grants[in].empty()) {
+                continue;
+            }
+            uint32_t bestDist = UINT32_MAX;
+            size_t best = 0;
+            for (size_t g = 0; g < grants[in].size(); g++) {
+                uint32_t dist = (grants[in][g].first + m_portsNum - m_acceptPtr[in]) % m_portsNum;
+                if (dist < bestDist) {
+                    bestDist = dist;
+                    best = g;
+                }
+            }
+            uint32_t out = grants[in][best].first;
+            outputMatched[out] = true;
+            inputMatched[in] = true;
+            if (it == 0) {
+                m_grantPtr[out] = (in + 1) % inputsNum;
+                m_acceptPtr[in] = (out + 1) % m_portsNum;
+            }
+            matches.push_back(grants[in][best]);
+        }
+    }
+    return matches;
+}
+
+void UbIslipAllocator::RunCycle()
+{
+    auto node = NodeList::GetNode(m_nodeId);
+    std::vector<Ptr<UbPort> > ports(m_portsNum);
+    std::vector<bool> enqueued(m_portsNum, false);
+    bool pending = false;
+    for (uint32_t s = 0; s < m_speedup; s++) {
+        for (uint32_t out = 0; out < m_portsNum; out++) {
+            auto port = DynamicCast<UbPort>(node->GetDevice(out));
+            if (port->GetUbQueue()->IsFull()) {
+                // eq字节/包数已满, 反压分配器, 端口出队后重新触发调度
+                port->GetUbQueue()->NotifyBackPressure();
+                ports[out] = nullptr;
+            } else if (port->GetUbQueue()->GetSize() >= m_egressQueueDepth) {
+                // 达到预取深度, 等待发送器消耗后继续调度
+                ports[out] = nullptr;
+                pending = true;
+            } else {
+                ports[out] = port;
+            }
+        }
+        auto matches = Match(ports);
+        if (matches.empty()) {
+            break;
+        }
+        pending = true;
+        for (auto &[out, req] : matches) {
+            auto packet = req.igq->GetNextPacket();
+            auto packetEntry = std::make_tuple(req.igq->GetInPortId(), req.priority, packet);
+            ports[out]->GetFlowControl()->HandleSentPacket(packet, req.igq);
+            ports[out]->GetUbQueue()->DoEnqueue(packetEntry);
+            m_rrIdx[out][req.priority] = (req.qidx + 1) % m_igsrc[out][req.priority].size();
+            enqueued[out] = true;
+            NS_LOG_DEBUG("[UbIslipAllocator RunCycle] NodeId: " << m_nodeId << " PortId: " << out
+                << " input: " << req.inputId << " vl: " << req.priority);
+        }
+    }
+    for (uint32_t out = 0; out < m_portsNum; out++) {
+        if (enqueued[out]) {
+            Simulator::ScheduleNow(&UbPort::NotifyAllocationFinish, DynamicCast<UbPort>(node->GetDevice(out)));
+        }
+    }
+    if (pending) {
+        m_cycleEvent = Simulator::Schedule(m_allocationTime, &UbIslipAllocator::RunCycle, this);
     }
-    return nullptr;
 }
 
 } // namespae ns3
@@ -3,10 +3,12 @@
 #define UB_UBSWITCH_ALLOCATOR_H
 
 #include <vector>
+#include <string>
 #include <unordered_map>
 #include "ns3/object.h"
 #include "ns3/nstime.h"
 #include "ns3/node.h"
+#include "ns3/event-id.h"
 
 namespace ns3 {
 
@@ -54,15 +56,92 @@ public:
 
     virtual void TriggerAllocator(Ptr<UbPort> outPort) override;
     virtual void Init() override;
-    Ptr<UbIngressQueue> SelectNextIngressQueue(Ptr<UbPort> outPort);
+    virtual Ptr<UbIngressQueue> SelectNextIngressQueue(Ptr<UbPort> outPort);
     void AllocateNextPacket(Ptr<UbPort> outPort);
 
-private:
+protected:
+    // 在一个VL内按轮询顺序查找可调度的队列，返回队列下标，没有则返回-1，不更新轮询指针
+    int FindIngressQueueInVl(Ptr<UbPort> outPort, uint32_t pi);
+    Ptr<UbIngressQueue> GrantIngressQueue(uint32_t outPortId, uint32_t pi, uint32_t qidx);
+
+    uint32_t m_vlNum = 0;
     std::vector<std::vector<uint32_t> > m_rrIdx;
+
+private:
     std::vector<bool> m_isRunning;
     std::vector<bool> m_oneMoreRound;
 };
 
+/**
+ * @brief VL间按赤字加权轮询(DWRR)调度，VL内轮询各输入队列。
+ * 可选严格优先级类：链路控制帧以及StrictPriorityVl上的报文(如ACK)优先调度。
+ */
+class UbDwrrAllocator : public UbRoundRobinAllocator {
+public:
+    UbDwrrAllocator() {}
+    virtual ~UbDwrrAllocator() {}
+    static TypeId GetTypeId(void);
+
+    virtual void Init() override;
+    virtual Ptr<UbIngressQueue> SelectNextIngressQueue(Ptr<UbPort> outPort) override;
+
+private:
+    Ptr<UbIngressQueue> SelectStrictPriority(Ptr<UbPort> outPort);
+    void ParseVlWeights();
+
+    std::string m_vlWeightsStr;                     // 各VL权重, 逗号分隔, 缺省为1
+    uint32_t m_quantumBytes;                        // 权重为1时每轮的字节配额
+    bool m_strictPriorityEnable;
+    uint32_t m_strictPriorityVl;                    // 严格优先级VL, 超出VL数量时不使用
+
+    std::vector<uint32_t> m_quantum;                // [vl]
+    std::vector<uint32_t> m_curVl;                  // [outPort] 当前服务的VL
+    std::vector<bool> m_quantumAdded;               // [outPort] 当前VL本轮是否已补充配额
+    std::vector<std::vector<int64_t> > m_deficit;   // [outPort][vl]
+};
+
+/**
+ * @brief iSLIP请求/授权/接受匹配的交换机调度器。
+ * 每个调度周期对所有出端口统一匹配，内部加速比Speedup表示每周期至多匹配的轮数，
+ * 每轮每个输入/输出至多匹配一个包；出端口eq保持EgressQueueDepth个包，发送器无需等待调度。
+ * 本地注入的队列(tp/控制帧, inport==outport)视为该出端口独立的虚拟输入。
+ */
+class UbIslipAllocator : public UbSwitchAllocator {
+public:
+    UbIslipAllocator() {}
+    virtual ~UbIslipAllocator() {}
+    static TypeId GetTypeId(void);
+
+    virtual void TriggerAllocator(Ptr<UbPort> outPort) override;
+    virtual void Init() override;
+    void DoDispose() override;
+
+private:
+    struct IslipRequest {
+        Ptr<UbIngressQueue> igq = nullptr;
+        uint32_t inputId = 0;
+        uint32_t priority = 0;
+        uint32_t qidx = 0;
+    };
+
+    void RunCycle();
+    // 一轮iSLIP匹配，返回匹配结果[outPort] -> request
+    std::vector<std::pair<uint32_t, IslipRequest> > Match(std::vector<Ptr<UbPort> > &ports);
+    bool SelectRequest(Ptr<UbPort> outPort, std::vector<bool> &inputMatched, IslipRequest &req);
+    uint32_t GetInputId(Ptr<UbIngressQueue> igq, uint32_t outPortId);
+
+    uint32_t m_iterations;                          // 每轮匹配的iSLIP迭代次数
+    uint32_t m_speedup;                             // 每周期匹配轮数
+    uint32_t m_egressQueueDepth;                    // 出端口eq预取深度
+
+    uint32_t m_portsNum = 0;
+    uint32_t m_vlNum = 0;
+    std::vector<uint32_t> m_grantPtr;               // [outPort] 授权指针(输入号)
+    std::vector<uint32_t> m_acceptPtr;              // [input] 接受指针(出端口号)
+    std::vector<std::vector<uint32_t> > m_rrIdx;    // [outPort][vl] 同一输入多个队列时的轮询指针
+    EventId m_cycleEvent;
+};
+
 } /* namespace ns3 */
 
 #endif /* UB_UbSwitchAllocator_H */
\ No newline at end of file
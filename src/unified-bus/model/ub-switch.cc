@@ -7,6 +7,7 @@
 #include "ns3/ub-caqm.h"
 #include "ns3/ub-port.h"
 #include "ns3/ub-switch.h"
+#include "ns3/ub-tag.h"
 
 namespace ns3 {
 NS_OBJECT_ENSURE_REGISTERED(UbSwitch);
@@ -31,6 +32,43 @@ TypeId UbSwitch::GetTypeId (void)
                       BooleanValue(false),
                       MakeBooleanAccessor(&UbSwitch::m_isPFCEnable),
                       MakeBooleanChecker())
+        .AddAttribute("EnableECN",
+                      "Enable ECN marking at egress by queue occupancy.",
+                      BooleanValue(false),
+                      MakeBooleanAccessor(&UbSwitch::m_isECNEnable),
+                      MakeBooleanChecker())
+        .AddAttribute("EnableCutThrough",
+                      "Enable cut-through forwarding, packet is forwarded once its header arrives.",
+                      BooleanValue(false),
+                      MakeBooleanAccessor(&UbSwitch::m_isCutThroughEnable),
+                      MakeBooleanChecker())
+        .AddAttribute("CutThroughHeaderSize",
+                      "Bytes that must arrive before a cut-through forwarding decision can be made.",
+                      UintegerValue(64),
+                      MakeUintegerAccessor(&UbSwitch::m_cutThroughHeaderSize),
+                      MakeUintegerChecker<uint32_t>(1))
+        .AddAttribute("AllocatorType",
+                      "Egress arbitration algorithm: RoundRobin (strict VL priority), Dwrr or Islip.",
+                      EnumValue(UbAllocatorType::ROUND_ROBIN),
+                      MakeEnumAccessor<UbAllocatorType>(&UbSwitch::m_allocatorType),
+                      MakeEnumChecker(UbAllocatorType::ROUND_ROBIN, "RoundRobin",
+                                      UbAllocatorType::DWRR, "Dwrr",
+                                      UbAllocatorType::ISLIP, "Islip"))
+        .AddAttribute("HostDie",
+                      "Die hosting the local endpoints (TP/LDST) of a multi-die node.",
+                      UintegerValue(0),
+                      MakeUintegerAccessor(&UbSwitch::m_hostDie),
+                      MakeUintegerChecker<uint32_t>())
+        .AddAttribute("DieLinkDataRate",
+                      "Bandwidth of each direction of the die-to-die link in a multi-die node.",
+                      DataRateValue(DataRate("800Gbps")),
+                      MakeDataRateAccessor(&UbSwitch::m_dieLinkRate),
+                      MakeDataRateChecker())
+        .AddAttribute("DieLinkDelay",
+                      "Latency of the die-to-die link in a multi-die node.",
+                      TimeValue(NanoSeconds(10)),
+                      MakeTimeAccessor(&UbSwitch::m_dieLinkDelay),
+                      MakeTimeChecker())
         .AddTraceSource("LastPacketTraversesNotify",
                         "Last Packet Traverses, NodeId",
                         MakeTraceSourceAccessor(&UbSwitch::m_traceLastPacketTraversesNotify),
@@ -44,10 +82,34 @@ void UbSwitch::Init()
 {
     auto node = GetObject<Node>();
     m_portsNum = node->GetNDevices();
-    // alg init
-    m_allocator = CreateObject<UbRoundRobinAllocator>();
-    m_allocator->SetNodeId(node->GetId());
-    m_allocator->Init();
+    // die init
+    if (m_portDie.size() != m_portsNum) {
+        m_portDie.resize(m_portsNum);
+        for (uint32_t pidx = 0; pidx < m_portsNum; pidx++) {
+            m_portDie[pidx] = pidx * m_dieNum / m_portsNum;
+        }
+    }
+    NS_ASSERT_MSG(m_hostDie < m_dieNum, "HostDie out of range! NodeId: " << node->GetId());
+    m_dieLinkBusyUntil.assign(m_dieNum * m_dieNum, Seconds(0));
+    // alg init, 每个die独立调度
+    m_allocators.clear();
+    for (uint32_t die = 0; die < m_dieNum; die++) {
+        Ptr<UbSwitchAllocator> allocator;
+        switch (m_allocatorType) {
+            case UbAllocatorType::DWRR:
+                allocator = CreateObject<UbDwrrAllocator>();
+                break;
+            case UbAllocatorType::ISLIP:
+                allocator = CreateObject<UbIslipAllocator>();
+                break;
+            default:
+                allocator = CreateObject<UbRoundRobinAllocator>();
+                break;
+        }
+        allocator->SetNodeId(node->GetId());
+        allocator->Init();
+        m_allocators.push_back(allocator);
+    }
     VoqInit();
     AddVoqIntoAlgroithm();
 
@@ -66,7 +128,7 @@ void UbSwitch::DoDispose()
 {
     m_queueManager = nullptr;
     m_congestionCtrl = nullptr;
-    m_allocator = nullptr;
+    m_allocators.clear();
     m_voq.clear();
     m_routingProcess = nullptr;
 }
@@ -100,7 +162,7 @@ void UbSwitch::AddVoqIntoAlgroithm()
         for (uint32_t j = 0; j < m_vlNum; j++) {
             for (uint32_t k = 0 ; k < m_portsNum; k++) { // voq
                 auto igq = m_voq[i][j][k];
-                m_allocator->RegisterUbIngressQueue(igq, i, j);
+                GetAllocator(i)->RegisterUbIngressQueue(igq, i, j);
             }
         }
     }
@@ -119,7 +181,7 @@ void UbSwitch::AddTpIntoAlgroithm(Ptr<UbIngressQueue> tp, uint32_t outPort, uint
     tp->SetOutPortId(outPort);
     tp->SetInPortId(outPort); // tp不使用inport
     tp->SetIgqPriority(priority);
-    m_allocator->RegisterUbIngressQueue(tp, outPort, priority);
+    GetAllocator(outPort)->RegisterUbIngressQueue(tp, outPort, priority);
 }
 
 UbSwitch::UbSwitch()
@@ -131,7 +193,59 @@ UbSwitch::~UbSwitch()
 
 Ptr<UbSwitchAllocator> UbSwitch::GetAllocator()
 {
-    return m_allocator;
+    return m_allocators.empty() ? nullptr : m_allocators[0];
+}
+
+/**
+ * @brief 获取出端口所在die的调度器
+ */
+Ptr<UbSwitchAllocator> UbSwitch::GetAllocator(uint32_t portId)
+{
+    return m_allocators[GetPortDie(portId)];
+}
+
+std::vector<Ptr<UbSwitchAllocator>> UbSwitch::GetAllocators()
+{
+    return m_allocators;
+}
+
+void UbSwitch::SetDies(uint32_t dieNum, const std::vector<uint32_t> &portDie)
+{
+    NS_ASSERT_MSG(dieNum > 0, "Die num must be positive!");
+    for (auto die : portDie) {
+        NS_ASSERT_MSG(die < dieNum, "Port die id out of range! die: " << die << " dieNum: " << dieNum);
+    }
+    m_dieNum = dieNum;
+    m_portDie = portDie;
+}
+
+uint32_t UbSwitch::GetPortDie(uint32_t portId)
+{
+    return portId < m_portDie.size() ? m_portDie[portId] : 0;
+}
+
+/**
+ * @brief 占用srcDie到dstDie的单向die间链路, 返回包尾到达dstDie的时刻
+ */
+Time UbSwitch::ReserveDieLink(uint32_t srcDie, uint32_t dstDie, uint32_t size, Time start)
+{
+    Time &busyUntil = m_dieLinkBusyUntil[srcDie * m_dieNum + dstDie];
+    busyUntil = Max(busyUntil, start) + m_dieLinkRate.CalculateBytesTxTime(size);
+    return busyUntil + m_dieLinkDelay;
+}
+
+/**
+ * @brief 本地报文由host die跨die送到出端口, 出端口发送时间不能早于包尾到达
+ */
+Time UbSwitch::GetLocalEgressDelay(uint32_t portId, Ptr<Packet> packet)
+{
+    uint32_t portDie = GetPortDie(portId);
+    // 控制帧由端口自身产生, 不跨die
+    if (portDie == m_hostDie || GetPacketType(packet) == UB_CONTROL_FRAME) {
+        return Seconds(0);
+    }
+    Time arrival = ReserveDieLink(m_hostDie, portDie, packet->GetSize(), Simulator::Now());
+    return arrival - Simulator::Now();
 }
 
 /**
@@ -182,7 +296,7 @@ UbPacketType_t UbSwitch::GetPacketType(Ptr<Packet> packet)
         return UB_CONTROL_FRAME;
     if (dlHeader.IsPacketIpv4Header())
         return UB_URMA_DATA_PACKET;
-    if (dlHeader.IsPacketUbMemHeader())
+    if (dlHeader.IsPacketUbMemHeader() || dlHeader.IsPacketUbMemCna24Header())
         return UB_LDST_DATA_PACKET;
     return UNKOWN_TYPE;
 }
@@ -196,6 +310,9 @@ void UbSwitch::SwitchHandlePacket(Ptr<UbPort> port, Ptr<Packet> packet)
     auto packetType = GetPacketType(packet);
     switch (packetType) {
         case UB_CONTROL_FRAME:
+            if (DeferToTailArrival(port, packet)) {
+                break;
+            }
             port->m_flowControl->HandleReceivedControlPacket(packet);
             break;
         case UB_URMA_DATA_PACKET:
@@ -278,7 +395,10 @@ bool UbSwitch::SinkTpDataPacket(Ptr<UbPort> port, Ptr<Packet> packet)
     if (!utils::IsInSameSubnet(m_ipv4Header.GetDestination(), GetNodIpv4Addr(), mask)) {
         return false;
     }
-    // Sink
+    // Sink, 直通模式下需等待包尾到达
+    if (DeferToTailArrival(port, packet) || DeferToHostDie(port, packet)) {
+        return true;
+    }
     NS_LOG_DEBUG("[UbPort recv] Pkt tb is local");
     if (IsCBFCEnable()) {
         port->m_flowControl->HandleReceivedPacket(packet);
@@ -295,6 +415,13 @@ bool UbSwitch::SinkTpDataPacket(Ptr<UbPort> port, Ptr<Packet> packet)
         packet->RemoveHeader(m_ipv4Header);
         packet->RemoveHeader(m_udpHeader);
         targetTp->RecvTpAck(packet);
+    } else if (m_ubTpHeader.GetTPOpcode() == static_cast<uint8_t>(TpOpcode::TP_OPCODE_CNP)) {
+        NS_LOG_DEBUG("[UbPort recv] is CNP");
+        packet->RemoveHeader(m_datalinkHeader);
+        packet->RemoveHeader(m_networkHeader);
+        packet->RemoveHeader(m_ipv4Header);
+        packet->RemoveHeader(m_udpHeader);
+        targetTp->RecvCnp(packet);
     } else {
         targetTp->RecvDataPacket(packet);
     }
@@ -309,13 +436,15 @@ bool UbSwitch::SinkMemDataPacket(Ptr<UbPort> port, Ptr<Packet> packet)
     // Store/load request: DLH cNTH cTAH(0x03/0x06) [cMAETAH] Payload
     // Store/load response: DLH cNTH cATAH(0x11/0x12) Payload
     NS_LOG_DEBUG("[UbPort recv] ub mem frame");
-    uint16_t dCna = m_memHeader.GetDcna();
-    uint32_t dnode = utils::Cna16ToNodeId(dCna);
+    uint32_t dnode = utils::CnaToNodeId(m_memDcna, m_isCna24Packet);
     // Forward
     if (dnode != GetObject<Node>()->GetId()) {
         return false;
     }
-    // Sink Packet
+    // Sink Packet, 直通模式下需等待包尾到达
+    if (DeferToTailArrival(port, packet) || DeferToHostDie(port, packet)) {
+        return true;
+    }
     if (IsCBFCEnable()) {
         port->m_flowControl->HandleReceivedPacket(packet);
     }
@@ -325,10 +454,13 @@ bool UbSwitch::SinkMemDataPacket(Ptr<UbPort> port, Ptr<Packet> packet)
 
     uint8_t type = m_dummyTaHeader.GetTaOpcode();
     // 数据包
-    if (type == (uint8_t)TaOpcode::TA_OPCODE_WRITE || type == (uint8_t)TaOpcode::TA_OPCODE_READ) {
+    if (type == (uint8_t)TaOpcode::TA_OPCODE_WRITE || type == (uint8_t)TaOpcode::TA_OPCODE_READ ||
+        type == (uint8_t)TaOpcode::TA_OPCODE_SNOOP_INVALIDATE || type == (uint8_t)TaOpcode::TA_OPCODE_SNOOP_DOWNGRADE ||
+        type == (uint8_t)TaOpcode::TA_OPCODE_WRITEBACK_FULL) {
         ldstApi->RecvDataPacket(packet);
     } else if (type == (uint8_t)TaOpcode::TA_OPCODE_TRANSACTION_ACK ||
-               type == (uint8_t)TaOpcode::TA_OPCODE_READ_RESPONSE) {
+               type == (uint8_t)TaOpcode::TA_OPCODE_READ_RESPONSE ||
+               type == (uint8_t)TaOpcode::TA_OPCODE_SNOOP_ACK) {
         ldstApi->RecvResponse(packet);
         NS_LOG_DEBUG("mem packet is ack!");
     } else {
@@ -360,7 +492,11 @@ void UbSwitch::ForwardDataPacket(Ptr<UbPort> port, Ptr<Packet> packet)
             NS_ASSERT_MSG(0, "Invalid Packet Type! ");
     }
     /* 路由 */
-    outPort = m_routingProcess->GetOutPort(rtKey, port->GetIfIndex());
+    if (m_routingProcess->IsAdaptiveRoutingEnabled()) {
+        outPort = m_routingProcess->GetOutPort(rtKey, m_queueManager, GetObject<Node>(), port->GetIfIndex());
+    } else {
+        outPort = m_routingProcess->GetOutPort(rtKey, port->GetIfIndex());
+    }
     if (outPort < 0) {
         // Route failed
         NS_LOG_WARN("The route cannot be found. Packet Dropped!");
@@ -378,9 +514,104 @@ void UbSwitch::ForwardDataPacket(Ptr<UbPort> port, Ptr<Packet> packet)
         NS_LOG_WARN("Ingress memory not enough. Packet Dropped!");
         return;
     }
+    // 包头到达即占用入端口缓存, 延迟转发期间同样计入
+    m_queueManager->PushIngress(inPort, priority, packet->GetSize());
+    /* 跨die转发: 包尾到达后经die间链路送到出端口所在die */
+    uint32_t inDie = GetPortDie(inPort);
+    uint32_t outDie = GetPortDie(outPort);
+    if (inDie != outDie) {
+        Time start = Simulator::Now();
+        UbTimestampTag tailTag;
+        if (packet->RemovePacketTag(tailTag)) {
+            start = Max(start, tailTag.GetTime());
+        }
+        Time arrival = ReserveDieLink(inDie, outDie, packet->GetSize(), start);
+        NS_LOG_DEBUG("[UbSwitch die crossing] Node:" << GetObject<Node>()->GetId() << " die " << inDie
+                  << " -> " << outDie << " arrival:" << arrival << " PacketUid: " << packet->GetUid());
+        Simulator::Schedule(arrival - Simulator::Now(), &UbSwitch::SendPacket,
+                            this, packet, inPort, outPort, priority);
+        return;
+    }
+    /* 直通转发: 出端口空闲时立即转发, 否则等包尾到达后按存储转发处理 */
+    UbTimestampTag ctTag;
+    if (packet->PeekPacketTag(ctTag)) {
+        Time tailArrival = ctTag.GetTime();
+        if (tailArrival > Simulator::Now() && !CanCutThrough(port, outPort)) {
+            NS_LOG_DEBUG("[UbSwitch cut-through] Node:" << GetObject<Node>()->GetId()
+                      << " outPort:" << outPort << " busy, store and forward"
+                      << " PacketUid: " << packet->GetUid());
+            packet->RemovePacketTag(ctTag);
+            Simulator::Schedule(tailArrival - Simulator::Now(), &UbSwitch::SendPacket,
+                                this, packet, inPort, outPort, priority);
+            return;
+        }
+    }
     SendPacket(packet, inPort, outPort, priority);
 }
 
+/**
+ * @brief Cut-through is only allowed when the out port can start sending at once
+ * and is not faster than the in port, otherwise egress would underrun.
+ */
+bool UbSwitch::CanCutThrough(Ptr<UbPort> port, uint32_t outPort)
+{
+    Ptr<UbPort> sendPort = DynamicCast<ns3::UbPort>(GetObject<Node>()->GetDevice(outPort));
+    if (!sendPort->IsReady() || !sendPort->GetUbQueue()->IsEmpty()) {
+        return false;
+    }
+    if (m_queueManager->GetAllEgressUsed(outPort) != 0) {
+        return false;
+    }
+    return sendPort->GetDataRate() <= port->GetDataRate();
+}
+
+/**
+ * @brief Packet delivered at header arrival by cut-through must not be consumed locally
+ * before its tail arrives. Return true if the handling is deferred.
+ */
+bool UbSwitch::DeferToTailArrival(Ptr<UbPort> port, Ptr<Packet> packet)
+{
+    UbTimestampTag ctTag;
+    if (!packet->PeekPacketTag(ctTag) || ctTag.GetType() != UbTimestampType::TAIL_ARRIVAL) {
+        return false;
+    }
+    packet->RemovePacketTag(ctTag);
+    Time tailArrival = ctTag.GetTime();
+    if (tailArrival <= Simulator::Now()) {
+        return false;
+    }
+    Simulator::Schedule(tailArrival - Simulator::Now(), &UbSwitch::SwitchHandlePacket, this, port, packet);
+    return true;
+}
+
+/**
+ * @brief Packet received on a die other than the host die crosses the die-to-die link
+ * before it is consumed locally. Return true if the handling is deferred.
+ */
+bool UbSwitch::DeferToHostDie(Ptr<UbPort> port, Ptr<Packet> packet)
+{
+    uint32_t portDie = GetPortDie(port->GetIfIndex());
+    if (portDie == m_hostDie) {
+        return false;
+    }
+    UbDatalinkPacketHeader dlHeader;
+    packet->PeekHeader(dlHeader);
+    uint32_t inPort = port->GetIfIndex();
+    uint8_t priority = dlHeader.GetPacketVL();
+    UbTimestampTag dieTag;
+    if (packet->PeekPacketTag(dieTag) && dieTag.GetType() == UbTimestampType::DIE_ARRIVAL) {
+        // 已到达host die, 释放跨die期间占用的入端口缓存
+        packet->RemovePacketTag(dieTag);
+        m_queueManager->PopIngress(inPort, priority, packet->GetSize());
+        return false;
+    }
+    Time arrival = ReserveDieLink(portDie, m_hostDie, packet->GetSize(), Simulator::Now());
+    m_queueManager->PushIngress(inPort, priority, packet->GetSize());
+    packet->AddPacketTag(UbTimestampTag(UbTimestampType::DIE_ARRIVAL, arrival));
+    Simulator::Schedule(arrival - Simulator::Now(), &UbSwitch::SwitchHandlePacket, this, port, packet);
+    return true;
+}
+
 void UbSwitch::ChangePakcetRoutingPolicy(Ptr<Packet> packet, bool useShortestPath)
 {
     UbDatalinkPacketHeader tempHeader;
@@ -409,9 +640,22 @@ void UbSwitch::ParseURMAPacketHeader(Ptr<Packet> packet)
 void UbSwitch::ParseLdstPacketHeader(Ptr<Packet> packet)
 {
     packet->RemoveHeader(m_datalinkHeader);
-    packet->RemoveHeader(m_memHeader);
-    packet->PeekHeader(m_dummyTaHeader);
-    packet->AddHeader(m_memHeader);
+    m_isCna24Packet = m_datalinkHeader.GetConfig() == static_cast<uint8_t>(UbDatalinkHeaderConfig::PACKET_CNA24);
+    if (m_isCna24Packet) {
+        packet->RemoveHeader(m_mem24Header);
+        packet->PeekHeader(m_dummyTaHeader);
+        packet->AddHeader(m_mem24Header);
+        m_memScna = m_mem24Header.GetScna();
+        m_memDcna = m_mem24Header.GetDcna();
+        m_memLb = m_mem24Header.GetLb();
+    } else {
+        packet->RemoveHeader(m_memHeader);
+        packet->PeekHeader(m_dummyTaHeader);
+        packet->AddHeader(m_memHeader);
+        m_memScna = m_memHeader.GetScna();
+        m_memDcna = m_memHeader.GetDcna();
+        m_memLb = m_memHeader.GetLb();
+    }
     packet->AddHeader(m_datalinkHeader);
 }
 
@@ -428,13 +672,11 @@ void UbSwitch::GetURMARoutingKey(Ptr<Packet> packet, RoutingKey &rtKey)
 
 void UbSwitch::GetLdstRoutingKey(Ptr<Packet> packet, RoutingKey &rtKey)
 {
-    uint16_t dCna = m_memHeader.GetDcna();
-    uint16_t sCna = m_memHeader.GetScna();
-    uint32_t snode = utils::Cna16ToNodeId(sCna);
-    uint32_t dnode = utils::Cna16ToNodeId(dCna);
-    uint16_t sport = utils::Cna16ToPortId(sCna);
+    uint32_t snode = utils::CnaToNodeId(m_memScna, m_isCna24Packet);
+    uint32_t dnode = utils::CnaToNodeId(m_memDcna, m_isCna24Packet);
+    uint16_t sport = utils::CnaToPortId(m_memScna, m_isCna24Packet);
     uint16_t dport = 0;
-    uint16_t lb = m_memHeader.GetLb();
+    uint16_t lb = m_memLb;
     rtKey.sip = utils::NodeIdToIp(snode, sport).Get();
     rtKey.dip = utils::NodeIdToIp(dnode, dport).Get();
     rtKey.sport = lb;
@@ -452,7 +694,6 @@ void UbSwitch::SendPacket(Ptr<Packet> packet, uint32_t inPort, uint32_t outPort,
     auto node = GetObject<Node>();
     Ptr<UbPort> recvPort = DynamicCast<ns3::UbPort>(node->GetDevice(inPort));
     m_voq[outPort][priority][inPort]->Push(packet);
-    m_queueManager->PushIngress(inPort, priority, packet->GetSize());
     if (IsPFCEnable()) {
         recvPort->m_flowControl->HandleReceivedPacket(packet);
     }
@@ -473,11 +714,40 @@ void UbSwitch::NotifySwitchDequeue(uint16_t inPortId, uint32_t outPort, uint32_t
         NS_LOG_DEBUG("[QMU] Node:" << GetObject<Node>()->GetId()
               << " port:" << outPort
               << " egress size:" << m_queueManager->GetAllEgressUsed(outPort));
+        if (m_isECNEnable) {
+            EcnMarkPacket(outPort, priority, packet);
+        }
         m_congestionCtrl->SwitchForwardPacket(inPortId, outPort, packet);
         m_queueManager->PopIngress(inPortId, priority, packet->GetSize());
     }
 }
 
+/**
+ * @brief Mark FECN of ECN capable URMA packet by egress occupancy
+ */
+void UbSwitch::EcnMarkPacket(uint32_t outPort, uint32_t priority, Ptr<Packet> packet)
+{
+    UbDatalinkHeader dlHeader;
+    packet->PeekHeader(dlHeader);
+    if (!dlHeader.IsPacketIpv4Header()) {
+        return;
+    }
+    UbDatalinkPacketHeader dlPktHeader;
+    UbNetworkHeader netHeader;
+    packet->RemoveHeader(dlPktHeader);
+    packet->RemoveHeader(netHeader);
+    if (netHeader.GetMode() == UB_NETWORK_HEADER_MODE_FECN && netHeader.GetFecn() == UB_FECN_ECT
+        && m_queueManager->CheckEcnMark(outPort, priority)) {
+        NS_LOG_DEBUG("[UbSwitch EcnMarkPacket] Node:" << GetObject<Node>()->GetId()
+                  << " port:" << outPort
+                  << " egress size:" << m_queueManager->GetEgressUsed(outPort, priority)
+                  << " PacketUid: " << packet->GetUid());
+        netHeader.SetFecn(UB_FECN_CE);
+    }
+    packet->AddHeader(netHeader);
+    packet->AddHeader(dlPktHeader);
+}
+
 bool UbSwitch::IsCBFCEnable()
 {
     return m_isCBFCEnable;
@@ -488,6 +758,21 @@ bool UbSwitch::IsPFCEnable()
     return m_isPFCEnable;
 }
 
+bool UbSwitch::IsECNEnable()
+{
+    return m_isECNEnable;
+}
+
+bool UbSwitch::IsCutThroughEnable()
+{
+    return m_isCutThroughEnable;
+}
+
+uint32_t UbSwitch::GetCutThroughHeaderSize()
+{
+    return m_cutThroughHeaderSize;
+}
+
 Ptr<UbQueueManager> UbSwitch::GetQueueManager()
 {
     return m_queueManager;
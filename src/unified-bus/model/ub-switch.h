@@ -12,6 +12,7 @@
 #include "ns3/ub-header.h"
 #include "ns3/ipv4-header.h"
 #include "ns3/udp-header.h"
+#include "ns3/data-rate.h"
 
 namespace ns3 {
 class UbSwitchCaqm;
@@ -31,6 +32,13 @@ typedef enum {
     UNKOWN_TYPE
 } UbPacketType_t;
 
+// 交换机出端口调度算法
+enum class UbAllocatorType {
+    ROUND_ROBIN,
+    DWRR,
+    ISLIP
+};
+
 /**
  * @brief 交换机
  */
@@ -62,15 +70,31 @@ public:
     void AddTpIntoAlgroithm(Ptr<UbIngressQueue> tp, uint32_t outPort, uint32_t priority);
     void AddPktToVoq(Ptr<Packet> p, uint32_t outPort, uint32_t priority, uint32_t inPort);
     Ptr<UbSwitchAllocator> GetAllocator();
+    Ptr<UbSwitchAllocator> GetAllocator(uint32_t portId);
+    std::vector<Ptr<UbSwitchAllocator>> GetAllocators();
+    // 多die节点: 需在Init前设置, portDie为空时端口按编号连续均分到各die
+    void SetDies(uint32_t dieNum, const std::vector<uint32_t> &portDie);
+    uint32_t GetDieNum() {return m_dieNum;}
+    uint32_t GetPortDie(uint32_t portId);
+    uint32_t GetHostDie() {return m_hostDie;}
+    // 本地发出的报文从host die跨die到出端口所在die的额外等待时间
+    Time GetLocalEgressDelay(uint32_t portId, Ptr<Packet> packet);
     Ipv4Address GetNodIpv4Addr(){return m_Ipv4Addr;}
     Ptr<UbRoutingProcess> GetRoutingProcess() {return m_routingProcess;}
     bool IsCBFCEnable();
     bool IsPFCEnable();
+    bool IsECNEnable();
+    bool IsCutThroughEnable();
+    uint32_t GetCutThroughHeaderSize();
 
     void SetCongestionCtrl(Ptr<UbCongestionControl> congestionCtrl);
     Ptr<UbCongestionControl> GetCongestionCtrl();
     void SwitchSendFinish(uint32_t portId, uint32_t pri, Ptr<Packet> packet);
     Ptr<UbQueueManager> GetQueueManager();    // Queue Manage Unit
+    Ptr<UbPacketQueue> GetVoq(uint32_t outPort, uint32_t priority, uint32_t inPort)
+    {
+        return m_voq[outPort][priority][inPort];
+    }
 
 private:
 
@@ -95,18 +119,34 @@ private:
     void GetLdstRoutingKey(Ptr<Packet> packet, RoutingKey &rtKey);
     void ForwardDataPacket(Ptr<UbPort> port, Ptr<Packet> packet);
     void ChangePakcetRoutingPolicy(Ptr<Packet> packet,  bool useShortestPath);
+    void EcnMarkPacket(uint32_t outPort, uint32_t priority, Ptr<Packet> packet);
+    bool CanCutThrough(Ptr<UbPort> port, uint32_t outPort);
+    bool DeferToTailArrival(Ptr<UbPort> port, Ptr<Packet> packet);
+    bool DeferToHostDie(Ptr<UbPort> port, Ptr<Packet> packet);
+    Time ReserveDieLink(uint32_t srcDie, uint32_t dstDie, uint32_t size, Time start);
 
     Ptr<UbQueueManager> m_queueManager;   // Memory Management Unit
     Ptr<UbCongestionControl> m_congestionCtrl;
     UbNodeType_t m_nodeType;
     uint32_t m_portsNum = 1025;
-    Ptr<UbSwitchAllocator> m_allocator;
+    std::vector<Ptr<UbSwitchAllocator>> m_allocators;    // 每个die独立的调度器
+    UbAllocatorType m_allocatorType;
+    // multi-die
+    uint32_t m_dieNum = 1;
+    std::vector<uint32_t> m_portDie;            // 端口所属die
+    uint32_t m_hostDie;                         // 本地收发端点(TP/LDST)所在die
+    DataRate m_dieLinkRate;
+    Time m_dieLinkDelay;
+    std::vector<Time> m_dieLinkBusyUntil;       // [srcDie * dieNum + dstDie], die间单向链路空闲时刻
     uint32_t m_vlNum = 16;
     VirtualOutputQueue_t m_voq; // virtualOutputQueue[outport][priority][inport] for DOD
     Ptr<UbRoutingProcess> m_routingProcess;   // Router Model
 
     Ipv4Address m_Ipv4Addr;
     bool m_isECNEnable;
+    // cut-through
+    bool m_isCutThroughEnable;
+    uint32_t m_cutThroughHeaderSize;
     // cbfc
     bool m_isCBFCEnable;
     // pfc
@@ -120,6 +160,11 @@ private:
     UbTransportHeader m_ubTpHeader;
     // LDST Headers
     UbCna16NetworkHeader m_memHeader;
+    UbCna24NetworkHeader m_mem24Header;
+    bool m_isCna24Packet = false;   // 当前LDST报文的网络头宽度
+    uint32_t m_memScna = 0;
+    uint32_t m_memDcna = 0;
+    uint8_t m_memLb = 0;
     UbDummyTransactionHeader m_dummyTaHeader;
 };
 
@@ -3,6 +3,7 @@
 #define UB_TAG_H
 #include <unordered_map>
 #include <vector>
+#include <ns3/nstime.h>
 #include <ns3/tag.h>
 
 namespace ns3 {
@@ -277,5 +278,100 @@ private:
     uint32_t m_flowSize{0};
 };
 
+/**
+  * @brief Timestamp kinds carried by UbTimestampTag.
+  */
+enum class UbTimestampType : uint8_t {
+    TAIL_ARRIVAL = 0,   // 直通转发: 包尾到达接收端口的时刻
+    DIE_ARRIVAL = 1,    // 多die节点: 包经die间链路到达host die的时刻
+};
+
+/**
+  * @brief Tag carrying a simulation time for a packet that is handed over before it is
+  * completely received, e.g. cut-through switching delivers the packet at header arrival,
+  * or before it reaches the consuming die of a multi-die node.
+  */
+class UbTimestampTag : public Tag {
+public:
+    /**
+     * @brief Constructor
+     */
+    UbTimestampTag()
+        : Tag()
+    {
+    }
+
+    /**
+     * @brief Constructor
+     */
+    UbTimestampTag(UbTimestampType type, Time time)
+        : Tag(),
+          m_type(type),
+          m_time(time)
+    {
+    }
+
+    /**
+     * @brief Get the type ID.
+     * @return the object TypeId
+     */
+    static TypeId GetTypeId()
+    {
+        static TypeId tid = TypeId("ns3::UbTimestampTag")
+                                .SetParent<Tag>()
+                                .AddConstructor<UbTimestampTag>();
+        return tid;
+    }
+
+    TypeId GetInstanceTypeId() const
+    {
+        return GetTypeId();
+    }
+
+    /**
+     * @returns the number of bytes required to serialize the data of the tag.
+     */
+    uint32_t GetSerializedSize() const override
+    {
+        return 9;
+    }
+
+    /**
+     * @param i the buffer to write data into.
+     */
+    void Serialize(TagBuffer i) const override
+    {
+        i.WriteU8(static_cast<uint8_t>(m_type));
+        i.WriteU64(static_cast<uint64_t>(m_time.GetTimeStep()));
+    }
+
+    /**
+     * @param i the buffer to read data from.
+     */
+    void Deserialize(TagBuffer i) override
+    {
+        m_type = static_cast<UbTimestampType>(i.ReadU8());
+        m_time = TimeStep(i.ReadU64());
+    }
+
+    /**
+     * @param os the stream to print to
+     */
+    void Print(std::ostream& os) const override
+    {
+        os << "Type:" << static_cast<uint32_t>(m_type) << " Time:" << m_time << std::endl;
+    }
+
+    void SetType(UbTimestampType type) { m_type = type; }
+    UbTimestampType GetType() const { return m_type; }
+
+    void SetTime(Time time) { m_time = time; }
+    Time GetTime() const { return m_time; }
+
+private:
+    UbTimestampType m_type{UbTimestampType::TAIL_ARRIVAL};
+    Time m_time{0};
+};
+
 }
 #endif
\ No newline at end of file
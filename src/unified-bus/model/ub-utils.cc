@@ -1,6 +1,11 @@
 // SPDX-License-Identifier: GPL-2.0-only
 #include "ub-utils.h"
 #include "ns3/hbm-helper.h"
+#include "ns3/hbm-controller.h"
+#include "ns3/hbm-cache.h"
+#include "ns3/hbm-traffic-generator.h"
+#include "ns3/hbm-channel.h"
+#include "ns3/ub-ldst-thread.h"
 #include "ns3/random-variable-stream.h"
 
 namespace utils {
@@ -47,6 +52,23 @@ void UbUtils::ParseTrace(bool isTest)
 
 void UbUtils::Destroy()
 {
+    if (m_fcMonitor != nullptr) {
+        m_fcMonitor->ReportHolBlocking();
+        m_fcMonitor = nullptr;
+    }
+    ReportMemCache();
+    ReportPrefetch();
+    ReportHbmBgTraffic();
+    ReportHbmStats();
+    ReportCoherence();
+    if (m_memTraceReplay != nullptr) {
+        std::ostringstream oss;
+        oss << "Memory trace replay, issued: " << m_memTraceReplay->GetIssued()
+            << " completed: " << m_memTraceReplay->GetCompleted();
+        PrintTraceInfo(trace_path + "runlog/MemTraceReplay.tr", oss.str());
+        m_memTraceReplay = nullptr;
+    }
+    m_addressMap = nullptr;
     for (auto &pair : files) {
         if (pair.second->is_open()) {
             pair.second->close();
@@ -375,6 +397,19 @@ inline void UbUtils::LdstPeerSendFirstPacketACKsNotify(uint32_t nodeId, uint32_t
     PrintTraceInfo(fileName, info);
 }
 
+void UbUtils::FcDeadlockNotify(std::string cycle)
+{
+    PrintTraceInfo(trace_path + "runlog/FcMonitor.tr", cycle);
+}
+
+void UbUtils::FcHolBlockingNotify(uint32_t nodeId, uint32_t portId, uint32_t vl, Time blockedTime)
+{
+    std::ostringstream oss;
+    oss << "HOL Blocking, NodeId: " << nodeId << " PortId: " << portId << " VL: " << vl
+        << " blockedTime: " << blockedTime.GetNanoSeconds() << "ns";
+    PrintTraceInfo(trace_path + "runlog/FcMonitor.tr", oss.str());
+}
+
 inline void UbUtils::SwitchLastPacketTraversesNotify(uint32_t nodeId, UbTransportHeader ubTpHeader)
 {
     if (ubTpHeader.GetLastPacket()) {
@@ -485,22 +520,33 @@ void UbUtils::CreateNode(const string &filename)
         string nodeTypeStr;
         string portNumStr;
         string forwardDelay;
-        // 解析CSV行
+        string dieNumStr;
+        string portDieStr;
+        // 解析CSV行, dieNum与portDie为可选列
         getline(ss, nodeIdStr, ',');
         getline(ss, nodeTypeStr, ',');
         getline(ss, portNumStr, ',');
-        getline(ss, forwardDelay);
+        getline(ss, forwardDelay, ',');
+        getline(ss, dieNumStr, ',');
+        getline(ss, portDieStr);
 
         NodeEle nodeEle = {};
         nodeEle.nodeIdStr = nodeIdStr;
         nodeEle.nodeTypeStr = nodeTypeStr;
         nodeEle.portNumStr = portNumStr;
         nodeEle.forwardDelay = forwardDelay;
+        nodeEle.dieNumStr = dieNumStr;
+        nodeEle.portDieStr = portDieStr;
 
         // 解析节点ID（范围 or 单个节点）
         ParseNodeRange(nodeIdStr, nodeEle);
     }
     file.close();
+    m_addressMap = CreateObject<UbAddressMap>();
+    if (m_addressMap->IsEnabled()) {
+        PrintTimestamp("Memory pool across " + std::to_string(m_addressMap->GetMemoryNodes().size()) +
+                       " nodes, interleave " + std::to_string(m_addressMap->GetInterleave()) + " bytes.");
+    }
     // 创建节点
     for (auto it: nodeEle_map) {
         string nodeIdStr = it.second.nodeIdStr;
@@ -508,6 +554,20 @@ void UbUtils::CreateNode(const string &filename)
         string portNumStr = it.second.portNumStr;
         string forwardDelay = it.second.forwardDelay;
         int portNum = stoi(portNumStr);
+        // 多die节点: portDie按端口顺序以空格分隔, 缺省时端口连续均分到各die
+        uint32_t dieNum = 1;
+        if (it.second.dieNumStr.find_first_not_of(" \t\r") != string::npos) {
+            dieNum = stoi(it.second.dieNumStr);
+        }
+        vector<uint32_t> portDie;
+        stringstream sPortDie(it.second.portDieStr);
+        uint32_t die;
+        while (sPortDie >> die) {
+            portDie.push_back(die);
+        }
+        if (!portDie.empty() && portDie.size() != (size_t)portNum) {
+            NS_ASSERT_MSG(0, "portDie size not equal portNum! node: " << it.first);
+        }
         Ptr<Node> node = CreateObject<Node>();
         Ptr<UbSwitch> sw = CreateObject<UbSwitch>();
 
@@ -515,6 +575,9 @@ void UbUtils::CreateNode(const string &filename)
         Ptr<ns3::UbLdstInstance> ldst = CreateObject<UbLdstInstance>();
         node->AggregateObject(ldst);
         ldst->Init(node->GetId());
+        if (m_addressMap->IsEnabled()) {
+            ldst->SetAddressMap(m_addressMap);
+        }
         if (nodeTypeStr == "DEVICE") {
             Ptr<UbController> ubCtrl = CreateObject<UbController>();
             node->AggregateObject(ubCtrl);
@@ -522,11 +585,42 @@ void UbUtils::CreateNode(const string &filename)
             ubCtrl->CreateUbTransaction();
             sw->SetNodeType(UB_DEVICE);
 
-            Ptr<HBMController> hbm = HBMHelper().Create(8);
-            Ptr<UniformRandomVariable> rng = CreateObject<UniformRandomVariable>();
-            node->AggregateObject(rng);
+            Ptr<HBMController> hbm = HBMHelper().Create();
             node->AggregateObject(hbm);
-            
+            BooleanValue hbmStatsEnable;
+            g_hbm_stats_enable.GetValue(hbmStatsEnable);
+            if (hbmStatsEnable.Get()) {
+                hbm->EnableStats();
+            }
+            BooleanValue cacheEnable;
+            g_mem_cache_enable.GetValue(cacheEnable);
+            Ptr<HBMCache> cache = nullptr;
+            if (cacheEnable.Get()) {
+                cache = CreateObject<HBMCache>();
+                cache->SetController(hbm);
+                node->AggregateObject(cache);
+            }
+            // 一致性: 每个设备既是其内存的home, 也是其他节点内存的请求者
+            BooleanValue coherenceEnable;
+            g_coherence_enable.GetValue(coherenceEnable);
+            if (coherenceEnable.Get()) {
+                Ptr<UbCoherenceDirectory> directory = CreateObject<UbCoherenceDirectory>();
+                directory->Init(node->GetId());
+                node->AggregateObject(directory);
+                Ptr<UbCoherenceAgent> agent = CreateObject<UbCoherenceAgent>();
+                agent->Init(node->GetId(), directory->GetLineSize());
+                node->AggregateObject(agent);
+            }
+            // 设备自身计算产生的本地访存负载
+            BooleanValue bgTrafficEnable;
+            g_hbm_bg_traffic_enable.GetValue(bgTrafficEnable);
+            if (bgTrafficEnable.Get()) {
+                Ptr<HBMTrafficGenerator> bgTraffic = CreateObject<HBMTrafficGenerator>();
+                bgTraffic->SetController(hbm);
+                bgTraffic->SetCache(cache);
+                node->AggregateObject(bgTraffic);
+                bgTraffic->Start();
+            }
         } else if (nodeTypeStr == "SWITCH") {
             sw->SetNodeType(UB_SWITCH);
         } else {
@@ -537,12 +631,14 @@ void UbUtils::CreateNode(const string &filename)
             port->SetAddress(Mac48Address::Allocate());
             node->AddDevice(port);
         }
+        sw->SetDies(dieNum, portDie);
         sw->Init();
         auto cc = UbCongestionControl::Create(UB_SWITCH);
         cc->SwitchInit(sw);
         if (!forwardDelay.empty()) {
-            auto allocator = sw->GetAllocator();
-            allocator->SetAttribute("AllocationTime", StringValue(forwardDelay));
+            for (auto allocator : sw->GetAllocators()) {
+                allocator->SetAttribute("AllocationTime", StringValue(forwardDelay));
+            }
         }
     }
 }
@@ -943,4 +1039,194 @@ void UbUtils::InitFaultMoudle(const string &FaultConfigFile)
     ubFault->InitFault(FaultConfigFile);
 }
 
-} // namespace utils
\ No newline at end of file
+void UbUtils::ReportMemCache()
+{
+    for (uint32_t i = 0; i < NodeList::GetNNodes(); i++) {
+        auto cache = NodeList::GetNode(i)->GetObject<HBMCache>();
+        if (cache == nullptr) {
+            continue;
+        }
+        std::ostringstream oss;
+        oss << "NodeId: " << i << " hits: " << cache->GetHits() << " misses: " << cache->GetMisses()
+            << " mshrMerges: " << cache->GetMshrMerges() << " writebacks: " << cache->GetWritebacks();
+        PrintTraceInfoNoTs(trace_path + "runlog/MemCache.tr", oss.str());
+    }
+}
+
+void UbUtils::ReportPrefetch()
+{
+    for (uint32_t i = 0; i < NodeList::GetNNodes(); i++) {
+        auto ldst = NodeList::GetNode(i)->GetObject<UbLdstInstance>();
+        if (ldst == nullptr) {
+            continue;
+        }
+        for (uint32_t threadId = 0; threadId < ldst->GetThreadNum(); threadId++) {
+            auto prefetcher = ldst->GetLdstThread(threadId)->GetPrefetcher();
+            if (prefetcher == nullptr || prefetcher->GetIssued() + prefetcher->GetDemandMisses() == 0) {
+                continue;
+            }
+            std::ostringstream oss;
+            oss << "NodeId: " << i << " ThreadId: " << threadId << " issued: " << prefetcher->GetIssued()
+                << " useful: " << prefetcher->GetUseful() << " late: " << prefetcher->GetLate()
+                << " unused: " << prefetcher->GetUnused() << " demandMisses: " << prefetcher->GetDemandMisses()
+                << " accuracy: " << prefetcher->GetAccuracy() << " coverage: " << prefetcher->GetCoverage();
+            PrintTraceInfoNoTs(trace_path + "runlog/Prefetch.tr", oss.str());
+        }
+    }
+}
+
+void UbUtils::InitFcMonitor()
+{
+    BooleanValue enable;
+    g_fc_monitor_enable.GetValue(enable);
+    if (!enable.Get()) {
+        return;
+    }
+    m_fcMonitor = CreateObject<UbFcMonitor>();
+    m_fcMonitor->TraceConnectWithoutContext("DeadlockDetected", MakeCallback(FcDeadlockNotify));
+    m_fcMonitor->TraceConnectWithoutContext("HolBlocking", MakeCallback(FcHolBlockingNotify));
+    m_fcMonitor->Start();
+}
+
+void UbUtils::InitMemTraceReplay(const string &configPath)
+{
+    StringValue traceFile;
+    g_mem_trace_file.GetValue(traceFile);
+    if (traceFile.Get().empty()) {
+        return;
+    }
+    string filename = traceFile.Get();
+    if (filename[0] != '/') {
+        filename = configPath + "/" + filename;
+    }
+    PrintTimestamp("Replay memory trace: " + filename);
+    m_memTraceReplay = CreateObject<UbMemTraceReplay>();
+    m_memTraceReplay->Start(filename);
+}
+
+bool UbUtils::IsMemTraceReplayCompleted()
+{
+    return m_memTraceReplay == nullptr || m_memTraceReplay->IsCompleted();
+}
+
+void UbUtils::ReportHbmBgTraffic()
+{
+    for (uint32_t i = 0; i < NodeList::GetNNodes(); i++) {
+        auto bgTraffic = NodeList::GetNode(i)->GetObject<HBMTrafficGenerator>();
+        if (bgTraffic == nullptr) {
+            continue;
+        }
+        double bandwidth = Simulator::Now().IsZero() ? 0 :
+            static_cast<double>(bgTraffic->GetCompletedBytes()) / Simulator::Now().GetNanoSeconds();
+        std::ostringstream oss;
+        oss << "NodeId: " << i << " issued: " << bgTraffic->GetIssued() << " completed: " << bgTraffic->GetCompleted()
+            << " skipped: " << bgTraffic->GetSkipped() << " bandwidth(GB/s): " << bandwidth
+            << " avgLatency(ns): " << bgTraffic->GetAverageLatency().GetNanoSeconds();
+        PrintTraceInfoNoTs(trace_path + "runlog/HbmBgTraffic.tr", oss.str());
+    }
+}
+
+void UbUtils::ReportHbmStats()
+{
+    BooleanValue hbmStatsEnable;
+    g_hbm_stats_enable.GetValue(hbmStatsEnable);
+    if (!hbmStatsEnable.Get()) {
+        return;
+    }
+    string fileName = trace_path + "runlog/HbmStats.tr";
+    double now = Simulator::Now().GetNanoSeconds();
+    for (uint32_t i = 0; i < NodeList::GetNNodes(); i++) {
+        auto hbm = NodeList::GetNode(i)->GetObject<HBMController>();
+        if (hbm == nullptr) {
+            continue;
+        }
+        const auto &stats = hbm->GetStats();
+        double bursts = std::max<uint64_t>(stats.bursts, 1);
+        std::ostringstream oss;
+        oss << "NodeId: " << i << " readBytes: " << stats.readBytes << " writeBytes: " << stats.writeBytes
+            << " bandwidth(GB/s): " << (now > 0 ? (stats.readBytes + stats.writeBytes) / now : 0)
+            << " peak(GB/s): " << hbm->GetPeakBandwidth()
+            << " rowHitRate: " << stats.rowHits / bursts
+            << " avgQueue(ns): " << stats.queueDelay.GetNanoSeconds() / bursts
+            << " avgActivate(ns): " << stats.activateDelay.GetNanoSeconds() / bursts
+            << " avgCas(ns): " << stats.casDelay.GetNanoSeconds() / bursts
+            << " avgBurst(ns): " << stats.burstDelay.GetNanoSeconds() / bursts;
+        // 读写切换与写缓冲统计
+        uint64_t turnarounds = 0;
+        uint64_t writeDrains = 0;
+        uint64_t mergedWrites = 0;
+        uint64_t forwardedReads = 0;
+        for (uint32_t stackId = 0; stackId < hbm->GetNStacks(); stackId++) {
+            for (uint32_t channelId = 0; channelId < hbm->GetNChannels() / hbm->GetNStacks(); channelId++) {
+                auto channel = hbm->GetChannel(stackId, channelId);
+                turnarounds += channel->GetTurnarounds();
+                writeDrains += channel->GetWriteDrains();
+                mergedWrites += channel->GetMergedWrites();
+                forwardedReads += channel->GetForwardedReads();
+            }
+        }
+        oss << " turnarounds: " << turnarounds << " writeDrains: " << writeDrains
+            << " mergedWrites: " << mergedWrites << " forwardedReads: " << forwardedReads;
+        PrintTraceInfoNoTs(fileName, oss.str());
+        // 各bank的忙碌时间占比、行命中与到达时看到的队列长度分布(长度:次数)
+        for (uint32_t stackId = 0; stackId < hbm->GetNStacks(); stackId++) {
+            for (uint32_t channelId = 0; channelId < hbm->GetNChannels() / hbm->GetNStacks(); channelId++) {
+                auto channel = hbm->GetChannel(stackId, channelId);
+                for (uint32_t bankId = 0; bankId < channel->GetNBanks(); bankId++) {
+                    auto bank = channel->GetBank(bankId);
+                    std::ostringstream bankOss;
+                    bankOss << "NodeId: " << i << " stack: " << stackId << " channel: " << channelId
+                            << " bank: " << bankId << " utilization: "
+                            << (now > 0 ? bank->GetBusyTime().GetNanoSeconds() / now : 0)
+                            << " accesses: " << bank->GetAccesses() << " rowHits: " << bank->GetRowHits()
+                            << " queueHist:";
+                    const auto &hist = bank->GetQueueLengthHistogram();
+                    for (size_t len = 0; len < hist.size(); len++) {
+                        if (hist[len] > 0) {
+                            bankOss << " " << len << ":" << hist[len];
+                        }
+                    }
+                    PrintTraceInfoNoTs(fileName, bankOss.str());
+                }
+            }
+        }
+        const auto &windowBytes = hbm->GetWindowBytes();
+        if (!windowBytes.empty()) {
+            std::ostringstream winOss;
+            winOss << "NodeId: " << i << " bytesPerWindow(" << hbm->GetStatsWindow().GetNanoSeconds() << "ns):";
+            for (auto bytes : windowBytes) {
+                winOss << " " << bytes;
+            }
+            PrintTraceInfoNoTs(fileName, winOss.str());
+        }
+    }
+}
+
+void UbUtils::ReportCoherence()
+{
+    string fileName = trace_path + "runlog/Coherence.tr";
+    for (uint32_t i = 0; i < NodeList::GetNNodes(); i++) {
+        auto node = NodeList::GetNode(i);
+        auto directory = node->GetObject<UbCoherenceDirectory>();
+        auto agent = node->GetObject<UbCoherenceAgent>();
+        if (directory == nullptr || agent == nullptr) {
+            continue;
+        }
+        if (directory->GetRequests() == 0 && agent->GetHits() + agent->GetMisses() == 0) {
+            continue;
+        }
+        std::ostringstream oss;
+        oss << "NodeId: " << i << " homeRequests: " << directory->GetRequests()
+            << " conflicts: " << directory->GetConflicts()
+            << " invalidations: " << directory->GetInvalidations()
+            << " downgrades: " << directory->GetDowngrades()
+            << " snoopWritebacks: " << directory->GetSnoopWritebacks()
+            << " evictionWritebacks: " << directory->GetEvictionWritebacks()
+            << " avgSnoop(ns): " << directory->GetAverageSnoopTime().GetNanoSeconds()
+            << " lineHits: " << agent->GetHits() << " lineMisses: " << agent->GetMisses()
+            << " snoopsReceived: " << agent->GetSnoops() << " writebacks: " << agent->GetWritebacks();
+        PrintTraceInfoNoTs(fileName, oss.str());
+    }
+}
+
+} // namespace utils
@@ -32,6 +32,10 @@
 #include "ns3/random-variable-stream.h"
 #include "ns3/enum.h"
 #include "ns3/ub-fault.h"
+#include "ns3/ub-fc-monitor.h"
+#include "ns3/ub-mem-trace-replay.h"
+#include "ns3/ub-address-map.h"
+#include "ns3/ub-coherence.h"
 using namespace std;
 using namespace ns3;
 
@@ -48,6 +52,31 @@ public:
 
     GlobalValue g_fault_enable =
     GlobalValue("UB_FAULT_ENABLE", "fault moudle enabled", BooleanValue(false), MakeBooleanChecker());
+
+    GlobalValue g_fc_monitor_enable =
+    GlobalValue("UB_FC_MONITOR_ENABLE", "enable PFC/CBFC deadlock and HOL blocking monitor",
+                BooleanValue(false), MakeBooleanChecker());
+
+    GlobalValue g_mem_trace_file =
+    GlobalValue("UB_MEM_TRACE_FILE", "binary LD/ST memory trace replayed by ns3::UbMemTraceReplay, relative to the case dir",
+                StringValue(""), MakeStringChecker());
+
+    GlobalValue g_mem_cache_enable =
+    GlobalValue("UB_MEM_CACHE_ENABLE", "enable memory-side cache (ns3::HBMCache) in front of HBM on devices",
+                BooleanValue(false), MakeBooleanChecker());
+
+    GlobalValue g_hbm_bg_traffic_enable =
+    GlobalValue("UB_HBM_BG_TRAFFIC_ENABLE", "run a background load (ns3::HBMTrafficGenerator) on the HBM of devices",
+                BooleanValue(false), MakeBooleanChecker());
+
+    GlobalValue g_coherence_enable =
+    GlobalValue("UB_COHERENCE_ENABLE", "keep LD/ST accesses coherent with a home directory (ns3::UbCoherenceDirectory) "
+                "and requester line states (ns3::UbCoherenceAgent) on devices",
+                BooleanValue(false), MakeBooleanChecker());
+
+    GlobalValue g_hbm_stats_enable =
+    GlobalValue("UB_HBM_STATS_ENABLE", "collect HBM bandwidth, bank utilization, queueing and latency breakdown of devices",
+                BooleanValue(false), MakeBooleanChecker());
     
     void PrintTimestamp(const std::string &message);
 
@@ -81,6 +110,14 @@ public:
 
     void InitFaultMoudle(const string &FaultConfigFile);
 
+    // 无损网络死锁/HOL阻塞检测, 结果写入runlog/FcMonitor.tr
+    void InitFcMonitor();
+
+    // 配置了UB_MEM_TRACE_FILE时回放访存trace
+    void InitMemTraceReplay(const string &configPath);
+
+    bool IsMemTraceReplayCompleted();
+
 private:
     // 读取Traffic配置文件
     enum class FIELDCOUNT : int {
@@ -103,6 +140,10 @@ private:
         string portNumStr;
 
         string forwardDelay;
+
+        string dieNumStr;
+
+        string portDieStr;
     };
 
     std::map<uint32_t, NodeEle> nodeEle_map;
@@ -185,6 +226,32 @@ private:
 
     static void SwitchLastPacketTraversesNotify(uint32_t nodeId, UbTransportHeader ubTpHeader);
 
+    static void FcDeadlockNotify(std::string cycle);
+
+    static void FcHolBlockingNotify(uint32_t nodeId, uint32_t portId, uint32_t vl, Time blockedTime);
+
+    Ptr<UbFcMonitor> m_fcMonitor;
+
+    Ptr<UbMemTraceReplay> m_memTraceReplay;
+
+    // 内存池化的全局地址映射, 由ns3::UbAddressMap::MemoryNodes启用, 各节点的UbLdstInstance共享
+    Ptr<UbAddressMap> m_addressMap;
+
+    // 输出各节点内存侧cache的命中统计到runlog/MemCache.tr
+    void ReportMemCache();
+
+    // 输出各LD/ST线程预取的准确率与覆盖率到runlog/Prefetch.tr
+    void ReportPrefetch();
+
+    // 输出各节点HBM背景负载的带宽与时延到runlog/HbmBgTraffic.tr
+    void ReportHbmBgTraffic();
+
+    // 输出各节点HBM带宽、行命中率、时延分解与各bank利用率/队列长度分布到runlog/HbmStats.tr
+    void ReportHbmStats();
+
+    // 输出各节点的目录与行状态统计到runlog/Coherence.tr
+    void ReportCoherence();
+
     // 解析节点范围（如 "1..4"）
     inline void ParseNodeRange(const string &rangeStr, NodeEle nodeEle);
 
@@ -15,6 +15,19 @@
 #include "ns3/config.h"
 #include "ns3/rng-seed-manager.h"
 #include "ns3/node-container.h"
+#include "ns3/ub-address-map.h"
+#include "ns3/ub-header.h"
+#include "ns3/ub-network-address.h"
+#include "ns3/packet.h"
+#include "ns3/hbm-helper.h"
+#include "ns3/hbm-controller.h"
+#include "ns3/hbm-cache.h"
+#include "ns3/ub-utils.h"
+#include "ns3/ub-fc-monitor.h"
+#include "ns3/ub-flow-control.h"
+#include "ns3/ub-port.h"
+#include <fstream>
+#include <sstream>
 
 using namespace ns3;
 
@@ -87,6 +100,604 @@ void UbFunctionalityTest::DoRun()
     NS_LOG_INFO("All basic tests completed successfully");
 }
 
+/**
+ * @brief Memory pool address striping test
+ *
+ * Checks that UbAddressMap places Interleave-sized pages round-robin on the
+ * memory nodes and that a global range is split into one contiguous local
+ * range per target node.
+ */
+class UbAddressMapTest : public TestCase
+{
+public:
+    UbAddressMapTest();
+    void DoRun() override;
+};
+
+UbAddressMapTest::UbAddressMapTest()
+    : TestCase("UnifiedBus - Memory pool address map")
+{
+}
+
+void UbAddressMapTest::DoRun()
+{
+    const uint64_t base = 0x1000;
+    const uint64_t page = 4096;
+    Ptr<UbAddressMap> addressMap = CreateObject<UbAddressMap>();
+    NS_TEST_ASSERT_MSG_EQ(addressMap->IsEnabled(), false, "Empty MemoryNodes should disable pooling");
+    addressMap->SetAttribute("MemoryNodes", StringValue("2,4,6..7"));
+    addressMap->SetAttribute("Interleave", UintegerValue(page));
+    addressMap->SetAttribute("BaseAddress", UintegerValue(base));
+    NS_TEST_ASSERT_MSG_EQ(addressMap->IsEnabled(), true, "MemoryNodes should enable pooling");
+    NS_TEST_ASSERT_MSG_EQ(addressMap->GetMemoryNodes().size(), 4, "MemoryNodes should expand the range");
+
+    // Stripe to node mapping
+    uint32_t node;
+    uint64_t localAddress;
+    uint64_t bytesInStripe;
+    addressMap->Map(base, node, localAddress, bytesInStripe);
+    NS_TEST_ASSERT_MSG_EQ(node, 2, "Page 0 should be on the first memory node");
+    NS_TEST_ASSERT_MSG_EQ(localAddress, 0, "Page 0 should start the local address space");
+    NS_TEST_ASSERT_MSG_EQ(bytesInStripe, page, "A page aligned address should see the whole stripe");
+    addressMap->Map(base + 5 * page + 100, node, localAddress, bytesInStripe);
+    NS_TEST_ASSERT_MSG_EQ(node, 4, "Page 5 should wrap around to the second memory node");
+    NS_TEST_ASSERT_MSG_EQ(localAddress, page + 100, "Page 5 should be the second local page of its node");
+    NS_TEST_ASSERT_MSG_EQ(bytesInStripe, page - 100, "Bytes to the end of the stripe");
+    addressMap->Map(base + 3 * page, node, localAddress, bytesInStripe);
+    NS_TEST_ASSERT_MSG_EQ(node, 7, "Page 3 should be on the last memory node");
+
+    // Per-target split: pages 0..4 from the middle of page 0, page 4 is back on node 2
+    auto ranges = addressMap->Split(base + page / 2, 4 * page);
+    NS_TEST_ASSERT_MSG_EQ(ranges.size(), 4, "One range per target node");
+    const uint32_t nodes[] = {2, 4, 6, 7};
+    for (uint32_t i = 0; i < ranges.size(); i++) {
+        NS_TEST_ASSERT_MSG_EQ(ranges[i].node, nodes[i], "Ranges should follow the first access order");
+    }
+    NS_TEST_ASSERT_MSG_EQ(ranges[0].address, page / 2, "Node 2 range should start inside its first page");
+    NS_TEST_ASSERT_MSG_EQ(ranges[0].size, page, "Node 2 range should merge both half pages");
+    NS_TEST_ASSERT_MSG_EQ(ranges[1].address, 0, "Node 4 range should start at its first local page");
+    NS_TEST_ASSERT_MSG_EQ(ranges[1].size, page, "Node 4 range should cover one page");
+    uint64_t total = 0;
+    for (auto &range : ranges) {
+        total += range.size;
+    }
+    NS_TEST_ASSERT_MSG_EQ(total, 4 * page, "The split should cover the whole range");
+    NS_TEST_ASSERT_MSG_EQ(addressMap->Split(base, 0).empty(), true, "An empty range should have no targets");
+}
+
+/**
+ * @brief CNA24 network header test
+ *
+ * Checks that UbCna24NetworkHeader survives a serialize/deserialize round trip
+ * with 24-bit addresses and the CC fields, and that the width-selecting CNA
+ * helpers agree with the CNA16/CNA24 specific ones.
+ */
+class UbCna24HeaderTest : public TestCase
+{
+public:
+    UbCna24HeaderTest();
+    void DoRun() override;
+};
+
+UbCna24HeaderTest::UbCna24HeaderTest()
+    : TestCase("UnifiedBus - CNA24 network header")
+{
+}
+
+void UbCna24HeaderTest::DoRun()
+{
+    // 超过CNA16范围的节点号和端口号
+    const uint32_t scna = utils::NodeIdToCna24(5000, 20);
+    const uint32_t dcna = utils::NodeIdToCna24(65535, 254);
+    UbCna24NetworkHeader header;
+    header.SetScna(scna);
+    header.SetDcna(dcna);
+    header.SetMode(UB_NETWORK_HEADER_MODE_FECN);
+    header.SetFecn(UB_FECN_ECT);
+    header.SetLb(0xA5);
+    header.SetServiceLevel(9);
+    header.SetNlp(5);
+
+    Ptr<Packet> packet = Create<Packet>(64);
+    packet->AddHeader(header);
+    NS_TEST_ASSERT_MSG_EQ(packet->GetSize(), 64 + 10, "CNA24 network header should be 10 bytes");
+    UbCna24NetworkHeader parsed;
+    packet->RemoveHeader(parsed);
+    NS_TEST_ASSERT_MSG_EQ(packet->GetSize(), 64, "Deserialize should consume the whole header");
+    NS_TEST_ASSERT_MSG_EQ(parsed.GetScna(), scna, "SCNA should survive the round trip");
+    NS_TEST_ASSERT_MSG_EQ(parsed.GetDcna(), dcna, "DCNA should survive the round trip");
+    NS_TEST_ASSERT_MSG_EQ((uint32_t)parsed.GetMode(), (uint32_t)UB_NETWORK_HEADER_MODE_FECN, "Mode");
+    NS_TEST_ASSERT_MSG_EQ((uint32_t)parsed.GetFecn(), (uint32_t)UB_FECN_ECT, "FECN");
+    NS_TEST_ASSERT_MSG_EQ((uint32_t)parsed.GetLb(), 0xA5, "LB");
+    NS_TEST_ASSERT_MSG_EQ((uint32_t)parsed.GetServiceLevel(), 9, "Service level");
+    NS_TEST_ASSERT_MSG_EQ((uint32_t)parsed.GetNlp(), 5, "NLP");
+    std::ostringstream printed;
+    parsed.Print(printed);
+    NS_TEST_ASSERT_MSG_NE(printed.str().find(" FECN=1 LB=165 SL=9 NLP=5"), std::string::npos,
+                          "Print should show the CC, LB, SL and NLP fields: " << printed.str());
+    NS_TEST_ASSERT_MSG_EQ(utils::Cna24ToNodeId(parsed.GetScna()), 5000, "SCNA node id");
+    NS_TEST_ASSERT_MSG_EQ(utils::Cna24ToPortId(parsed.GetScna()), 20, "SCNA port id");
+    NS_TEST_ASSERT_MSG_EQ(utils::Cna24ToNodeId(parsed.GetDcna()), 65535, "DCNA node id");
+
+    // 按宽度选择的转换与CNA16/CNA24专用转换一致
+    const uint32_t nodes[] = {0, 1, 15, 4095};
+    const uint32_t ports[] = {0, 3, 14};
+    for (uint32_t node : nodes) {
+        for (uint32_t port : ports) {
+            uint32_t cna16 = utils::NodeIdToCna16(node, port);
+            uint32_t cna24 = utils::NodeIdToCna24(node, port);
+            NS_TEST_ASSERT_MSG_EQ(utils::CnaToNodeId(cna16, false), utils::Cna16ToNodeId(cna16), "CNA16 node id");
+            NS_TEST_ASSERT_MSG_EQ(utils::CnaToPortId(cna16, false), utils::Cna16ToPortId(cna16), "CNA16 port id");
+            NS_TEST_ASSERT_MSG_EQ(utils::CnaToNodeId(cna24, true), utils::Cna24ToNodeId(cna24), "CNA24 node id");
+            NS_TEST_ASSERT_MSG_EQ(utils::CnaToPortId(cna24, true), utils::Cna24ToPortId(cna24), "CNA24 port id");
+            NS_TEST_ASSERT_MSG_EQ(utils::CnaToNodeId(cna16, false), node, "CNA16 should keep the node id");
+            NS_TEST_ASSERT_MSG_EQ(utils::CnaToNodeId(cna24, true), node, "CNA24 should keep the node id");
+            NS_TEST_ASSERT_MSG_EQ(utils::CnaToPortId(cna16, false), port, "CNA16 should keep the port id");
+            NS_TEST_ASSERT_MSG_EQ(utils::CnaToPortId(cna24, true), port, "CNA24 should keep the port id");
+        }
+        NS_TEST_ASSERT_MSG_EQ(utils::NodeIdToCna(node, false), utils::NodeIdToCna16(node), "CNA16 node address");
+        NS_TEST_ASSERT_MSG_EQ(utils::NodeIdToCna(node, true), utils::NodeIdToCna24(node), "CNA24 node address");
+    }
+}
+
+/**
+ * @brief Records the completion time of every memory access
+ */
+class HbmRecordingClient : public HBMClient
+{
+public:
+    void HBMAccessDone(uint64_t requestId) override
+    {
+        done[requestId] = Simulator::Now();
+    }
+    std::map<uint64_t, Time> done;
+};
+
+/**
+ * @brief Memory-side cache test
+ *
+ * Drives an HBMCache of 2 sets x 2 ways of 64B lines directly and checks hits,
+ * misses, MSHR merges, dirty writebacks with LRU and random replacement,
+ * write-through without allocation and misses stalled by a full MSHR file.
+ */
+class HbmCacheTest : public TestCase
+{
+public:
+    HbmCacheTest();
+    void DoRun() override;
+
+private:
+    Ptr<HBMCache> CreateCache(std::string replacement, std::string writePolicy, uint32_t mshrNum);
+    void Access(Time at, uint64_t requestId, uint64_t address, bool isWrite);
+    void TestHitMissMerge();
+    void TestDirtyWriteback();
+    void TestRandomReplacement();
+    void TestWriteThrough();
+    void TestMshrStall();
+
+    static constexpr uint64_t LINE = 64;
+    Ptr<HBMController> m_controller;
+    Ptr<HBMCache> m_cache;
+    HbmRecordingClient m_client;
+};
+
+HbmCacheTest::HbmCacheTest()
+    : TestCase("UnifiedBus - HBM memory-side cache")
+{
+}
+
+Ptr<HBMCache> HbmCacheTest::CreateCache(std::string replacement, std::string writePolicy, uint32_t mshrNum)
+{
+    m_controller = HBMHelper().Create();
+    m_controller->EnableStats();
+    m_cache = CreateObject<HBMCache>();
+    m_cache->SetAttribute("Size", UintegerValue(4 * LINE));
+    m_cache->SetAttribute("LineSize", UintegerValue(LINE));
+    m_cache->SetAttribute("Ways", UintegerValue(2));
+    m_cache->SetAttribute("HitLatency", TimeValue(NanoSeconds(5)));
+    m_cache->SetAttribute("Replacement", StringValue(replacement));
+    m_cache->SetAttribute("WritePolicy", StringValue(writePolicy));
+    m_cache->SetAttribute("MshrNum", UintegerValue(mshrNum));
+    m_cache->SetController(m_controller);
+    m_client.done.clear();
+    return m_cache;
+}
+
+void HbmCacheTest::Access(Time at, uint64_t requestId, uint64_t address, bool isWrite)
+{
+    Simulator::Schedule(at, &HBMCache::SendRequest, m_cache, requestId, address, LINE, isWrite,
+                        static_cast<HBMClient *>(&m_client));
+}
+
+void HbmCacheTest::TestHitMissMerge()
+{
+    CreateCache("Lru", "WriteBack", 4);
+    Access(NanoSeconds(0), 1, 0, false);
+    Access(NanoSeconds(0), 2, 0, false);      // same line while the fill is outstanding
+    Access(MicroSeconds(1), 3, 0, false);
+    Simulator::Run();
+    NS_TEST_ASSERT_MSG_EQ(m_cache->GetMisses(), 2, "Both accesses before the fill should miss");
+    NS_TEST_ASSERT_MSG_EQ(m_cache->GetMshrMerges(), 1, "The second miss should merge into the MSHR");
+    NS_TEST_ASSERT_MSG_EQ(m_cache->GetHits(), 1, "The access after the fill should hit");
+    NS_TEST_ASSERT_MSG_EQ(m_client.done.size(), 3, "All accesses should complete");
+    NS_TEST_ASSERT_MSG_EQ(m_client.done[1], m_client.done[2], "Merged accesses complete with the fill");
+    NS_TEST_ASSERT_MSG_EQ(m_client.done[3], MicroSeconds(1) + NanoSeconds(5), "A hit costs HitLatency");
+    NS_TEST_ASSERT_MSG_EQ(m_controller->GetStats().readBytes, LINE, "One line fill should reach HBM");
+    Simulator::Destroy();
+}
+
+void HbmCacheTest::TestDirtyWriteback()
+{
+    CreateCache("Lru", "WriteBack", 4);
+    // Lines 0, 2 and 4 map to set 0
+    Access(NanoSeconds(0), 1, 0, true);
+    Access(MicroSeconds(1), 2, 2 * LINE, false);
+    Access(MicroSeconds(2), 3, 4 * LINE, false);     // evicts the dirty LRU line 0
+    Access(MicroSeconds(3), 4, 2 * LINE, false);
+    Access(MicroSeconds(4), 5, 0, false);
+    Simulator::Run();
+    NS_TEST_ASSERT_MSG_EQ(m_cache->GetWritebacks(), 1, "The dirty LRU victim should be written back");
+    NS_TEST_ASSERT_MSG_EQ(m_controller->GetStats().writeBytes, LINE, "The writeback should reach HBM");
+    NS_TEST_ASSERT_MSG_EQ(m_cache->GetHits(), 1, "Line 2 should survive the eviction");
+    NS_TEST_ASSERT_MSG_EQ(m_cache->GetMisses(), 4, "Line 0 should miss after its eviction");
+    NS_TEST_ASSERT_MSG_EQ(m_client.done.size(), 5, "All accesses should complete");
+    Simulator::Destroy();
+}
+
+void HbmCacheTest::TestRandomReplacement()
+{
+    CreateCache("Random", "WriteBack", 4);
+    Access(NanoSeconds(0), 1, 0, false);
+    Access(MicroSeconds(1), 2, 2 * LINE, false);
+    Access(MicroSeconds(2), 3, 4 * LINE, false);
+    Simulator::Stop(MicroSeconds(3));
+    Simulator::Run();
+    // Lookups happen when the requests arrive, two of the three lines are left in the set
+    uint64_t hits = m_cache->GetHits();
+    m_cache->SendRequest(4, 0, LINE, false, &m_client);
+    m_cache->SendRequest(5, 2 * LINE, LINE, false, &m_client);
+    m_cache->SendRequest(6, 4 * LINE, LINE, false, &m_client);
+    NS_TEST_ASSERT_MSG_EQ(m_cache->GetHits() - hits, 2, "A 2-way set should hold two of the three lines");
+    NS_TEST_ASSERT_MSG_EQ(m_cache->GetWritebacks(), 0, "Clean victims are not written back");
+    Simulator::Destroy();
+}
+
+void HbmCacheTest::TestWriteThrough()
+{
+    CreateCache("Lru", "WriteThrough", 4);
+    Access(NanoSeconds(0), 1, 0, true);
+    Access(MicroSeconds(1), 2, 0, false);
+    Access(MicroSeconds(2), 3, 0, true);
+    Simulator::Run();
+    NS_TEST_ASSERT_MSG_EQ(m_cache->GetMisses(), 2, "A write miss should not allocate the line");
+    NS_TEST_ASSERT_MSG_EQ(m_cache->GetHits(), 1, "The write after the read fill should hit");
+    NS_TEST_ASSERT_MSG_EQ(m_controller->GetStats().writeBytes, 2 * LINE, "Every write should reach HBM");
+    NS_TEST_ASSERT_MSG_EQ(m_cache->GetWritebacks(), 0, "Write-through lines are never dirty");
+    NS_TEST_ASSERT_MSG_EQ(m_client.done.size(), 3, "All accesses should complete");
+    NS_TEST_ASSERT_MSG_GT(m_client.done[3], MicroSeconds(2) + NanoSeconds(5), "A write hit waits for HBM");
+    Simulator::Destroy();
+}
+
+void HbmCacheTest::TestMshrStall()
+{
+    CreateCache("Lru", "WriteBack", 2);
+    Access(NanoSeconds(0), 1, 0, false);
+    Access(NanoSeconds(0), 2, LINE, false);
+    Simulator::Run();
+    Time parallel = m_client.done[2];
+    Simulator::Destroy();
+
+    CreateCache("Lru", "WriteBack", 1);
+    Access(NanoSeconds(0), 1, 0, false);
+    Access(NanoSeconds(0), 2, LINE, false);      // waits for the only MSHR
+    Simulator::Run();
+    NS_TEST_ASSERT_MSG_EQ(m_cache->GetMisses(), 2, "Both lines should miss");
+    NS_TEST_ASSERT_MSG_EQ(m_client.done.size(), 2, "The stalled miss should complete");
+    NS_TEST_ASSERT_MSG_GT(m_client.done[2], m_client.done[1], "The stalled fill starts after the first one");
+    NS_TEST_ASSERT_MSG_GT(m_client.done[2], parallel, "A full MSHR file should delay the miss");
+    Simulator::Destroy();
+}
+
+void HbmCacheTest::DoRun()
+{
+    TestHitMissMerge();
+    TestDirtyWriteback();
+    TestRandomReplacement();
+    TestWriteThrough();
+    TestMshrStall();
+    m_cache = nullptr;
+    m_controller = nullptr;
+}
+
+/**
+ * @brief CBFC credit batching conservation test
+ *
+ * Two hosts exchange traffic through one switch with CbfcCreditBatching and a
+ * control-frame grain that does not divide the packet cells. Samples every
+ * port's m_crdTxfree while traffic runs and checks that it never exceeds
+ * CbfcInitCreditCell, and that all credit is back once the links are idle.
+ */
+class UbCbfcCreditBatchingTest : public TestCase
+{
+public:
+    UbCbfcCreditBatchingTest();
+    void DoRun() override;
+
+private:
+    void DoTeardown() override;
+    void WriteFile(const std::string &name, const std::vector<std::string> &lines);
+    std::vector<Ptr<UbCbfc>> GetCbfcs();
+    void CheckCredits();
+
+    int32_t m_initCredit = 64;
+    int32_t m_maxTxfree = 0;
+    uint32_t m_samples = 0;
+};
+
+UbCbfcCreditBatchingTest::UbCbfcCreditBatchingTest()
+    : TestCase("UnifiedBus - CBFC credit batching never over-credits")
+{
+}
+
+void UbCbfcCreditBatchingTest::DoTeardown()
+{
+    Config::Reset();
+}
+
+void UbCbfcCreditBatchingTest::WriteFile(const std::string &name, const std::vector<std::string> &lines)
+{
+    std::ofstream file(CreateTempDirFilename(name));
+    for (auto &line : lines) {
+        file << line << "\n";
+    }
+}
+
+std::vector<Ptr<UbCbfc>> UbCbfcCreditBatchingTest::GetCbfcs()
+{
+    std::vector<Ptr<UbCbfc>> cbfcs;
+    for (uint32_t nodeId = 0; nodeId < NodeList::GetNNodes(); nodeId++) {
+        Ptr<Node> node = NodeList::GetNode(nodeId);
+        for (uint32_t portId = 0; portId < node->GetNDevices(); portId++) {
+            Ptr<UbPort> port = DynamicCast<UbPort>(node->GetDevice(portId));
+            Ptr<UbCbfc> cbfc = port != nullptr ? DynamicCast<UbCbfc>(port->GetFlowControl()) : nullptr;
+            if (cbfc != nullptr) {
+                cbfcs.push_back(cbfc);
+            }
+        }
+    }
+    return cbfcs;
+}
+
+void UbCbfcCreditBatchingTest::CheckCredits()
+{
+    for (auto &cbfc : GetCbfcs()) {
+        for (uint8_t vl = 0; vl < 16; vl++) {
+            m_maxTxfree = std::max(m_maxTxfree, cbfc->GetCrdTxfree(vl));
+        }
+    }
+    m_samples++;
+    Simulator::Schedule(NanoSeconds(5), &UbCbfcCreditBatchingTest::CheckCredits, this);
+}
+
+void UbCbfcCreditBatchingTest::DoRun()
+{
+    // 主机0和1经交换机2互发, 控制帧粒度8 cell, 捎带粒度2 cell
+    WriteFile("node.csv", {"nodeId,nodeType,portNum,forwardDelay",
+                           "0..1,DEVICE,1,1ns",
+                           "2,SWITCH,2,1ns"});
+    WriteFile("topology.csv", {"nodeId1,portId1,nodeId2,portId2,bandwidth,delay",
+                               "0,0,2,0,400Gbps,20ns",
+                               "1,0,2,1,400Gbps,20ns"});
+    WriteFile("routing_table.csv", {"nodeId,dstNodeId,dstPortId,outPorts,metrics",
+                                    "0,1,0,0,1",
+                                    "1,0,0,0,1",
+                                    "2,0,0,0,1", "2,1,0,1,1"});
+    WriteFile("transport_channel.csv", {"nodeId1,portId1,tpn1,nodeId2,portId2,tpn2,priority,metric",
+                                        "0,0,0,1,0,0,7,1"});
+    // 与死锁用例的taskId错开, UbTrafficGen为单例
+    WriteFile("traffic.csv", {"taskId,sourceNode,destNode,dataSize(Byte),opType,priority,delay,phaseId,dependOnPhases",
+                              "10,0,1,300000,URMA_WRITE,7,10ns,10,",
+                              "11,1,0,100000,URMA_WRITE,7,10ns,10,"});
+    WriteFile("network_attribute.txt", {"default ns3::UbPort::UbDataRate \"400Gbps\"",
+                                        "default ns3::UbPort::CbfcFlitLenByte \"20\"",
+                                        "default ns3::UbPort::CbfcFlitsPerCell \"4\"",
+                                        "default ns3::UbPort::CbfcRetCellGrainDataPacket \"2\"",
+                                        "default ns3::UbPort::CbfcRetCellGrainControlPacket \"8\"",
+                                        "default ns3::UbPort::CbfcCreditBatching \"true\"",
+                                        "default ns3::UbPort::CbfcCreditFlushGrains \"2\"",
+                                        "default ns3::UbPort::CbfcInitCreditCell \"" + std::to_string(m_initCredit) + "\"",
+                                        "default ns3::UbSwitch::EnableCBFC \"true\"",
+                                        "default ns3::UbSwitch::EnablePFC \"false\"",
+                                        "default ns3::UbTransportChannel::EnableRetrans \"false\"",
+                                        "global UB_FAULT_ENABLE \"false\"",
+                                        "global UB_PRIORITY_NUM \"16\"",
+                                        "global UB_VL_NUM \"16\"",
+                                        "global UB_CC_ENABLED \"false\"",
+                                        "global UB_TRACE_ENABLE \"false\"",
+                                        "global UB_FC_MONITOR_ENABLE \"false\""});
+
+    RngSeedManager::SetSeed(10);
+    auto ubUtils = utils::UbUtils::Get();
+    ubUtils->SetComponentsAttribute(CreateTempDirFilename("network_attribute.txt"));
+    ubUtils->CreateTraceDir();
+    ubUtils->CreateNode(CreateTempDirFilename("node.csv"));
+    ubUtils->CreateTopo(CreateTempDirFilename("topology.csv"));
+    ubUtils->AddRoutingTable(CreateTempDirFilename("routing_table.csv"));
+    auto connectionManager = ubUtils->CreateTp(CreateTempDirFilename("transport_channel.csv"));
+    for (auto &record : ubUtils->ReadTrafficCSV(CreateTempDirFilename("traffic.csv"))) {
+        auto node = NodeList::GetNode(record.sourceNode);
+        if (node->GetNApplications() == 0) {
+            node->AddApplication(CreateObject<UbApp>());
+        }
+        UbTrafficGen::Get()->AddTask(record);
+        DynamicCast<UbApp>(node->GetApplication(0))
+            ->GetTpnConn(connectionManager.GetConnectionManagerByNode(record.sourceNode));
+    }
+    UbTrafficGen::Get()->ScheduleNextTasks();
+    Simulator::ScheduleNow(&UbCbfcCreditBatchingTest::CheckCredits, this);
+
+    // 采样事件一直运行, 以固定时长结束仿真, 远大于流完成时间
+    Simulator::Stop(MicroSeconds(100));
+    Simulator::Run();
+
+    NS_TEST_ASSERT_MSG_EQ(UbTrafficGen::Get()->IsCompleted(), true, "Both flows should finish");
+    NS_TEST_ASSERT_MSG_GT(m_samples, 0, "Credits should be sampled");
+    NS_TEST_ASSERT_MSG_LT_OR_EQ(m_maxTxfree, m_initCredit, "m_crdTxfree exceeded CbfcInitCreditCell");
+    auto cbfcs = GetCbfcs();
+    NS_TEST_ASSERT_MSG_EQ(cbfcs.size(), 4, "Every port should run CBFC");
+    for (auto &cbfc : cbfcs) {
+        for (uint8_t vl = 0; vl < 16; vl++) {
+            NS_TEST_ASSERT_MSG_EQ(cbfc->GetCrdTxfree(vl), m_initCredit,
+                                  "All credit of VL " << unsigned(vl) << " should be returned once idle");
+        }
+    }
+
+    ubUtils->Destroy();
+    Simulator::Destroy();
+}
+
+/**
+ * @brief Flow-control deadlock detection test
+ *
+ * Three switches form a ring with clockwise routing and small CBFC credit, and
+ * every host sends to the host two hops away, so each inter-switch buffer waits
+ * for the next one. Checks that UbFcMonitor reports this cycle exactly once,
+ * only after the buffers stayed blocked for DeadlockThreshold, and that the
+ * reported cycle consists of the three ring buffers.
+ */
+class UbFcMonitorDeadlockTest : public TestCase
+{
+public:
+    UbFcMonitorDeadlockTest();
+    void DoRun() override;
+
+private:
+    void DoTeardown() override;
+    void WriteFile(const std::string &name, const std::vector<std::string> &lines);
+    void OnDeadlock(std::string cycle);
+
+    std::vector<std::string> m_cycles;
+    Time m_detectTime;
+};
+
+UbFcMonitorDeadlockTest::UbFcMonitorDeadlockTest()
+    : TestCase("UnifiedBus - Flow-control deadlock detection on a ring")
+{
+}
+
+void UbFcMonitorDeadlockTest::DoTeardown()
+{
+    Config::Reset();
+}
+
+void UbFcMonitorDeadlockTest::WriteFile(const std::string &name, const std::vector<std::string> &lines)
+{
+    std::ofstream file(CreateTempDirFilename(name));
+    for (auto &line : lines) {
+        file << line << "\n";
+    }
+}
+
+void UbFcMonitorDeadlockTest::OnDeadlock(std::string cycle)
+{
+    m_cycles.push_back(cycle);
+    m_detectTime = Simulator::Now();
+}
+
+void UbFcMonitorDeadlockTest::DoRun()
+{
+    // 主机0..2各连一台交换机3..5, 交换机成环且全部顺时针路由(3->4->5->3)
+    WriteFile("node.csv", {"nodeId,nodeType,portNum,forwardDelay",
+                           "0..2,DEVICE,1,1ns",
+                           "3..5,SWITCH,3,1ns"});
+    WriteFile("topology.csv", {"nodeId1,portId1,nodeId2,portId2,bandwidth,delay",
+                               "0,0,3,0,400Gbps,20ns",
+                               "1,0,4,0,400Gbps,20ns",
+                               "2,0,5,0,400Gbps,20ns",
+                               "3,1,4,2,100Gbps,20ns",
+                               "4,1,5,2,100Gbps,20ns",
+                               "5,1,3,2,100Gbps,20ns"});
+    WriteFile("routing_table.csv", {"nodeId,dstNodeId,dstPortId,outPorts,metrics",
+                                    "0,1,0,0,1", "0,2,0,0,1",
+                                    "1,0,0,0,1", "1,2,0,0,1",
+                                    "2,0,0,0,1", "2,1,0,0,1",
+                                    "3,0,0,0,1", "3,1,0,1,1", "3,2,0,1,1",
+                                    "4,0,0,1,1", "4,1,0,0,1", "4,2,0,1,1",
+                                    "5,0,0,1,1", "5,1,0,1,1", "5,2,0,0,1"});
+    WriteFile("transport_channel.csv", {"nodeId1,portId1,tpn1,nodeId2,portId2,tpn2,priority,metric",
+                                        "0,0,0,2,0,0,7,1",
+                                        "1,0,0,0,0,1,7,1",
+                                        "2,0,1,1,0,1,7,1"});
+    // 每条流都跨两段环链路
+    WriteFile("traffic.csv", {"taskId,sourceNode,destNode,dataSize(Byte),opType,priority,delay,phaseId,dependOnPhases",
+                              "0,0,2,20000000,URMA_WRITE,7,10ns,0,",
+                              "1,1,0,20000000,URMA_WRITE,7,10ns,0,",
+                              "2,2,1,20000000,URMA_WRITE,7,10ns,0,"});
+    WriteFile("network_attribute.txt", {"default ns3::UbPort::UbDataRate \"400Gbps\"",
+                                        "default ns3::UbPort::CbfcFlitLenByte \"20\"",
+                                        "default ns3::UbPort::CbfcFlitsPerCell \"4\"",
+                                        "default ns3::UbPort::CbfcRetCellGrainDataPacket \"2\"",
+                                        "default ns3::UbPort::CbfcRetCellGrainControlPacket \"2\"",
+                                        "default ns3::UbPort::CbfcInitCreditCell \"128\"",
+                                        "default ns3::UbSwitch::EnableCBFC \"true\"",
+                                        "default ns3::UbSwitch::EnablePFC \"false\"",
+                                        "default ns3::UbTransportChannel::EnableRetrans \"false\"",
+                                        "default ns3::UbSwitchAllocator::AllocationTime \"+10ns\"",
+                                        "global UB_FAULT_ENABLE \"false\"",
+                                        "global UB_PRIORITY_NUM \"16\"",
+                                        "global UB_VL_NUM \"16\"",
+                                        "global UB_CC_ENABLED \"false\"",
+                                        "global UB_TRACE_ENABLE \"false\"",
+                                        "global UB_FC_MONITOR_ENABLE \"false\""});
+
+    RngSeedManager::SetSeed(10);
+    auto ubUtils = utils::UbUtils::Get();
+    ubUtils->SetComponentsAttribute(CreateTempDirFilename("network_attribute.txt"));
+    ubUtils->CreateTraceDir();
+    ubUtils->CreateNode(CreateTempDirFilename("node.csv"));
+    ubUtils->CreateTopo(CreateTempDirFilename("topology.csv"));
+    ubUtils->AddRoutingTable(CreateTempDirFilename("routing_table.csv"));
+    auto connectionManager = ubUtils->CreateTp(CreateTempDirFilename("transport_channel.csv"));
+    for (auto &record : ubUtils->ReadTrafficCSV(CreateTempDirFilename("traffic.csv"))) {
+        auto node = NodeList::GetNode(record.sourceNode);
+        if (node->GetNApplications() == 0) {
+            node->AddApplication(CreateObject<UbApp>());
+        }
+        UbTrafficGen::Get()->AddTask(record);
+        DynamicCast<UbApp>(node->GetApplication(0))
+            ->GetTpnConn(connectionManager.GetConnectionManagerByNode(record.sourceNode));
+    }
+    UbTrafficGen::Get()->ScheduleNextTasks();
+
+    const Time threshold = MicroSeconds(50);
+    Ptr<UbFcMonitor> monitor = CreateObject<UbFcMonitor>();
+    monitor->SetAttribute("CheckInterval", TimeValue(MicroSeconds(10)));
+    monitor->SetAttribute("DeadlockThreshold", TimeValue(threshold));
+    monitor->TraceConnectWithoutContext("DeadlockDetected",
+                                        MakeCallback(&UbFcMonitorDeadlockTest::OnDeadlock, this));
+    monitor->Start();
+
+    // 死锁后不再有报文事件, 检测器周期检查会一直运行, 以固定时长结束仿真
+    Simulator::Stop(MicroSeconds(500));
+    Simulator::Run();
+
+    NS_TEST_ASSERT_MSG_EQ(m_cycles.size(), 1, "The ring deadlock should be reported exactly once");
+    NS_TEST_ASSERT_MSG_EQ(monitor->GetDeadlockCount(), 1, "Deadlock count");
+    NS_TEST_ASSERT_MSG_GT_OR_EQ(m_detectTime, threshold, "Buffers must stay blocked for DeadlockThreshold first");
+    NS_TEST_ASSERT_MSG_EQ(UbTrafficGen::Get()->IsCompleted(), false, "The deadlocked flows cannot finish");
+    if (!m_cycles.empty()) {
+        const std::string &cycle = m_cycles.front();
+        for (const char *buffer : {"(node 3 port 1 vl 7", "(node 4 port 1 vl 7", "(node 5 port 1 vl 7"}) {
+            NS_TEST_ASSERT_MSG_NE(cycle.find(buffer), std::string::npos, "Cycle should contain " << buffer);
+        }
+        NS_TEST_ASSERT_MSG_EQ(cycle.find("port 0"), std::string::npos, "Host-facing ports are not in the cycle");
+    }
+
+    monitor = nullptr;
+    ubUtils->Destroy();
+    Simulator::Destroy();
+}
+
 /**
  * @brief Unified-bus test suite
  */
@@ -100,6 +711,11 @@ UbTestSuite::UbTestSuite()
     : TestSuite("unified-bus", Type::UNIT)
 {
     AddTestCase(new UbFunctionalityTest(), TestCase::Duration::QUICK);
+    AddTestCase(new UbAddressMapTest(), TestCase::Duration::QUICK);
+    AddTestCase(new UbCna24HeaderTest(), TestCase::Duration::QUICK);
+    AddTestCase(new HbmCacheTest(), TestCase::Duration::QUICK);
+    AddTestCase(new UbCbfcCreditBatchingTest(), TestCase::Duration::QUICK);
+    AddTestCase(new UbFcMonitorDeadlockTest(), TestCase::Duration::QUICK);
 }
 
 // Register the test suite